@@ -29,6 +29,7 @@
  * - Board type
  * - Mechanism type
  * - Extruders number
+ * - Junction deviation
  *
  * Mechanisms-settings can be found in Configuration_Xxxxxx.h (where Xxxxxx can be: Cartesian - Delta - Core - Scara)
  * Temperature settings can be found in Configuration_Temperature.h
@@ -87,6 +88,28 @@
 // every couple of seconds when it can't accept commands.
 #define HOST_KEEPALIVE_FEATURE        // Disable this if your host doesn't like keepalive messages
 #define DEFAULT_KEEPALIVE_INTERVAL 2  // Number of seconds between "busy" messages. Set with M113.
+
+//
+// Auto Report
+//
+// When enabled the host can ask MarlinKimbra to send temperature (M155)
+// and position (M154) reports at a fixed interval instead of polling
+// with M105 and M114, which take a slot in the command queue each time.
+// With AUTO_REPORT_BINARY "M155 B1" replaces the temperature text line
+// with a compact binary frame holding temperatures, heater PWM, planner
+// fill, position and SD progress, protected by a Fletcher-16 checksum.
+//#define AUTO_REPORT
+//#define AUTO_REPORT_BINARY
+
+//
+// Binary G-code
+//
+// After "M160 S1" the host may send commands as compact binary packets
+// with a sequence number and CRC16 instead of ASCII lines with N and *.
+// Acknowledge and resend work as for ASCII. A host side encoder is in
+// scripts/binary_gcode.py.
+//#define BINARY_GCODE
+#define BINARY_GCODE_TIMEOUT 200      // Milliseconds to wait for the rest of a packet before asking to resend
 /***********************************************************************/
 
 
@@ -152,4 +175,25 @@
 #define DRIVER_EXTRUDERS 1
 /***********************************************************************/
 
+
+/***********************************************************************
+ ************************* Junction deviation **************************
+ ***********************************************************************
+ *                                                                     *
+ * Use the junction deviation cornering model instead of the classic   *
+ * XY/Z/E jerk limits to compute the speed at which the planner may    *
+ * pass through the junction between two moves. The maximum junction   *
+ * speed follows from the angle between the two moves and from the     *
+ * acceleration, as a centripetal acceleration around a circle that    *
+ * deviates JUNCTION_DEVIATION_MM from the corner.                     *
+ *                                                                     *
+ * Set the deviation with M205 J and save it with M500.                *
+ *                                                                     *
+ * Uncomment JUNCTION_DEVIATION to enable this feature                 *
+ *                                                                     *
+ ***********************************************************************/
+//#define JUNCTION_DEVIATION
+#define JUNCTION_DEVIATION_MM 0.02  // (mm) Distance from the real junction edge
+/***********************************************************************/
+
 #endif
@@ -63,6 +63,7 @@
  * - Filament Runout sensor
  * - Power consumption sensor
  * - Flow sensor
+ * - ADC DMA capture
  * ADDON FEATURES:
  * - EEPROM
  * - SDCARD
@@ -77,6 +78,13 @@
  * - Stepper auto deactivation
  * - Low speed stepper
  * - High speed stepper
+ * - Adaptive step smoothing
+ * - S-Curve acceleration
+ * - Input shaping
+ * - Step event queue
+ * - Step port batching
+ * - Block preparation interrupt
+ * - ISR profiling
  * - Microstepping
  * - Motor's current
  * - I2C DIGIPOT
@@ -900,6 +908,28 @@
 /**************************************************************************/
 
 
+/**************************************************************************
+ **************************** ADC DMA capture *****************************
+ **************************************************************************
+ *                                                                        *
+ * The ADC scans all temperature, filament width and power consumption    *
+ * channels in free run and the PDC copies every tagged sample into a     *
+ * ring buffer. The temperature interrupt only drains the new samples,    *
+ * each window drops the highest and lowest sample of every channel,      *
+ * averages the rest and a median of the last windows gives the value.    *
+ * PID and the MIN/MAX checks run ADC_DMA_UPDATE_FREQUENCY times a        *
+ * second instead of every 63 ms: retune PID after enabling it.           *
+ *                                                                        *
+ * Uncomment ADC_DMA to enable this feature                               *
+ *                                                                        *
+ **************************************************************************/
+//#define ADC_DMA
+
+#define ADC_DMA_UPDATE_FREQUENCY 50 // Hz - new temperature values per second [16 - 1000]
+#define ADC_DMA_MEDIAN            5 // Windows in the median filter, odd [1 - 9]
+/**************************************************************************/
+
+
 //===========================================================================
 //============================= ADDON FEATURES ==============================
 //===========================================================================
@@ -930,6 +960,13 @@
 //#define SDSLOW              // Use slower SD transfer mode (not normally needed - uncomment if you're getting volume init error)
 //#define SDEXTRASLOW         // Use even slower SD transfer mode (not normally needed - uncomment if you're getting volume init error)
 //#define SD_CHECK_AND_RETRY  // Use CRC checks and retries on the SD communication
+//#define SD_EXTENT_MAP 16    // Map the printing file as up to this many runs of clusters when it's opened, reads then skip the FAT lookups
+//#define SD_SPI_DMA          // Use DMA for SD block transfers and read the next block of the printing file in the background (hardware SPI only)
+//#define SD_BINARY_PRINT     // Print binary print files made with scripts/binary_print.py, with tokenized commands and a layer index
+//#define SD_BINARY_UPLOAD    // M28 B<size> <file> receives the file as binary frames with CRC and writes it with multi-block writes, see scripts/sd_upload.py
+#define SD_UPLOAD_BLOCKS 8    // 512 byte blocks buffered by SD_BINARY_UPLOAD before each write
+//#define SD_DIR_INDEX 64     // Keep the listing of the current folder, up to this many entries, in RAM for the LCD and Nextion file menus. It's read again only after a folder change or a write
+#define SD_DIR_INDEX_SORT 1   // Order of SD_DIR_INDEX: 0 as on the card, 1 by name, 2 newest first. Sorted listings show folders first
 //#define SD_EXTENDED_DIR     // Show extended directory including file length. Don't use this with Pronterface
 
 // Decomment this if you are external SD without DETECT_PIN
@@ -1241,9 +1278,179 @@
  *                                                                     *
  * Activate for very high stepping rates, normally only needed for 1/64*
  * or more micro steps (AXIS_STEPS_PER_UNIT * MAX_FEEDRATE > 150,000)  *
+ * Above DOUBLE_STEP_FREQUENCY the stepper interrupt takes 2 steps,    *
+ * above twice that rate 4 steps.                                      *
  *                                                                     *
  ***********************************************************************/
 //#define ENABLE_HIGH_SPEED_STEPPING
+#define DOUBLE_STEP_FREQUENCY 90000   // (Hz)
+#define HIGH_SPEED_PULSE_WIDTH 1      // (us) Step pulse width when more steps are taken in one interrupt
+/***********************************************************************/
+
+
+/***********************************************************************
+ ********************** Adaptive step smoothing ************************
+ ***********************************************************************
+ *                                                                     *
+ * Adaptive Multi-Axis Step Smoothing (AMASS). Below                   *
+ * AMASS_CUTOFF_FREQUENCY every step event of the leading axis is      *
+ * split in 2 interrupts, in 4 below half that rate and so on up to    *
+ * 2^AMASS_MAX_LEVEL. The other axes are traced at the interrupt rate, *
+ * so their steps are placed evenly instead of on the leading axis     *
+ * grid: smoother motion and quieter drivers at low speed.             *
+ * At high rates one step per interrupt is taken, use it instead of    *
+ * ENABLE_HIGH_SPEED_STEPPING to avoid bursts of steps.                *
+ *                                                                     *
+ * Not compatible with ENABLE_HIGH_SPEED_STEPPING, STEP_EVENT_QUEUE,   *
+ * LASERBEAM and COLOR_MIXING_EXTRUDER.                                *
+ *                                                                     *
+ * Uncomment ADAPTIVE_STEP_SMOOTHING to enable this feature            *
+ *                                                                     *
+ ***********************************************************************/
+//#define ADAPTIVE_STEP_SMOOTHING
+#define AMASS_MAX_LEVEL 3             // Up to 2^3 = 8 interrupts per step event
+#define AMASS_CUTOFF_FREQUENCY 8000   // (Hz) Step rate below which the first level starts
+/***********************************************************************/
+
+
+/***********************************************************************
+ *********************** S-Curve acceleration **************************
+ ***********************************************************************
+ *                                                                     *
+ * The stepper follows a jerk limited velocity profile instead of the  *
+ * trapezoid. Speed goes from entry to cruise rate and from cruise to  *
+ * exit rate along a 5th order Bezier curve, so acceleration ramps up  *
+ * and down smoothly instead of jumping at the start and the end of    *
+ * each acceleration phase. This reduces ringing and lets you raise    *
+ * the acceleration settings.                                          *
+ *                                                                     *
+ * Uncomment S_CURVE_ACCELERATION to enable this feature               *
+ *                                                                     *
+ ***********************************************************************/
+//#define S_CURVE_ACCELERATION
+/***********************************************************************/
+
+
+/***********************************************************************
+ *************************** Input shaping *****************************
+ ***********************************************************************
+ *                                                                     *
+ * Reduce the ringing of the X and Y axes by convolving the commanded  *
+ * steps with a train of impulses tuned on the resonant frequency of   *
+ * each axis. The X and Y steps are then emitted by a dedicated timer  *
+ * interrupt running at SHAPING_ISR_FREQUENCY, so the maximum X and Y  *
+ * step rate is half of that frequency. The planner slows down moves   *
+ * that would step X or Y faster.                                      *
+ * The step buffer is sized for the longest delay, the damped period   *
+ * at SHAPING_MIN_FREQ: lower it only if you have the RAM for it.      *
+ *                                                                     *
+ * SHAPER_ZV  - 2 impulses, shortest delay (half a period)             *
+ * SHAPER_ZVD - 3 impulses, more robust to frequency errors (1 period) *
+ * SHAPER_MZV - 3 impulses, in between (3/4 of a period)               *
+ * SHAPER_NONE or a frequency of 0 disables shaping on that axis.      *
+ *                                                                     *
+ * Shaper, frequency and damping of each axis can be changed with      *
+ * M593 and saved in EEPROM with M500.                                 *
+ * Only for Cartesian and Core machines.                               *
+ *                                                                     *
+ * Uncomment INPUT_SHAPING to enable this feature                      *
+ *                                                                     *
+ ***********************************************************************/
+//#define INPUT_SHAPING
+#define SHAPING_TYPE_X SHAPER_ZVD
+#define SHAPING_TYPE_Y SHAPER_ZVD
+#define SHAPING_FREQ_X 40.0           // (Hz) Resonant frequency of the X axis
+#define SHAPING_FREQ_Y 40.0           // (Hz) Resonant frequency of the Y axis
+#define SHAPING_ZETA_X 0.1            // Damping ratio of the X axis (0 - 0.5)
+#define SHAPING_ZETA_Y 0.1            // Damping ratio of the Y axis (0 - 0.5)
+#define SHAPING_MIN_FREQ 20.0         // (Hz) Lowest frequency accepted by M593
+#define SHAPING_ISR_FREQUENCY 40000   // (Hz) Rate of the X and Y step output interrupt
+/***********************************************************************/
+
+
+/***********************************************************************
+ ************************** Step event queue ***************************
+ ***********************************************************************
+ *                                                                     *
+ * Move the Bresenham tracer and the acceleration math out of the      *
+ * stepper interrupt. The main loop (idle) turns the planned blocks    *
+ * into step events (motors to step and time to the next event) and    *
+ * the stepper interrupt only plays them back, so its duration does    *
+ * not depend on the block any more and higher step rates are reached. *
+ *                                                                     *
+ * At most STEP_EVENT_QUEUE_MS of motion is computed ahead, so blocks  *
+ * are not frozen for replanning earlier than needed. When the main    *
+ * loop stalls and less than half of it is left, the queue is refilled *
+ * from the PendSV exception, below the stepper interrupt.             *
+ *                                                                     *
+ * Not compatible with ADVANCE, LIN_ADVANCE, LASERBEAM,                *
+ * COLOR_MIXING_EXTRUDER, INPUT_SHAPING and Z_LATE_ENABLE.             *
+ *                                                                     *
+ * Uncomment STEP_EVENT_QUEUE to enable this feature                   *
+ *                                                                     *
+ ***********************************************************************/
+//#define STEP_EVENT_QUEUE
+#define STEP_EVENT_QUEUE_SIZE 1024    // Step events, must be a power of 2
+#define STEP_EVENT_QUEUE_MS 20        // (ms) Motion computed ahead of the stepper interrupt
+#define STEP_EVENT_PULSE_WIDTH 1      // (us) Minimum step pulse width of the drivers
+/***********************************************************************/
+
+
+/***********************************************************************
+ ************************* Step port batching **************************
+ ***********************************************************************
+ *                                                                     *
+ * Output the step pulses of one interrupt with a single write per     *
+ * PIO controller. Port and bit of every step pin are taken from the   *
+ * board's pin map at compile time, the interrupt collects the pins    *
+ * stepping this tick and writes PIO_SODR/PIO_CODR once per port, so   *
+ * axes wired to the same port start and end their pulses together.   *
+ *                                                                     *
+ * Not compatible with DUAL_X_CARRIAGE, Z_DUAL_ENDSTOPS and            *
+ * ENABLE_HIGH_SPEED_STEPPING. With INPUT_SHAPING X and Y are still    *
+ * output by the shaping interrupt.                                    *
+ *                                                                     *
+ * Uncomment STEP_PORT_BATCHING to enable this feature                 *
+ *                                                                     *
+ ***********************************************************************/
+//#define STEP_PORT_BATCHING
+/***********************************************************************/
+
+
+/***********************************************************************
+ ******************** Block preparation interrupt **********************
+ ***********************************************************************
+ *                                                                     *
+ * Compute the timer intervals and rates of the next block in a low    *
+ * priority interrupt (PendSV) while the current block is stepped.     *
+ * When the block starts the stepper interrupt only copies the         *
+ * prepared state, so the first step of each block is not delayed.     *
+ * Useful with the short segments of delta kinematics.                 *
+ *                                                                     *
+ * Not compatible with STEP_EVENT_QUEUE, which prepares the blocks     *
+ * in the main loop.                                                   *
+ *                                                                     *
+ * Uncomment BLOCK_PREPARATION_ISR to enable this feature              *
+ *                                                                     *
+ ***********************************************************************/
+//#define BLOCK_PREPARATION_ISR
+/***********************************************************************/
+
+
+/***********************************************************************
+ **************************** ISR profiling ****************************
+ ***********************************************************************
+ *                                                                     *
+ * Measure the stepper, advance, shaping and temperature interrupts    *
+ * with the DWT cycle counter of the Cortex-M3. M124 reports calls,    *
+ * min/avg/max cycles per call, missed deadlines and the share of the  *
+ * CPU spent in each interrupt, M124 R resets the counters.            *
+ * Use it to size microstepping and max feedrate of the machine.       *
+ *                                                                     *
+ * Uncomment ISR_PROFILING to enable this feature                      *
+ *                                                                     *
+ ***********************************************************************/
+//#define ISR_PROFILING
 /***********************************************************************/
 
 
@@ -1447,7 +1654,8 @@
  ************************************** Buffer stuff ************************************
  ****************************************************************************************/
 // The number of linear motions that can be in the plan at any give time.
-// THE BLOCK BUFFER SIZE NEEDS TO BE A POWER OF 2, i.g. 8,16,32 because shifts and ors are used to do the ring-buffering.
+// THE BLOCK BUFFER SIZE NEEDS TO BE A POWER OF 2, i.g. 8,16,32,64,128 because shifts and ors are used to do the ring-buffering.
+// The look-ahead only replans the blocks that can still change, so bigger buffers don't slow down the planner.
 #define BLOCK_BUFFER_SIZE 32 // maximize block buffer
 
 //The ASCII buffer for receiving from the serial:
@@ -1465,6 +1673,15 @@
 #define ARC_SUPPORT  // Disabling this saves ~2738 bytes
 #define MM_PER_ARC_SEGMENT 1
 #define N_ARC_CORRECTION 25
+// Uncomment ARC_CHORD_TOLERANCE to pick the segment length from the maximum distance
+// between the arc and its chords instead of MM_PER_ARC_SEGMENT. Tight arcs get short
+// segments, large arcs get long ones. Segments are never shorter than the distance
+// covered in DEFAULT_MINSEGMENTTIME at the current feedrate, so the planner isn't flooded.
+// The tolerance can be changed with M215 T<mm>
+//#define ARC_CHORD_TOLERANCE
+#define ARC_CHORD_TOLERANCE_MM 0.01   // (mm) Maximum chord error
+#define MIN_ARC_SEGMENT_MM 0.1        // (mm) Shortest segment
+#define MAX_ARC_SEGMENT_MM 2.0        // (mm) Longest segment
 
 // Moves with fewer segments than this will be ignored and joined with the next movement
 #define MIN_SEGMENTS_FOR_MOVE 6
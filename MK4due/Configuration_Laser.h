@@ -67,6 +67,8 @@
 #define LASER_MAX_RASTER_LINE 68      // Maximum number of base64 encoded pixels per raster gcode command
 #define LASER_RASTER_ASPECT_RATIO 1   // pixels aren't square on most displays, 1.33 == 4:3 aspect ratio. 
 #define LASER_RASTER_MM_PER_PULSE 0.2 // Can be overridden by providing an R value in M649 command : M649 S17 B2 D0 R0.1 F4000
+#define LASER_RASTER_LINES 32         // Raster lines kept in the pool shared by the planner blocks, BLOCK_BUFFER_SIZE or less. G7 waits for a free line when all are in use.
+                                      // A bigger BLOCK_BUFFER_SIZE deepens the look-ahead without more raster RAM, but raster moves still only look ahead over this many G7 lines
 
 // Uncomment the following if the laser cutter is equipped with a peripheral relay board
 // to control power to an exhaust fan, cooler pump, laser power supply, etc.
@@ -75,6 +77,10 @@
 
 // Uncomment the following line to enable cubic bezier curve movement with the G5 code
 // #define G5_BEZIER
+// The curve is split adaptively: segments are made as long as possible while the curve stays
+// within BEZIER_FLATNESS_MM of them, but never shorter than what the planner can execute in
+// DEFAULT_MINSEGMENTTIME at the current feedrate
+#define BEZIER_FLATNESS_MM 0.01   // (mm) Maximum distance between the curve and its segments
 
 // Uncomment these options for the Buildlog.net laser cutter, and other similar models
 #define LASER_WATTS 40.0
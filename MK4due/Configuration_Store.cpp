@@ -38,7 +38,7 @@
 
 #include "base.h"
 
-#define EEPROM_VERSION "MKV28"
+#define EEPROM_VERSION "MKV31"
 #define EEPROM_OFFSET 100
 
 /**
@@ -59,6 +59,8 @@
  *  M205  X               planner.max_xy_jerk (float)
  *  M205  Z               planner.max_z_jerk (float)
  *  M205  E   E0 ...      planner.max_e_jerk (float x6)
+ *  M205  J               planner.junction_deviation_mm (float)
+ *  M593  XY  T F D       stepper.shaping_type (uint8 x2), shaping_frequency (float x2), shaping_zeta (float x2)
  *  M206  XYZ             home_offset (float x3)
  *  M218  T   XY          hotend_offset (float x6)
  *
@@ -105,6 +107,11 @@
  *  M301  E3  PIDC        Kp[3], Ki[3], Kd[3], Kc[3] (float x4)
  *  M301  L               lpq_len
  *
+ * MPCTEMP:
+ *  M307  H0  PCRAFK      mpc[0] heater_power, block_heat_capacity, sensor_responsiveness,
+ *                        ambient_xfer_coeff_fan0, fan255_adjustment, filament_heat_capacity_permm (float x6)
+ *  M307  H1..H3          mpc[1..3] (float x6)
+ *
  * PIDTEMPBED:
  *  M304      PID         bedKp, bedKi, bedKd (float x3)
  * PIDTEMPCHAMBER
@@ -189,6 +196,10 @@ void Config_Postprocess() {
 
   calculate_volumetric_multipliers();
 
+  #if ENABLED(INPUT_SHAPING)
+    stepper.refresh_shaping();
+  #endif
+
   // Software endstops depend on home_offset
   LOOP_XYZ(i) update_software_endstops((AxisEnum)i);
 }
@@ -226,6 +237,22 @@ void Config_StoreSettings() {
   EEPROM_WRITE(planner.max_xy_jerk);
   EEPROM_WRITE(planner.max_z_jerk);
   EEPROM_WRITE(planner.max_e_jerk);
+  #if ENABLED(JUNCTION_DEVIATION)
+    EEPROM_WRITE(planner.junction_deviation_mm);
+  #else
+    dummy = 0.0f;
+    EEPROM_WRITE(dummy);
+  #endif
+  #if ENABLED(INPUT_SHAPING)
+    EEPROM_WRITE(stepper.shaping_type);
+    EEPROM_WRITE(stepper.shaping_frequency);
+    EEPROM_WRITE(stepper.shaping_zeta);
+  #else
+    uint8_t dummy_shaping_type[2] = { 0 };
+    EEPROM_WRITE(dummy_shaping_type);
+    dummy = 0.0f;
+    for (uint8_t q = 0; q < 4; q++) EEPROM_WRITE(dummy);
+  #endif
   EEPROM_WRITE(home_offset);
   EEPROM_WRITE(hotend_offset);
 
@@ -293,6 +320,13 @@ void Config_StoreSettings() {
     int lpq_len = 20;
   #endif
   EEPROM_WRITE(lpq_len);
+
+  #if ENABLED(MPCTEMP)
+    for (int8_t h = 0; h < HOTENDS; h++) EEPROM_WRITE(mpc[h]);
+  #else
+    dummy = 0.0f;
+    for (int8_t q = 0; q < HOTENDS * 6; q++) EEPROM_WRITE(dummy);
+  #endif
   
   #if ENABLED(PIDTEMPBED)
     EEPROM_WRITE(bedKp);
@@ -407,6 +441,20 @@ void Config_RetrieveSettings() {
     EEPROM_READ(planner.max_xy_jerk);
     EEPROM_READ(planner.max_z_jerk);
     EEPROM_READ(planner.max_e_jerk);
+    #if ENABLED(JUNCTION_DEVIATION)
+      EEPROM_READ(planner.junction_deviation_mm);
+    #else
+      EEPROM_READ(dummy);
+    #endif
+    #if ENABLED(INPUT_SHAPING)
+      EEPROM_READ(stepper.shaping_type);
+      EEPROM_READ(stepper.shaping_frequency);
+      EEPROM_READ(stepper.shaping_zeta);
+    #else
+      uint8_t dummy_shaping_type[2];
+      EEPROM_READ(dummy_shaping_type);
+      for (uint8_t q = 0; q < 4; q++) EEPROM_READ(dummy);
+    #endif
     EEPROM_READ(home_offset);
     EEPROM_READ(hotend_offset);
 
@@ -471,6 +519,12 @@ void Config_RetrieveSettings() {
     #endif
     EEPROM_READ(lpq_len);
 
+    #if ENABLED(MPCTEMP)
+      for (int8_t h = 0; h < HOTENDS; h++) EEPROM_READ(mpc[h]);
+    #else
+      for (int8_t q = 0; q < HOTENDS * 6; q++) EEPROM_READ(dummy);
+    #endif
+
     #if ENABLED(PIDTEMPBED)
       EEPROM_READ(bedKp);
       EEPROM_READ(bedKi);
@@ -612,6 +666,17 @@ void Config_ResetDefault() {
   planner.min_travel_feedrate_mm_s = DEFAULT_MINTRAVELFEEDRATE;
   planner.max_xy_jerk = DEFAULT_XYJERK;
   planner.max_z_jerk = DEFAULT_ZJERK;
+  #if ENABLED(JUNCTION_DEVIATION)
+    planner.junction_deviation_mm = JUNCTION_DEVIATION_MM;
+  #endif
+  #if ENABLED(INPUT_SHAPING)
+    stepper.shaping_type[X_AXIS] = SHAPING_TYPE_X;
+    stepper.shaping_type[Y_AXIS] = SHAPING_TYPE_Y;
+    stepper.shaping_frequency[X_AXIS] = SHAPING_FREQ_X;
+    stepper.shaping_frequency[Y_AXIS] = SHAPING_FREQ_Y;
+    stepper.shaping_zeta[X_AXIS] = SHAPING_ZETA_X;
+    stepper.shaping_zeta[Y_AXIS] = SHAPING_ZETA_Y;
+  #endif
   home_offset[X_AXIS] = home_offset[Y_AXIS] = home_offset[Z_AXIS] = 0;
 
   #if ENABLED(MESH_BED_LEVELING)
@@ -689,6 +754,26 @@ void Config_ResetDefault() {
     coolerKd = scalePID_d(DEFAULT_coolerKd);
   #endif
 
+  #if ENABLED(MPCTEMP)
+    {
+      const float mpc_power[] = MPC_HEATER_POWER,
+                  mpc_capacity[] = MPC_BLOCK_HEAT_CAPACITY,
+                  mpc_responsiveness[] = MPC_SENSOR_RESPONSIVENESS,
+                  mpc_fan0[] = MPC_AMBIENT_XFER_COEFF,
+                  mpc_fan255[] = MPC_AMBIENT_XFER_COEFF_FAN255,
+                  mpc_filament[] = MPC_FILAMENT_HEAT_CAPACITY_PERMM;
+      for (int8_t h = 0; h < HOTENDS; h++) {
+        mpc[h].heater_power = mpc_power[h];
+        mpc[h].block_heat_capacity = mpc_capacity[h];
+        mpc[h].sensor_responsiveness = mpc_responsiveness[h];
+        mpc[h].ambient_xfer_coeff_fan0 = mpc_fan0[h];
+        mpc[h].fan255_adjustment = mpc_fan255[h] - mpc_fan0[h];
+        mpc[h].filament_heat_capacity_permm = mpc_filament[h];
+      }
+      reset_mpc_model();
+    }
+  #endif
+
   #if ENABLED(FWRETRACT)
     autoretract_enabled = false;
     retract_length = RETRACT_LENGTH;
@@ -778,12 +863,19 @@ void Config_PrintSettings(bool forReplay) {
     }
   #endif
 
-  CONFIG_MSG_START("Advanced variables: S=Min feedrate (mm/s), V=Min travel feedrate (mm/s), B=minimum segment time (ms), X=maximum XY jerk (mm/s),  Z=maximum Z jerk (mm/s),  E=maximum E jerk (mm/s)");
+  #if ENABLED(JUNCTION_DEVIATION)
+    CONFIG_MSG_START("Advanced variables: S=Min feedrate (mm/s), V=Min travel feedrate (mm/s), B=minimum segment time (ms), X=maximum XY jerk (mm/s),  Z=maximum Z jerk (mm/s),  E=maximum E jerk (mm/s),  J=junction deviation (mm)");
+  #else
+    CONFIG_MSG_START("Advanced variables: S=Min feedrate (mm/s), V=Min travel feedrate (mm/s), B=minimum segment time (ms), X=maximum XY jerk (mm/s),  Z=maximum Z jerk (mm/s),  E=maximum E jerk (mm/s)");
+  #endif
   SERIAL_SMV(CFG, "  M205 S", planner.min_feedrate_mm_s );
   SERIAL_MV(" V", planner.min_travel_feedrate_mm_s );
   SERIAL_MV(" B", planner.min_segment_time );
   SERIAL_MV(" X", planner.max_xy_jerk );
   SERIAL_MV(" Z", planner.max_z_jerk);
+  #if ENABLED(JUNCTION_DEVIATION)
+    SERIAL_MV(" J", planner.junction_deviation_mm, 3);
+  #endif
   SERIAL_EMV(" E", planner.max_e_jerk[0]);
   #if (EXTRUDERS > 1)
     for(int8_t i = 1; i < EXTRUDERS; i++) {
@@ -792,6 +884,16 @@ void Config_PrintSettings(bool forReplay) {
     }
   #endif
 
+  #if ENABLED(INPUT_SHAPING)
+    CONFIG_MSG_START("Input shaping: T=Type (0=None 1=ZV 2=ZVD 3=MZV), F=Frequency (Hz), D=Damping ratio");
+    SERIAL_SMV(CFG, "  M593 X T", (int)stepper.shaping_type[X_AXIS]);
+    SERIAL_MV(" F", stepper.shaping_frequency[X_AXIS]);
+    SERIAL_EMV(" D", stepper.shaping_zeta[X_AXIS], 3);
+    SERIAL_SMV(CFG, "  M593 Y T", (int)stepper.shaping_type[Y_AXIS]);
+    SERIAL_MV(" F", stepper.shaping_frequency[Y_AXIS]);
+    SERIAL_EMV(" D", stepper.shaping_zeta[Y_AXIS], 3);
+  #endif
+
   CONFIG_MSG_START("Home offset (mm):");
   SERIAL_SMV(CFG, "  M206 X", home_offset[X_AXIS] );
   SERIAL_MV(" Y", home_offset[Y_AXIS] );
@@ -918,6 +1020,19 @@ void Config_PrintSettings(bool forReplay) {
     #endif
   #endif
 
+  #if ENABLED(MPCTEMP)
+    CONFIG_MSG_START("MPC settings: P=Heater power (W) C=Heat capacity (J/K) R=Sensor responsiveness A=Ambient losses F=Losses at fan 255 (W/K) K=Filament heat capacity (J/K/mm)");
+    for (int8_t h = 0; h < HOTENDS; h++) {
+      SERIAL_SMV(CFG, "  M307 H", h);
+      SERIAL_MV(" P", mpc[h].heater_power);
+      SERIAL_MV(" C", mpc[h].block_heat_capacity);
+      SERIAL_MV(" R", mpc[h].sensor_responsiveness, 4);
+      SERIAL_MV(" A", mpc[h].ambient_xfer_coeff_fan0, 4);
+      SERIAL_MV(" F", mpc[h].ambient_xfer_coeff_fan0 + mpc[h].fan255_adjustment, 4);
+      SERIAL_EMV(" K", mpc[h].filament_heat_capacity_permm, 4);
+    }
+  #endif
+
   #if ENABLED(FWRETRACT)
     CONFIG_MSG_START("Retract: S=Length (mm) F:Speed (mm/m) Z: ZLift (mm)");
     SERIAL_SMV(CFG, "  M207 S", retract_length);
@@ -33,6 +33,7 @@
  * - Redundant thermistor
  * - Temperature status LEDs
  * - PID Settings - HOTEND
+ * - MPC Settings - HOTEND
  * - PID Settings - BED
  * - PID Settings - CHAMBER
  * - PID Settings - COOLER
@@ -281,6 +282,41 @@
 /***********************************************************************/
 
 
+/***********************************************************************
+ ********************** MPC Settings - HOTEND **************************
+ ***********************************************************************
+ *                                                                     *
+ * Model predictive control of the hotends in place of PID.            *
+ * A thermal model of heater block and sensor (heater power, heat      *
+ * capacity, losses to the ambient with the fan off and at 255) is     *
+ * run along the real temperature, and the heater power is the one     *
+ * the model needs to hold the target. The filament fed by the running *
+ * planner block and the part fan speed go in as feed-forward, so the  *
+ * heater reacts before the temperature drops.                         *
+ *                                                                     *
+ * M307 H<hotend> T [S<temperature>] measures the model of a hotend,   *
+ * M307 H<hotend> P C R A F K sets it, M500 saves it.                  *
+ *                                                                     *
+ * Comment PIDTEMP and uncomment MPCTEMP to enable this feature        *
+ *                                                                     *
+ ***********************************************************************/
+//#define MPCTEMP
+
+//                         HotEnd{HE0,HE1,HE2,HE3}
+#define MPC_HEATER_POWER                  {40.0, 40.0, 40.0, 40.0}          // W - heater cartridge power
+#define MPC_BLOCK_HEAT_CAPACITY           {16.7, 16.7, 16.7, 16.7}          // J/K - heater block with nozzle
+#define MPC_SENSOR_RESPONSIVENESS         {0.22, 0.22, 0.22, 0.22}          // K/s per K of difference between block and sensor
+#define MPC_AMBIENT_XFER_COEFF            {0.068, 0.068, 0.068, 0.068}      // W/K - losses with the part fan off
+#define MPC_AMBIENT_XFER_COEFF_FAN255     {0.097, 0.097, 0.097, 0.097}      // W/K - losses with the part fan at 255
+#define MPC_FILAMENT_HEAT_CAPACITY_PERMM  {5.6e-3, 5.6e-3, 5.6e-3, 5.6e-3}  // J/K/mm - 1.75 mm PLA, 0.0149 for 2.85 mm PLA
+
+#define MPC_SMOOTHING_FACTOR    0.5   // Share of the model error corrected at each update [0.0 - 1.0]
+#define MPC_MIN_AMBIENT_CHANGE  1.0   // K/s - smallest correction of the modeled ambient temperature
+#define MPC_STEADYSTATE         0.5   // K - the ambient temperature is corrected only this close to the target
+#define MPC_TUNING_TEMP         200   // Default temperature for M307 T
+/***********************************************************************/
+
+
 /***********************************************************************
  ************************ PID Settings - BED ***************************
  ***********************************************************************
@@ -52,6 +52,7 @@
 #include "src/sanitycheck.h"
 #include "src/HAL/HAL.h"
 #include "src/communication/communication.h"
+#include "src/communication/parser.h"
 #include "src/enum.h"
 
 #if ENABLED(MESH_BED_LEVELING)
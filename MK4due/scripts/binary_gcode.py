@@ -0,0 +1,333 @@
+#!/usr/bin/env python3
+
+""" Encode G-code into the binary packets accepted by MK4due with BINARY_GCODE.
+
+Packet layout (all values little-endian), see get_serial_commands() in MK_Main.cpp:
+
+  0xC5      sync
+  uint16    sequence, the low 16 bits of the line number
+  uint8     payload length
+  payload   opcode, then parameters
+  uint16    CRC-16/CCITT (0x1021, initial 0xFFFF) of sequence, length and payload
+
+Opcode bits 7-6 select G, M, T or plain ASCII text, bits 5-0 hold the code
+number (63 = a varint follows). Each parameter is a byte with the letter in
+bits 4-0 and the value type in bits 7-5: 0 none, 1 integer, 2-5 fixed point
+with that many decimals, followed by the value as a zigzag varint.
+
+  binary_gcode.py test FILE              round-trip every line, check the firmware decoder built
+                                         for the host (test/decode_test) and print the size saving
+  binary_gcode.py send FILE PORT [BAUD]  stream FILE to the printer (needs pyserial)
+"""
+
+import os
+import re
+import subprocess
+import sys
+
+SYNC = 0xC5
+OP_ASCII = 0xC0
+LETTERS = 'GMT'
+MAX_CMD_SIZE = 96
+TEST_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'test')
+TEXT_MCODES = (23, 28, 29, 30, 32, 33, 117, 928)  # M-codes with a file name or message, always sent as text
+
+_code_re = re.compile(r'^([GMT])\s*(\d+)\s*(.*)$')
+_param_re = re.compile(r'\s*([A-Z])\s*([-+]?(?:\d+\.?\d*|\.\d+))?')
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+  for b in data:
+    crc ^= b << 8
+    for _ in range(8):
+      crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+      crc &= 0xFFFF
+  return crc
+
+
+def varint(val):
+  out = bytearray()
+  while True:
+    b = val & 0x7F
+    val >>= 7
+    if val:
+      out.append(b | 0x80)
+    else:
+      out.append(b)
+      return out
+
+
+def zigzag(val):
+  return (val << 1) if val >= 0 else ((-val - 1) << 1) | 1
+
+
+def clean_line(line):
+  """ Strip the comment and surrounding spaces, as the firmware does. """
+  return line.split(';', 1)[0].strip()
+
+
+def encode_params(rest):
+  """ Encode the parameters, or return None if they aren't plain letter/number pairs. """
+  out = bytearray()
+  pos = 0
+  rest = rest.rstrip()
+  while pos < len(rest):
+    m = _param_re.match(rest, pos)
+    if not m or m.end() == pos:
+      return None
+    pos = m.end()
+    letter = ord(m.group(1)) - ord('A')
+    text = m.group(2)
+    if text is None:
+      out.append(letter)
+      continue
+    decimals = len(text.split('.')[1]) if '.' in text else 0
+    if decimals == 0:
+      vtype, scale = 1, 1
+    else:
+      vtype = min(max(decimals, 2), 5)
+      scale = 10 ** vtype
+    value = int(round(float(text) * scale))
+    if not -(1 << 31) <= value < (1 << 31):
+      return None
+    out.append(letter | (vtype << 5))
+    out += varint(zigzag(value))
+  return out
+
+
+def encode_payload(line):
+  m = _code_re.match(line)
+  params = None
+  if m and not (m.group(1) == 'M' and int(m.group(2)) in TEXT_MCODES):
+    params = encode_params(m.group(3))
+  if params is None:
+    text = line.encode('ascii')
+    if len(text) > min(254, MAX_CMD_SIZE - 1):
+      raise ValueError('command too long: ' + line)
+    return bytearray([OP_ASCII]) + text
+  code = LETTERS.index(m.group(1))
+  num = int(m.group(2))
+  out = bytearray()
+  if num < 63:
+    out.append((code << 6) | num)
+  else:
+    out.append((code << 6) | 63)
+    out += varint(num)
+  return out + params
+
+
+def encode_packet(line, seq):
+  payload = encode_payload(line)
+  if len(payload) > 255:
+    raise ValueError('packet too long: ' + line)
+  body = bytearray([seq & 0xFF, (seq >> 8) & 0xFF, len(payload)]) + payload
+  crc = crc16_ccitt(body)
+  return bytes(bytearray([SYNC]) + body + bytearray([crc & 0xFF, crc >> 8]))
+
+
+def decode_packet(packet):
+  """ Python mirror of the firmware decoder, returns (sequence, ASCII command). """
+  if packet[0] != SYNC:
+    raise ValueError('no sync')
+  seq = packet[1] | (packet[2] << 8)
+  length = packet[3]
+  payload = packet[4:4 + length]
+  crc = packet[4 + length] | (packet[5 + length] << 8)
+  if crc16_ccitt(packet[1:4 + length]) != crc:
+    raise ValueError('bad crc')
+
+  op = payload[0]
+  if op >> 6 == 3:
+    return seq, payload[1:].decode('ascii')
+
+  pos = 1
+
+  def read_varint():
+    nonlocal pos
+    val, shift = 0, 0
+    while True:
+      b = payload[pos]
+      pos += 1
+      val |= (b & 0x7F) << shift
+      shift += 7
+      if not b & 0x80:
+        return val
+
+  num = op & 0x3F
+  if num == 63:
+    num = read_varint()
+  cmd = LETTERS[op >> 6] + str(num)
+  while pos < len(payload):
+    param = payload[pos]
+    pos += 1
+    letter, vtype = param & 0x1F, param >> 5
+    cmd += ' ' + chr(ord('A') + letter)
+    if not vtype:
+      continue
+    zz = read_varint()
+    neg = zz & 1
+    mag = (zz >> 1) + neg
+    if vtype > 1:
+      digits = str(mag).rjust(vtype + 1, '0')
+      text = digits[:-vtype] + '.' + digits[-vtype:]
+    else:
+      text = str(mag)
+    cmd += ('-' if neg else '') + text
+  if len(cmd) > MAX_CMD_SIZE - 1:
+    raise ValueError('command too long')
+  return seq, cmd
+
+
+def ascii_line(line, n):
+  """ The ASCII line a host would send for comparison, with N and checksum. """
+  text = 'N%d %s' % (n, line)
+  checksum = 0
+  for c in text:
+    checksum ^= ord(c)
+  return '%s*%d\n' % (text, checksum)
+
+
+def interpret(line):
+  """ Code and the first value of each letter, as code_seen() sees them. """
+  m = _code_re.match(line)
+  if not m:
+    return line
+  values = {}
+  for p in _param_re.finditer(m.group(3)):
+    if p.group(1) not in values:
+      values[p.group(1)] = float(p.group(2)) if p.group(2) else None
+  return (m.group(1), int(m.group(2)), values)
+
+
+def same(a, b):
+  if type(a) != type(b) or not isinstance(a, tuple):
+    return a == b
+  if a[:2] != b[:2] or a[2].keys() != b[2].keys():
+    return False
+  for k, v in a[2].items():
+    w = b[2][k]
+    if (v is None) != (w is None) or (v is not None and abs(v - w) > 5e-6 * max(1, abs(v))):
+      return False
+  return True
+
+
+def firmware_decode(requests):
+  """ Run the requests through test/decode_test, the firmware parser and decoder
+  built for the host, and return one (line, code, number, values) per request. """
+  subprocess.check_call(['make', '-s', '-C', TEST_DIR, 'build/decode_test'])
+  proc = subprocess.Popen([os.path.join(TEST_DIR, 'build', 'decode_test')],
+                          stdin=subprocess.PIPE, stdout=subprocess.PIPE, universal_newlines=True)
+  out = proc.communicate('\n'.join(requests) + '\n')[0]
+  results = []
+  for reply in out.splitlines():
+    fields = reply.split('\t')
+    if len(fields) != 4:
+      results.append(reply)
+      continue
+    line, code, num, letters = fields
+    values = {}
+    for item in letters.split():
+      values[item[0]] = float(item[2:])
+    results.append((line, code, None if num == '-' else int(num), values))
+  if len(results) != sum(1 for r in requests if r != 'R'):
+    raise ValueError('decode_test stopped after %d results' % len(results))
+  return results
+
+
+def firmware_same(expected, decoded, result, values=True):
+  """ Compare a decode_test result with the line the firmware should queue and,
+  unless values is False, with the parameters of the expected command. """
+  if not isinstance(result, tuple) or result[0] != decoded:
+    return False
+  want = interpret(expected)
+  if not isinstance(want, tuple):
+    return True
+  if not values:
+    return result[1:3] == want[:2]
+  # A letter without a value reads as 0
+  return same((want[0], want[1], dict((k, 0.0 if v is None else v) for k, v in want[2].items())), result[1:])
+
+
+def test(path):
+  ascii_bytes = binary_bytes = lines = 0
+  checks, requests = [], []
+  with open(path) as f:
+    for n, raw in enumerate(f, 1):
+      line = clean_line(raw)
+      if not line:
+        continue
+      packet = encode_packet(line, lines + 1)
+      seq, decoded = decode_packet(packet)
+      if seq != (lines + 1) & 0xFFFF or not same(interpret(line), interpret(decoded)):
+        print('%s:%d: round trip mismatch\n  %s\n  %s' % (path, n, line, decoded))
+        return 1
+      # The firmware must queue the decoded line, and parse it as the ASCII line
+      checks.append((n, line, decoded, packet[4] >> 6 != 3))
+      requests.append('A ' + line)
+      requests.append('P ' + ''.join('%02x' % b for b in bytearray(packet[4:-2])))
+      lines += 1
+      ascii_bytes += len(ascii_line(line, lines))
+      binary_bytes += len(packet)
+  results = firmware_decode(requests)
+  for i, (n, line, decoded, tokenized) in enumerate(checks):
+    ascii, binary = results[2 * i:2 * i + 2]
+    if not firmware_same(line, line, ascii, tokenized) or not firmware_same(line, decoded, binary, tokenized) \
+       or not same(ascii[1:], binary[1:]):
+      print('%s:%d: firmware decodes differently\n  %s\n  %s\n  %s' % (path, n, line, ascii, binary))
+      return 1
+  print('%d commands, ASCII %d bytes, binary %d bytes (%.2fx)'
+        % (lines, ascii_bytes, binary_bytes, float(ascii_bytes) / max(1, binary_bytes)))
+  return 0
+
+
+def send(path, port, baud):
+  import serial
+
+  link = serial.Serial(port, baud, timeout=10)
+
+  def reply(expect=None):
+    # Wait for "ok", returning the line number of a "Resend:" seen before it
+    resend, found = None, expect is None
+    while True:
+      line = link.readline().decode('ascii', 'replace').strip()
+      if not line:
+        raise IOError('no reply from printer')
+      if line.startswith('Resend:'):
+        resend = int(line.split(':')[1])
+      elif line.startswith('ok'):
+        if not found:
+          raise IOError('printer has no binary G-code support')
+        return resend
+      elif line == expect:
+        found = True
+      else:
+        print(line)
+
+  link.write(b'M160 S1\n')
+  reply('BINARY_GCODE:1')
+
+  with open(path) as f:
+    commands = [c for c in (clean_line(l) for l in f) if c]
+  commands.insert(0, 'M110')
+
+  i = 0
+  while i < len(commands):
+    link.write(encode_packet(commands[i], i))
+    resend = reply()
+    if resend is None:
+      i += 1
+    else:
+      # The firmware asks again from the line after the last good one
+      i = resend
+  link.write(encode_packet('M160 S0', i))
+  reply()
+  return 0
+
+
+if __name__ == '__main__':
+  if len(sys.argv) == 3 and sys.argv[1] == 'test':
+    sys.exit(test(sys.argv[2]))
+  if len(sys.argv) in (4, 5) and sys.argv[1] == 'send':
+    sys.exit(send(sys.argv[2], sys.argv[3], int(sys.argv[4]) if len(sys.argv) == 5 else 250000))
+  print(__doc__)
+  sys.exit(2)
@@ -0,0 +1,361 @@
+#!/usr/bin/env python3
+
+""" Convert G-code into the binary print files read by MK4due with SD_BINARY_PRINT.
+
+File layout (all values little-endian), see binary_print_header_t in cardreader.h:
+
+  header    "MKBP", version 1, header size, layer index position, layer count,
+            print time in seconds, command count, then as floats the filament
+            used, first layer height, layer height and object height
+  commands  each a length byte and a tokenized command as in binary_gcode.py,
+            where parameter type 6 is the difference from the last value of
+            the letter with its decimals. A zero length stands for '#'.
+  index     uint32 file position of the first command of each layer. No
+            parameter of that command or later ones refers to values before it.
+
+Commands are split as the firmware splits ASCII lines on SD: ';' starts a
+comment, ':' and '#' end a command as a new line does.
+
+  binary_print.py convert IN.gcode OUT.mkb   write the binary print file
+  binary_print.py test IN.gcode              convert in memory, decode every command
+                                             and every layer start, here and with the
+                                             firmware decoder (test/decode_test), and
+                                             compare to the ASCII
+  binary_print.py dump FILE.mkb              print the header and decoded commands
+"""
+
+import math
+import re
+import struct
+import sys
+
+from binary_gcode import LETTERS, MAX_CMD_SIZE, OP_ASCII, TEXT_MCODES, _code_re, _param_re, \
+                         firmware_decode, firmware_same, interpret, same, varint, zigzag
+
+MAGIC = b'MKBP'
+VERSION = 1
+HEADER = struct.Struct('<4sBBHIIIIffff')
+TYPE_DELTA = 6
+
+_layer_re = re.compile(r';\s*(LAYER:|LAYER_CHANGE|layer\s+\d)', re.IGNORECASE)
+
+
+def split_commands(text):
+  """ Yield (command, stop, layer_comment) as get_sdcard_commands() splits the file. """
+  for raw in text.splitlines():
+    code, _, comment = raw.partition(';')
+    layer = bool(comment) and _layer_re.match(';' + comment) is not None
+    parts = re.split(r'([:#])', code)
+    for i in range(0, len(parts), 2):
+      cmd = parts[i][:MAX_CMD_SIZE - 1].strip()
+      stop = i + 1 < len(parts) and parts[i + 1] == '#'
+      if cmd or stop:
+        yield cmd, stop, layer
+        layer = False
+    if layer:
+      # A comment line announcing the next layer
+      yield None, False, True
+
+
+def fixed_point(text):
+  """ (decimals, integer value) of a number, as binary_gcode.encode_params() does. """
+  decimals = len(text.split('.')[1]) if '.' in text else 0
+  if decimals:
+    decimals = min(max(decimals, 2), 5)
+  value = int(round(float(text) * 10 ** decimals))
+  if not -(1 << 31) <= value < (1 << 31):
+    return None
+  return decimals, value
+
+
+def encode_command(cmd, last):
+  """ Tokenized command, last maps a letter to (decimals, value) for delta coding. """
+  m = _code_re.match(cmd)
+  tokens = None
+  if m and not (m.group(1) == 'M' and int(m.group(2)) in TEXT_MCODES):
+    tokens = bytearray()
+    code, num = LETTERS.index(m.group(1)), int(m.group(2))
+    if num < 63:
+      tokens.append((code << 6) | num)
+    else:
+      tokens.append((code << 6) | 63)
+      tokens += varint(num)
+    pos, rest, state = 0, m.group(3).rstrip(), dict(last)
+    while pos < len(rest):
+      p = _param_re.match(rest, pos)
+      if not p or p.end() == pos:
+        tokens = None
+        break
+      pos = p.end()
+      letter = ord(p.group(1)) - ord('A')
+      if p.group(2) is None:
+        tokens.append(letter)
+        continue
+      fp = fixed_point(p.group(2))
+      if fp is None:
+        tokens = None
+        break
+      decimals, value = fp
+      absolute = varint(zigzag(value))
+      prev = state.get(letter)
+      delta = value - prev[1] if prev and prev[0] == decimals else None
+      if delta is not None and -(1 << 31) <= delta < (1 << 31) and len(varint(zigzag(delta))) <= len(absolute):
+        tokens.append(letter | (TYPE_DELTA << 5))
+        tokens += varint(zigzag(delta))
+      else:
+        tokens.append(letter | ((decimals if decimals else 1) << 5))
+        tokens += absolute
+      state[letter] = fp
+    if tokens is not None and len(tokens) <= 255:
+      try:
+        decode_command(tokens, dict(last))
+        last.clear()
+        last.update(state)
+        return tokens
+      except ValueError:
+        pass
+  return bytearray([OP_ASCII]) + cmd.encode('ascii')
+
+
+def decode_command(payload, last):
+  """ Python mirror of binary_decode_command() in MK_Main.cpp, returns the ASCII command. """
+  op = payload[0]
+  if op >> 6 == 3:
+    return payload[1:].decode('ascii')
+  pos = 1
+
+  def read_varint():
+    nonlocal pos
+    val, shift = 0, 0
+    while True:
+      if pos >= len(payload):
+        raise ValueError('truncated varint')
+      b = payload[pos]
+      pos += 1
+      val |= (b & 0x7F) << shift
+      shift += 7
+      if not b & 0x80:
+        return val
+
+  num = op & 0x3F
+  if num == 63:
+    num = read_varint()
+  cmd = LETTERS[op >> 6] + str(num)
+  while pos < len(payload):
+    param = payload[pos]
+    pos += 1
+    letter, vtype = param & 0x1F, param >> 5
+    if letter > 25 or vtype > TYPE_DELTA or (vtype == TYPE_DELTA and letter not in last):
+      raise ValueError('bad parameter')
+    cmd += ' ' + chr(ord('A') + letter)
+    if not vtype:
+      continue
+    zz = read_varint()
+    value = (zz >> 1) ^ -(zz & 1)
+    decimals = vtype if vtype > 1 else 0
+    if vtype == TYPE_DELTA:
+      decimals, value = last[letter][0], last[letter][1] + value
+    last[letter] = (decimals, value)
+    digits = str(abs(value)).rjust(decimals + 1, '0')
+    text = digits[:-decimals] + '.' + digits[-decimals:] if decimals else digits
+    cmd += ('-' if value < 0 else '') + text
+  if len(cmd) > MAX_CMD_SIZE - 1:
+    raise ValueError('command too long')
+  return cmd
+
+
+class Stats(object):
+  """ Layer starts and metadata from the ASCII commands. """
+
+  def __init__(self):
+    self.pos = {'X': 0.0, 'Y': 0.0, 'Z': 0.0, 'E': 0.0}
+    self.relative = self.relative_e = False
+    self.feedrate = 1500.0
+    self.time = self.filament = self.height = 0.0
+    self.layer_z = []
+    self.starts = []
+    self.after_extrude = 0
+
+  def command(self, index, cmd, layer_comment, use_comments):
+    if use_comments and layer_comment:
+      self.starts.append(index)
+    parsed = interpret(cmd)
+    if not isinstance(parsed, tuple):
+      return
+    code, num, values = parsed
+    if code == 'G' and num in (0, 1):
+      if values.get('F'):
+        self.feedrate = values['F']
+      dist, extruded, xy = 0.0, 0.0, False
+      for axis in 'XYZE':
+        if values.get(axis) is None:
+          continue
+        rel = self.relative_e if axis == 'E' else self.relative
+        target = self.pos[axis] + values[axis] if rel else values[axis]
+        if axis == 'E':
+          extruded = target - self.pos[axis]
+        else:
+          dist += (target - self.pos[axis]) ** 2
+          xy = xy or (axis != 'Z' and target != self.pos[axis])
+        self.pos[axis] = target
+      dist = math.sqrt(dist) or abs(extruded)
+      self.time += dist / (self.feedrate / 60.0)
+      self.filament += extruded
+      if extruded > 0 and xy:
+        # Printing, not priming or unretracting
+        z = self.pos['Z']
+        self.height = max(self.height, z)
+        if not self.layer_z or z != self.layer_z[-1]:
+          self.layer_z.append(z)
+          if not use_comments:
+            self.starts.append(self.after_extrude if self.starts else 0)
+        self.after_extrude = index + 1
+    elif code == 'G' and num == 4:
+      self.time += (values.get('P') or 0) / 1000.0 + (values.get('S') or 0)
+    elif code == 'G' and num in (90, 91):
+      self.relative = self.relative_e = (num == 91)
+    elif code == 'G' and num == 92:
+      for axis in 'XYZE':
+        if values.get(axis) is not None:
+          self.pos[axis] = values[axis]
+    elif code == 'M' and num in (82, 83):
+      self.relative_e = (num == 83)
+
+
+def convert(text):
+  """ Returns (binary file, list of (file position, ASCII command)). """
+  items = list(split_commands(text))
+  use_comments = any(layer for _, _, layer in items)
+  stats = Stats()
+  commands = []
+  pending_layer = False
+  for cmd, stop, layer in items:
+    pending_layer = pending_layer or layer
+    if cmd is None:
+      continue
+    if cmd:
+      stats.command(len(commands), cmd, pending_layer, use_comments)
+      pending_layer = False
+    commands.append((cmd, stop))
+
+  starts = sorted(set(stats.starts))
+  out = bytearray(HEADER.size)
+  positions, records = [], []
+  last = {}
+  for i, (cmd, stop) in enumerate(commands):
+    if i in starts:
+      last = {}
+    positions.append(len(out))
+    if cmd:
+      payload = encode_command(cmd, last)
+      out.append(len(payload))
+      out += payload
+      records.append((positions[-1], cmd))
+    if stop:
+      out.append(0)
+  layers = [positions[i] for i in starts if i < len(positions)]
+  index = len(out)
+  for p in layers:
+    out += struct.pack('<I', p)
+
+  z = stats.layer_z
+  out[:HEADER.size] = HEADER.pack(MAGIC, VERSION, HEADER.size, 0, index if layers else 0, len(layers),
+                                  int(round(stats.time)), len(records), stats.filament,
+                                  z[0] if z else 0.0, z[1] - z[0] if len(z) > 1 else 0.0, stats.height)
+  return bytes(out), records
+
+
+def read_file(data):
+  """ Header fields and a decoder for the records of a binary print file. """
+  fields = HEADER.unpack_from(data)
+  if fields[0] != MAGIC or fields[1] != VERSION:
+    raise ValueError('not a binary print file')
+  end = fields[4] or len(data)
+  layers = list(struct.unpack_from('<%dI' % fields[5], data, fields[4])) if fields[4] else []
+  return fields, end, layers
+
+
+def records_from(data, pos, end):
+  """ Yield (file position, tokenized command) from pos. """
+  while pos < end:
+    length = data[pos]
+    if length:
+      yield pos, bytearray(data[pos + 1:pos + 1 + length])
+    pos += 1 + length
+
+
+def decode_from(data, pos, end):
+  """ Yield (file position, ASCII command) from pos, with no delta bases, as after M26. """
+  last = {}
+  for pos, payload in records_from(data, pos, end):
+    yield pos, decode_command(payload, last)
+
+
+def test(path):
+  with open(path) as f:
+    text = f.read()
+  data, records = convert(text)
+  fields, end, layers = read_file(data)
+  decoded = list(decode_from(data, fields[2], end))
+  if len(decoded) != len(records):
+    print('%s: %d commands decoded, %d expected' % (path, len(decoded), len(records)))
+    return 1
+  for (pos, cmd), (dpos, dcmd) in zip(records, decoded):
+    if pos != dpos or not same(interpret(cmd), interpret(dcmd)):
+      print('%s: round trip mismatch at %d\n  %s\n  %s' % (path, pos, cmd, dcmd))
+      return 1
+  # Every layer start must decode on its own
+  by_pos = dict(decoded)
+  for layer, start in enumerate(layers):
+    for n, (pos, cmd) in enumerate(decode_from(data, start, end)):
+      if by_pos.get(pos) != cmd:
+        print('%s: layer %d decodes differently from its start at %d' % (path, layer, pos))
+        return 1
+      if n > 200:
+        break
+  # The firmware decoder, from the first command and from each layer start,
+  # with the delta bases cleared as when a print starts or resumes
+  ascii_by_pos = dict(records)
+  checks, requests = [], []
+  for start in [fields[2]] + layers:
+    requests.append('R')
+    for n, (pos, payload) in enumerate(records_from(data, start, end)):
+      if start != fields[2] and n > 200:
+        break
+      checks.append((pos, payload[0] >> 6 != 3))
+      requests.append('F ' + ''.join('%02x' % b for b in payload))
+  for (pos, tokenized), result in zip(checks, firmware_decode(requests)):
+    if not firmware_same(ascii_by_pos[pos], by_pos[pos], result, tokenized):
+      print('%s: firmware decodes differently at %d\n  %s\n  %s' % (path, pos, ascii_by_pos[pos], result))
+      return 1
+  ascii_bytes = len(text.encode('ascii', 'replace'))
+  print('%d commands, %d layers, ASCII %d bytes, binary %d bytes (%.2fx)'
+        % (len(records), len(layers), ascii_bytes, len(data), float(ascii_bytes) / max(1, len(data))))
+  return 0
+
+
+def dump(path):
+  with open(path, 'rb') as f:
+    data = f.read()
+  fields, end, layers = read_file(data)
+  print('layers %d, print time %d s, commands %d, filament %.1f mm' % (fields[5], fields[6], fields[7], fields[8]))
+  print('first layer %.3f mm, layer %.3f mm, height %.3f mm' % tuple(fields[9:12]))
+  starts = set(layers)
+  for pos, cmd in decode_from(data, fields[2], end):
+    print('%s%8d  %s' % ('L' if pos in starts else ' ', pos, cmd))
+  return 0
+
+
+if __name__ == '__main__':
+  if len(sys.argv) == 4 and sys.argv[1] == 'convert':
+    with open(sys.argv[2]) as f:
+      data = convert(f.read())[0]
+    with open(sys.argv[3], 'wb') as f:
+      f.write(data)
+    sys.exit(0)
+  if len(sys.argv) == 3 and sys.argv[1] == 'test':
+    sys.exit(test(sys.argv[2]))
+  if len(sys.argv) == 3 and sys.argv[1] == 'dump':
+    sys.exit(dump(sys.argv[2]))
+  print(__doc__)
+  sys.exit(2)
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+
+""" Upload a file to the SD card of MK4due with SD_BINARY_UPLOAD.
+
+The host sends "M28 B<size> <name>" and waits for "ok", then the file as
+frames (all values little-endian), see get_upload_data() in MK_Main.cpp:
+
+  0xD5      sync
+  uint16    sequence, from 0
+  uint16    payload length, 1 to 512
+  payload   file data
+  uint16    CRC-16/CCITT (0x1021, initial 0xFFFF) of sequence, length and payload
+
+Each frame is answered with "ok", or with "Resend:<sequence>" to send that
+frame again. The file is closed when the last byte arrives and the printer
+reports the time and rate of the upload.
+
+  sd_upload.py FILE PORT [BAUD] [NAME]
+"""
+
+import os
+import sys
+import time
+
+SYNC = 0xD5
+CHUNK = 512
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+  for b in data:
+    crc ^= b << 8
+    for _ in range(8):
+      crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+      crc &= 0xFFFF
+  return crc
+
+
+def encode_frame(seq, data):
+  body = bytearray([seq & 0xFF, (seq >> 8) & 0xFF, len(data) & 0xFF, len(data) >> 8]) + data
+  crc = crc16_ccitt(body)
+  return bytes(bytearray([SYNC]) + body + bytearray([crc & 0xFF, crc >> 8]))
+
+
+def rebase(seq, answer):
+  """ Frame index of a 16 bit "Resend:" sequence, the one nearest to seq. """
+  index = (seq & ~0xFFFF) | answer
+  if index > seq + 0x8000:
+    index -= 0x10000
+  elif index < seq - 0x8000:
+    index += 0x10000
+  return index
+
+
+def upload(path, port, baud, name):
+  import serial
+
+  link = serial.Serial(port, baud, timeout=2)
+
+  def reply():
+    # Wait for "ok", returning the sequence of a "Resend:" instead
+    while True:
+      line = link.readline().decode('ascii', 'replace').strip()
+      if not line:
+        return None
+      if line.startswith('ok'):
+        return True
+      if line.startswith('Resend:'):
+        return int(line.split(':')[1])
+      if line.startswith('Error:'):
+        raise IOError(line)
+      print(line)
+
+  with open(path, 'rb') as f:
+    data = f.read()
+  if not data:
+    raise ValueError('empty file')
+
+  link.write(('M28 B%d %s\n' % (len(data), name)).encode('ascii'))
+  if reply() is not True:
+    raise IOError('printer did not accept the upload')
+
+  start = time.time()
+  frames = (len(data) + CHUNK - 1) // CHUNK
+  seq = retries = 0
+  while seq < frames:
+    link.write(encode_frame(seq, bytearray(data[seq * CHUNK:(seq + 1) * CHUNK])))
+    answer = reply()
+    if answer is True:
+      seq += 1
+      retries = 0
+      continue
+    # Lost or damaged frame: wait out the frame timeout, then send it again
+    retries += 1
+    if retries > 10:
+      raise IOError('too many retries at frame %d' % seq)
+    if answer is not None:
+      index = rebase(seq, answer)
+      if not 0 <= index <= frames:
+        raise IOError('printer asked for frame %d of %d' % (index, frames))
+      seq = index
+    time.sleep(0.25)
+    link.reset_input_buffer()
+
+  # The upload summary arrives before the last "ok"
+  elapsed = time.time() - start
+  print('%d bytes in %.1f s, %.1f kB/s' % (len(data), elapsed, len(data) / 1000.0 / max(elapsed, 1e-3)))
+  return 0
+
+
+if __name__ == '__main__':
+  if len(sys.argv) in (3, 4, 5):
+    baud = int(sys.argv[3]) if len(sys.argv) > 3 else 250000
+    name = sys.argv[4] if len(sys.argv) > 4 else os.path.basename(sys.argv[1])
+    sys.exit(upload(sys.argv[1], sys.argv[2], baud, name))
+  print(__doc__)
+  sys.exit(2)
@@ -75,6 +75,25 @@ extern "C" {
   int spiDueDividors[] = {10,21,42,84,168,255,255};
 #endif
 
+#if ENABLED(ISR_PROFILING)
+  volatile isr_profile_t isr_profile[ISR_PROFILE_COUNT];
+  millis_t isr_profile_start_ms = 0;
+
+  void HAL_isr_profile_reset() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    CRITICAL_SECTION_START;
+    for (uint8_t i = 0; i < ISR_PROFILE_COUNT; i++) {
+      isr_profile[i].calls = isr_profile[i].max_cycles = isr_profile[i].missed = 0;
+      isr_profile[i].min_cycles = 0xFFFFFFFF;
+      isr_profile[i].total_cycles = 0;
+    }
+    isr_profile_start_ms = millis();
+    CRITICAL_SECTION_END;
+  }
+#endif
+
 HAL::HAL() {
   // ctor
 }
@@ -210,11 +229,113 @@ void HAL::resetHardware() {
   // --------------------------------------------------------------------------
   // hardware SPI
   // --------------------------------------------------------------------------
+  #if ENABLED(SD_SPI_DMA)
+
+    /**
+     * SPI0 has no PDC on the SAM3X, block transfers use two DMAC channels
+     * with the SPI0 hardware handshake interfaces. The DMAC writes plain
+     * bytes to TDR, so the SD chip select is fixed in the mode register
+     * for the length of the transfer and variable select is restored after.
+     */
+    #define SPI_DMAC_TX_CH    0
+    #define SPI_DMAC_RX_CH    1
+    #define SPI_TX_IDX        1
+    #define SPI_RX_IDX        2
+    #define SPI_DMA_TIMEOUT   100   // ms
+
+    static bool spi_dma_active = false,
+                spi_dma_reading = false;
+    static uint32_t spi_dma_mr;
+    static const uint8_t spi_dma_ff = 0xFF;
+
+    static void spi_dma_init() {
+      pmc_enable_periph_clk(ID_DMAC);
+      DMAC->DMAC_EN &= ~DMAC_EN_ENABLE;
+      DMAC->DMAC_GCFG = DMAC_GCFG_ARB_CFG_FIXED;
+      DMAC->DMAC_EN = DMAC_EN_ENABLE;
+    }
+
+    static void spi_dma_channel(const uint8_t ch, const uint32_t saddr, const uint32_t daddr, const uint16_t count, const uint32_t ctrlb, const uint32_t cfg) {
+      DMAC->DMAC_CHDR = DMAC_CHDR_DIS0 << ch;
+      DMAC->DMAC_CH_NUM[ch].DMAC_SADDR = saddr;
+      DMAC->DMAC_CH_NUM[ch].DMAC_DADDR = daddr;
+      DMAC->DMAC_CH_NUM[ch].DMAC_DSCR = 0;
+      DMAC->DMAC_CH_NUM[ch].DMAC_CTRLA = count | DMAC_CTRLA_SRC_WIDTH_BYTE | DMAC_CTRLA_DST_WIDTH_BYTE;
+      DMAC->DMAC_CH_NUM[ch].DMAC_CTRLB = DMAC_CTRLB_SRC_DSCR | DMAC_CTRLB_DST_DSCR | ctrlb;
+      DMAC->DMAC_CH_NUM[ch].DMAC_CFG = cfg;
+      DMAC->DMAC_CHER = DMAC_CHER_ENA0 << ch;
+    }
+
+    void (*HAL::spiDmaRelease)() = NULL;
+
+    static void spi_dma_select(const bool reading) {
+      HAL::spiDmaFinish();
+      // Don't change the mode register under a byte still shifting out
+      while ((SPI0->SPI_SR & SPI_SR_TXEMPTY) == 0);
+      spi_dma_mr = SPI0->SPI_MR;
+      SPI0->SPI_MR = (spi_dma_mr & ~(SPI_MR_PS | SPI_MR_PCS_Msk)) | SPI_PCS(SPI_CHAN);
+      // Empty the receiver and clear a stale overrun
+      SPI0->SPI_RDR;
+      SPI0->SPI_SR;
+      spi_dma_active = true;
+      spi_dma_reading = reading;
+    }
+
+    void HAL::spiDmaReadStart(uint8_t* buf, uint16_t nbyte) {
+      spi_dma_select(true);
+      spi_dma_channel(SPI_DMAC_RX_CH, (uint32_t)&SPI0->SPI_RDR, (uint32_t)buf, nbyte,
+        DMAC_CTRLB_FC_PER2MEM_DMA_FC | DMAC_CTRLB_SRC_INCR_FIXED | DMAC_CTRLB_DST_INCR_INCREMENTING,
+        DMAC_CFG_SRC_PER(SPI_RX_IDX) | DMAC_CFG_SRC_H2SEL | DMAC_CFG_SOD | DMAC_CFG_FIFOCFG_ASAP_CFG);
+      spi_dma_channel(SPI_DMAC_TX_CH, (uint32_t)&spi_dma_ff, (uint32_t)&SPI0->SPI_TDR, nbyte,
+        DMAC_CTRLB_FC_MEM2PER_DMA_FC | DMAC_CTRLB_SRC_INCR_FIXED | DMAC_CTRLB_DST_INCR_FIXED,
+        DMAC_CFG_DST_PER(SPI_TX_IDX) | DMAC_CFG_DST_H2SEL | DMAC_CFG_SOD | DMAC_CFG_FIFOCFG_ALAP_CFG);
+    }
+
+    void HAL::spiDmaSendStart(const uint8_t* buf, uint16_t nbyte) {
+      spi_dma_select(false);
+      spi_dma_channel(SPI_DMAC_TX_CH, (uint32_t)buf, (uint32_t)&SPI0->SPI_TDR, nbyte,
+        DMAC_CTRLB_FC_MEM2PER_DMA_FC | DMAC_CTRLB_SRC_INCR_INCREMENTING | DMAC_CTRLB_DST_INCR_FIXED,
+        DMAC_CFG_DST_PER(SPI_TX_IDX) | DMAC_CFG_DST_H2SEL | DMAC_CFG_SOD | DMAC_CFG_FIFOCFG_ALAP_CFG);
+    }
+
+    // Channels disable themselves when their transfer is done (DMAC_CFG_SOD)
+    bool HAL::spiDmaBusy() {
+      return spi_dma_active
+        && (DMAC->DMAC_CHSR & ((DMAC_CHSR_ENA0 << SPI_DMAC_TX_CH) | (DMAC_CHSR_ENA0 << SPI_DMAC_RX_CH)));
+    }
+
+    /**
+     * Wait for the transfer in progress, if any, and restore the
+     * mode register. Returns false on timeout or receive overrun.
+     */
+    bool HAL::spiDmaFinish() {
+      if (!spi_dma_active) return true;
+      bool ok = true;
+      const millis_t timeout_ms = millis() + SPI_DMA_TIMEOUT;
+      while (spiDmaBusy()) {
+        if (ELAPSED(millis(), timeout_ms)) {
+          DMAC->DMAC_CHDR = (DMAC_CHDR_DIS0 << SPI_DMAC_TX_CH) | (DMAC_CHDR_DIS0 << SPI_DMAC_RX_CH);
+          ok = false;
+          break;
+        }
+      }
+      // Let the last byte leave the shifter, then drop what it clocked in
+      while ((SPI0->SPI_SR & SPI_SR_TXEMPTY) == 0);
+      if (spi_dma_reading && (SPI0->SPI_SR & SPI_SR_OVRES)) ok = false;
+      SPI0->SPI_RDR;
+      SPI0->SPI_MR = spi_dma_mr;
+      spi_dma_active = false;
+      return ok;
+    }
+
+  #endif // SD_SPI_DMA
+
   #if MB(ALLIGATOR)
     bool spiInitMaded = false;
   #endif
 
   void HAL::spiBegin() {
+    spiReleaseBus();
 #if MB(ALLIGATOR)
     if(spiInitMaded == false) {
 #endif
@@ -260,6 +381,9 @@ void HAL::resetHardware() {
         g_APinDescription[SPI_PIN].ulPin,
         g_APinDescription[SPI_PIN].ulPinConfiguration);
       spiInit(1);
+      #if ENABLED(SD_SPI_DMA)
+        spi_dma_init();
+      #endif
 #if MB(ALLIGATOR)
       spiInitMaded = true;
     }
@@ -308,6 +432,15 @@ void HAL::resetHardware() {
 
   void HAL::spiSend(const uint8_t* buf, size_t n) {
     if (n == 0) return;
+    #if ENABLED(SD_SPI_DMA)
+      // Only worth the DMA setup for data blocks
+      if (n > 64) {
+        spiDmaSendStart(buf, n - 1);
+        spiDmaFinish();
+        spiSend(buf[n - 1]);
+        return;
+      }
+    #endif
     for (size_t i = 0; i < n - 1; i++) {
       SPI0->SPI_TDR = (uint32_t)buf[i] | SPI_PCS(SPI_CHAN);
       while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
@@ -320,6 +453,7 @@ void HAL::resetHardware() {
 
   void HAL::spiSend(uint32_t chan, byte b) {
     uint8_t dummy_read = 0;
+    spiReleaseBus();
     // wait for transmit register empty
     while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
     // write byte with address and end transmission flag
@@ -334,6 +468,7 @@ void HAL::resetHardware() {
   void HAL::spiSend(uint32_t chan, const uint8_t* buf, size_t n) {
     uint8_t dummy_read = 0;
     if (n == 0) return;
+    spiReleaseBus();
     for (int i = 0; i < n - 1; i++) {
       while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
       SPI0->SPI_TDR = (uint32_t)buf[i] | SPI_PCS(chan);
@@ -360,6 +495,7 @@ void HAL::resetHardware() {
 
   uint8_t HAL::spiReceive(uint32_t chan) {
     uint8_t spirec_tmp;
+    spiReleaseBus();
     // wait for transmit register empty
     while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
     while ((SPI0->SPI_SR & SPI_SR_RDRF) == 1)
@@ -378,13 +514,20 @@ void HAL::resetHardware() {
   void HAL::spiReadBlock(uint8_t*buf, uint16_t nbyte) {
     if (nbyte-- == 0) return;
 
-    for (int i = 0; i < nbyte; i++) {
-      //while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
-      SPI0->SPI_TDR = 0x000000FF | SPI_PCS(SPI_CHAN);
-      while ((SPI0->SPI_SR & SPI_SR_RDRF) == 0);
-      buf[i] = SPI0->SPI_RDR;
-      // delayMicroseconds(1);
-    }
+    #if ENABLED(SD_SPI_DMA)
+      if (nbyte) {
+        spiDmaReadStart(buf, nbyte);
+        spiDmaFinish();
+      }
+    #else
+      for (int i = 0; i < nbyte; i++) {
+        //while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
+        SPI0->SPI_TDR = 0x000000FF | SPI_PCS(SPI_CHAN);
+        while ((SPI0->SPI_SR & SPI_SR_RDRF) == 0);
+        buf[i] = SPI0->SPI_RDR;
+        // delayMicroseconds(1);
+      }
+    #endif
     buf[nbyte] = spiReceive();
   }
 
@@ -394,13 +537,18 @@ void HAL::resetHardware() {
     while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
     //while ((SPI0->SPI_SR & SPI_SR_RDRF) == 0);
     //SPI0->SPI_RDR;
-    for (int i = 0; i < 511; i++) {
-      SPI0->SPI_TDR = (uint32_t)buf[i] | SPI_PCS(SPI_CHAN);
-      while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
-      while ((SPI0->SPI_SR & SPI_SR_RDRF) == 0);
-      SPI0->SPI_RDR;
-      //        delayMicroseconds(1);
-    }
+    #if ENABLED(SD_SPI_DMA)
+      spiDmaSendStart(buf, 511);
+      spiDmaFinish();
+    #else
+      for (int i = 0; i < 511; i++) {
+        SPI0->SPI_TDR = (uint32_t)buf[i] | SPI_PCS(SPI_CHAN);
+        while ((SPI0->SPI_SR & SPI_SR_TDRE) == 0);
+        while ((SPI0->SPI_SR & SPI_SR_RDRF) == 0);
+        SPI0->SPI_RDR;
+        //        delayMicroseconds(1);
+      }
+    #endif
     spiSend(buf[511]);
   }
 
@@ -584,6 +732,9 @@ uint8_t bestClock(double frequency, uint32_t& retRC){
 #if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
   TcChannel *extruderChannel = (ADVANCE_EXTRUDER_TIMER_COUNTER->TC_CHANNEL + ADVANCE_EXTRUDER_TIMER_CHANNEL);
 #endif
+#if ENABLED(INPUT_SHAPING)
+  TcChannel *shapingChannel = (SHAPING_TIMER_COUNTER->TC_CHANNEL + SHAPING_TIMER_CHANNEL);
+#endif
 TcChannel* stepperChannel = (STEP_TIMER_COUNTER->TC_CHANNEL + STEP_TIMER_CHANNEL);
 
 void HAL_step_timer_start() {
@@ -642,6 +793,51 @@ void HAL_step_timer_start() {
   }
 #endif
 
+#if ENABLED(INPUT_SHAPING)
+  void HAL_shaping_timer_start() {
+    // Get the ISR from table
+    Tc *tc = SHAPING_TIMER_COUNTER;
+    IRQn_Type irq = SHAPING_TIMER_IRQN;
+    uint32_t channel = SHAPING_TIMER_CHANNEL;
+    uint32_t rc = 0;
+    uint8_t clock;
+
+    // Find the best clock for the wanted frequency
+    clock = bestClock(SHAPING_ISR_FREQUENCY, rc);
+
+    pmc_set_writeprotect(false); // remove write protection on registers
+    pmc_enable_periph_clk((uint32_t)irq);
+    NVIC_SetPriority(irq, 1); // same as the stepper, so they never preempt each other
+
+    tc->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKDIS;
+
+    tc->TC_CHANNEL[channel].TC_SR; // clear status register
+    tc->TC_CHANNEL[channel].TC_CMR =  TC_CMR_WAVSEL_UP_RC | TC_CMR_WAVE | clock;
+
+    tc->TC_CHANNEL[channel].TC_IER /*|*/= TC_IER_CPCS; // enable interrupt on timer match with register C
+    tc->TC_CHANNEL[channel].TC_IDR = ~TC_IER_CPCS;
+    tc->TC_CHANNEL[channel].TC_RC  = rc;
+
+    tc->TC_CHANNEL[channel].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+
+    NVIC_EnableIRQ(irq); // enable Nested Vector Interrupt Controller
+  }
+#endif
+
+#if ENABLED(BLOCK_PREPARATION_ISR)
+  void HAL_block_prep_start() {
+    // Below the stepper (1), advance (6) and shaping (1) interrupts, above the temperature one (15)
+    NVIC_SetPriority(BLOCK_PREP_IRQN, 14);
+  }
+#endif
+
+#if ENABLED(STEP_EVENT_QUEUE)
+  void HAL_step_queue_start() {
+    // Below the stepper interrupt (1), above the temperature one (15)
+    NVIC_SetPriority(BLOCK_PREP_IRQN, 14);
+  }
+#endif
+
 void HAL_temp_timer_start (uint8_t timer_num) {
 	Tc *tc = TimerConfig [timer_num].pTimerRegs;
 	IRQn_Type irq = TimerConfig [timer_num].IRQ_Id;
@@ -783,6 +979,51 @@ void stopAdcFreerun(adc_channel_num_t chan) {
   SBI(ADC->ADC_CHDR, chan);
 }
 
+#if ENABLED(ADC_DMA)
+
+  uint16_t adc_dma_buffer[ADC_DMA_BUFFER_SIZE];
+
+  /**
+   * Free run over all the channels of channel_mask, lowest channel first.
+   * ADC clock 84 MHz / 168 = 500 kHz, about 12k samples per second shared by
+   * the channels, so the ring holds 20 ms of samples.
+   */
+  void adcDmaStart(uint32_t channel_mask) {
+    pmc_enable_periph_clk(ID_ADC);
+
+    ADC->ADC_PTCR = ADC_PTCR_RXTDIS;
+    ADC->ADC_CR = ADC_CR_SWRST;
+    ADC->ADC_MR = ADC_MR_FREERUN_ON | ADC_MR_LOWRES_BITS_12 | ADC_MR_PRESCAL(83)
+                | ADC_MR_STARTUP_SUT64 | ADC_MR_SETTLING_AST17 | ADC_MR_TRACKTIM(15) | ADC_MR_TRANSFER(1);
+    ADC->ADC_EMR = ADC_EMR_TAG;
+    ADC->ADC_CHDR = 0xFFFF;
+    ADC->ADC_CHER = channel_mask;
+
+    // Current and next buffer are the same ring, ADC_Handler rearms the next one
+    ADC->ADC_RPR = (uint32_t)adc_dma_buffer;
+    ADC->ADC_RCR = ADC_DMA_BUFFER_SIZE;
+    ADC->ADC_RNPR = (uint32_t)adc_dma_buffer;
+    ADC->ADC_RNCR = ADC_DMA_BUFFER_SIZE;
+
+    ADC->ADC_IDR = 0xFFFFFFFF;
+    ADC->ADC_IER = ADC_IER_ENDRX;
+    NVIC_SetPriority(ADC_IRQn, 15);
+    NVIC_EnableIRQ(ADC_IRQn);
+
+    ADC->ADC_PTCR = ADC_PTCR_RXTEN;
+    ADC->ADC_CR = ADC_CR_START;
+  }
+
+  // The PDC moved to the next buffer: queue the ring again
+  void ADC_Handler() {
+    if (ADC->ADC_ISR & ADC_ISR_ENDRX) {
+      ADC->ADC_RNPR = (uint32_t)adc_dma_buffer;
+      ADC->ADC_RNCR = ADC_DMA_BUFFER_SIZE;
+    }
+  }
+
+#endif
+
 #if ENABLED(LASERBEAM)
   static void TC_SetCMR_ChannelA(Tc *tc, uint32_t chan, uint32_t v) {
     tc->TC_CHANNEL[chan].TC_CMR = (tc->TC_CHANNEL[chan].TC_CMR & 0xFFF0FFFF) | v;
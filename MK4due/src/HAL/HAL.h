@@ -199,6 +199,18 @@ class HAL {
       static void spiReadBlock(uint8_t* buf, uint16_t nbyte);
       // Write from buffer to SPI
       static void spiSendBlock(uint8_t token, const uint8_t* buf);
+      #if ENABLED(SD_SPI_DMA)
+        // DMA transfers on the SD channel, the caller keeps chip select low until spiDmaFinish()
+        static void spiDmaReadStart(uint8_t* buf, uint16_t nbyte);
+        static void spiDmaSendStart(const uint8_t* buf, uint16_t nbyte);
+        static bool spiDmaBusy();
+        static bool spiDmaFinish();
+        // Set by the owner of a background transfer, called before another device uses the bus
+        static void (*spiDmaRelease)();
+        static inline void spiReleaseBus() { if (spiDmaRelease) spiDmaRelease(); }
+      #else
+        static inline void spiReleaseBus() {}
+      #endif
     #endif
 
     static inline void digitalWrite(uint8_t pin, uint8_t value) {
@@ -302,6 +314,16 @@ uint8_t eeprom_read_byte(uint8_t* pos);
 #define BEEPER_TIMER_IRQN TC4_IRQn
 #define HAL_BEEPER_TIMER_ISR  void TC4_Handler()
 
+#define SHAPING_TIMER_NUM 6
+#define SHAPING_TIMER_COUNTER TC2
+#define SHAPING_TIMER_CHANNEL 0
+#define SHAPING_TIMER_IRQN TC6_IRQn
+#define HAL_SHAPING_TIMER_ISR  void TC6_Handler()
+
+// Block preparation runs on the PendSV exception, requested by software
+#define BLOCK_PREP_IRQN PendSV_IRQn
+#define HAL_BLOCK_PREP_ISR  void PendSV_Handler()
+
 #define HAL_TIMER_RATE 		     (F_CPU/2)
 #define TICKS_PER_NANOSECOND   (HAL_TIMER_RATE)/1000
 
@@ -315,8 +337,72 @@ uint8_t eeprom_read_byte(uint8_t* pos);
   extern  TcChannel *extruderChannel;
 #endif
 
+#if ENABLED(INPUT_SHAPING)
+  #define ENABLE_SHAPING_INTERRUPT()	HAL_timer_enable_interrupt (SHAPING_TIMER_NUM)
+  #define DISABLE_SHAPING_INTERRUPT()	HAL_timer_disable_interrupt (SHAPING_TIMER_NUM)
+  extern  TcChannel *shapingChannel;
+  void HAL_shaping_timer_start(void);
+#endif
+
+#if ENABLED(BLOCK_PREPARATION_ISR)
+  #define HAL_block_prep_request() (SCB->ICSR = SCB_ICSR_PENDSVSET_Msk)
+  void HAL_block_prep_start(void);
+#endif
+
+#if ENABLED(STEP_EVENT_QUEUE)
+  // The step event queue is refilled on the same exception, the two features are exclusive
+  #define HAL_STEP_QUEUE_ISR HAL_BLOCK_PREP_ISR
+  #define HAL_step_queue_request() (SCB->ICSR = SCB_ICSR_PENDSVSET_Msk)
+  void HAL_step_queue_start(void);
+#endif
+
 extern TcChannel* stepperChannel;
 
+#if ENABLED(ISR_PROFILING)
+
+  enum IsrProfileEnum {
+    ISR_PROFILE_STEPPER,
+    ISR_PROFILE_ADVANCE,
+    ISR_PROFILE_SHAPING,
+    ISR_PROFILE_TEMPERATURE,
+    ISR_PROFILE_BLOCK_PREP,
+    ISR_PROFILE_COUNT
+  };
+
+  typedef struct {
+    uint32_t calls, min_cycles, max_cycles, missed;
+    uint64_t total_cycles;
+  } isr_profile_t;
+
+  extern volatile isr_profile_t isr_profile[ISR_PROFILE_COUNT];
+  extern millis_t isr_profile_start_ms;
+
+  // Start the DWT cycle counter and clear the statistics
+  void HAL_isr_profile_reset(void);
+
+  // Core clock cycles, wraps every 51s at 84MHz
+  static FORCE_INLINE uint32_t HAL_cycles() { return DWT->CYCCNT; }
+
+  // Account one call of an interrupt. period is its deadline in cycles, 0 if not periodic
+  static FORCE_INLINE void HAL_isr_profile(const uint8_t i, const uint32_t cycles, const uint32_t period) {
+    volatile isr_profile_t &p = isr_profile[i];
+    p.calls++;
+    p.total_cycles += cycles;
+    if (cycles < p.min_cycles) p.min_cycles = cycles;
+    if (cycles > p.max_cycles) p.max_cycles = cycles;
+    if (period && cycles > period) p.missed++;
+  }
+
+  #define ISR_PROFILE_START()         const uint32_t isr_profile_start = HAL_cycles()
+  #define ISR_PROFILE_END(I, PERIOD)  HAL_isr_profile(I, HAL_cycles() - isr_profile_start, PERIOD)
+
+#else
+
+  #define ISR_PROFILE_START()         NOOP
+  #define ISR_PROFILE_END(I, PERIOD)  NOOP
+
+#endif
+
 void HAL_step_timer_start(void);
 void HAL_temp_timer_start (uint8_t timer_num);
 
@@ -332,6 +418,9 @@ int HAL_timer_get_count (uint8_t timer_num);
 static FORCE_INLINE void HAL_timer_stepper_count(uint32_t count) {
   uint32_t counter_value = stepperChannel->TC_CV + 42;  // we need time for other stuff!
   //if(count < 105) count = 105;
+  #if ENABLED(ISR_PROFILING)
+    if (counter_value > count) isr_profile[ISR_PROFILE_STEPPER].missed++; // the next step is late
+  #endif
   stepperChannel->TC_RC = (counter_value <= count) ? count : counter_value;
 }
 
@@ -346,6 +435,23 @@ uint16_t getAdcFreerun(adc_channel_num_t chan, bool wait_for_conversion = false)
 uint16_t getAdcSuperSample(adc_channel_num_t chan);
 void stopAdcFreerun(adc_channel_num_t chan);
 
+#if ENABLED(ADC_DMA)
+  // The PDC writes the ADC samples in a ring, with the channel number tagged in bits 12-15
+  #define ADC_DMA_BUFFER_SIZE 256
+  #define ADC_DMA_CHANNEL(sample) ((sample) >> 12)
+  #define ADC_DMA_VALUE(sample)   ((sample) & 0x0FFF)
+
+  extern uint16_t adc_dma_buffer[ADC_DMA_BUFFER_SIZE];
+
+  void adcDmaStart(uint32_t channel_mask);
+
+  // Index of the next sample the PDC will write
+  static FORCE_INLINE uint16_t adcDmaWriteIndex() {
+    uint16_t index = (uint16_t*)ADC->ADC_RPR - adc_dma_buffer;
+    return index < ADC_DMA_BUFFER_SIZE ? index : 0;
+  }
+#endif
+
 #if ENABLED(LASERBEAM)
   #define LASER_PWM_MAX_DUTY 255
   void HAL_laser_init_pwm(uint8_t pin, uint16_t freq);
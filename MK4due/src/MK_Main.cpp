@@ -69,6 +69,8 @@ static long gcode_N, gcode_LastN, Stopped_gcode_LastN = 0;
 
 static char command_queue[BUFSIZE][MAX_CMD_SIZE];
 static char* current_command, *current_command_args;
+
+static parsed_command_t parsed_commands[BUFSIZE], *current_parsed;
 static uint8_t  cmd_queue_index_r = 0,
                 cmd_queue_index_w = 0,
                 commands_in_queue = 0;
@@ -137,6 +139,7 @@ static int serial_count = 0;
 
 // GCode parameter pointer used by code_seen(), code_value_float(), etc.
 static char* seen_pointer;
+static uint8_t seen_letter;     // Letter index in the parsed command, 0xFF if not parsed
 
 // Next Immediate GCode Command pointer. NULL if none.
 const char* queued_commands_P = NULL;
@@ -365,6 +368,43 @@ static bool send_ok[BUFSIZE];
   #define KEEPALIVE_STATE(n) ;
 #endif // HOST_KEEPALIVE_FEATURE
 
+#if ENABLED(AUTO_REPORT)
+  // Intervals in milliseconds, 0 = disabled. Set with M155 and M154.
+  static millis_t auto_report_temp_interval = 0,
+                  next_temp_report_ms = 0,
+                  auto_report_pos_interval = 0,
+                  next_pos_report_ms = 0;
+  #if ENABLED(AUTO_REPORT_BINARY)
+    static bool auto_report_binary = false;
+  #endif
+#else
+  #define auto_report() ;
+#endif // AUTO_REPORT
+
+#if ENABLED(BINARY_GCODE)
+  #define BINARY_GCODE_SYNC     0xC5
+  #define BINARY_GCODE_HEADER   4     // Sync, sequence, length
+  #define BINARY_GCODE_MAX      (BINARY_GCODE_HEADER + 255 + 2)
+
+  static bool binary_gcode_enabled = false;   // Set with M160
+  static uint8_t binary_packet[BINARY_GCODE_MAX];
+  static uint16_t binary_count = 0;           // Bytes received of the current packet
+  static millis_t binary_packet_ms = 0;
+#endif // BINARY_GCODE
+
+#if ENABLED(SD_BINARY_UPLOAD)
+  #define UPLOAD_SYNC           0xD5
+  #define UPLOAD_HEADER         5     // Sync, sequence, length
+  #define UPLOAD_CHUNK          512   // Largest payload
+  #define UPLOAD_FRAME_TIMEOUT  200   // Milliseconds to wait for the rest of a frame
+  #define UPLOAD_TIMEOUT        10000 // Abort the upload after this long without data
+
+  static uint8_t upload_frame[UPLOAD_HEADER + UPLOAD_CHUNK + 2];
+  static uint16_t upload_count = 0,           // Bytes received of the current frame
+                  upload_seq = 0;             // Sequence of the next frame
+  static millis_t upload_frame_ms = 0;
+#endif // SD_BINARY_UPLOAD
+
 /**
  * ***************************************************************************
  * ******************************** FUNCTIONS ********************************
@@ -393,6 +433,13 @@ void safe_delay(millis_t ms) {
 
 #if ENABLED(ARC_SUPPORT)
   void plan_arc(float target[NUM_AXIS], float* offset, uint8_t clockwise);
+  #if ENABLED(ARC_CHORD_TOLERANCE)
+    float arc_chord_tolerance = ARC_CHORD_TOLERANCE_MM;
+  #endif
+#endif
+
+#if ENABLED(G5_BEZIER)
+  void plan_cubic_move(const float offset[4]);
 #endif
 
 void tool_change(const uint8_t tmp_extruder, const float fr_mm_s = 0.0, bool no_move = false);
@@ -503,9 +550,11 @@ void clear_command_queue() {
 }
 
 /**
- * Once a new command is in the ring buffer, call this to commit it
+ * Once a new command is in the ring buffer, call this to commit it.
+ * Commands decoded from binary are already parsed.
  */
-inline void _commit_command(bool say_ok) {
+inline void _commit_command(bool say_ok, bool parse = true) {
+  if (parse) parse_command(command_queue[cmd_queue_index_w], parsed_commands[cmd_queue_index_w]);
   send_ok[cmd_queue_index_w] = say_ok;
   cmd_queue_index_w = (cmd_queue_index_w + 1) % BUFSIZE;
   commands_in_queue++;
@@ -741,6 +790,10 @@ void setup() {
   // loads data from EEPROM if available else uses defaults (and resets step acceleration rate)
   Config_RetrieveSettings();
 
+  #if ENABLED(ISR_PROFILING)
+    HAL_isr_profile_reset(); // Start the cycle counter before the interrupts
+  #endif
+
   tp_init();      // Initialize temperature loop
 
   #if MECH(DELTA) || MECH(SCARA)
@@ -883,8 +936,169 @@ void gcode_line_error(const char* err, bool doFlush = true) {
   //Serial.println(gcode_N);
   if (doFlush) FlushSerialRequestResend();
   serial_count = 0;
+  #if ENABLED(BINARY_GCODE)
+    binary_count = 0;
+  #endif
 }
 
+#if ENABLED(BINARY_GCODE) || ENABLED(SD_BINARY_UPLOAD)
+  // CRC-16/CCITT, polynomial 0x1021
+  static uint16_t crc16_ccitt(const uint8_t* data, uint16_t len, uint16_t crc = 0xFFFF) {
+    while (len--) {
+      crc ^= (uint16_t)(*data++) << 8;
+      for (uint8_t i = 0; i < 8; i++)
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+    }
+    return crc;
+  }
+#endif
+
+#if ENABLED(BINARY_GCODE)
+
+  /**
+   * Binary G-code packets, enabled with M160 S1. A packet is only
+   * recognized where a new line would start, so ASCII lines can still
+   * be mixed in. All multi-byte values are little-endian.
+   *
+   *   0xC5         Sync
+   *   uint16       Sequence: the low 16 bits of the line number N
+   *   uint8        Payload length
+   *   Payload      A tokenized command, see binary_decode_command()
+   *   uint16       CRC-16/CCITT (0x1021, initial 0xFFFF) of sequence, length and payload
+   *
+   * Every packet is answered like an ASCII line with "ok", or with
+   * an error and "Resend:" through FlushSerialRequestResend().
+   */
+
+  /**
+   * Validate a complete packet and add its command to the queue
+   */
+  static void binary_process_packet() {
+    const uint16_t seq = binary_packet[1] | (binary_packet[2] << 8);
+    const uint8_t len = binary_packet[3];
+    const uint8_t* const payload = &binary_packet[BINARY_GCODE_HEADER];
+    const uint16_t crc = payload[len] | (payload[len + 1] << 8);
+
+    binary_count = 0;
+
+    if (crc16_ccitt(&binary_packet[1], BINARY_GCODE_HEADER - 1 + len) != crc) {
+      gcode_line_error(PSTR(MSG_ERR_CHECKSUM_MISMATCH));
+      return;
+    }
+
+    if (!binary_decode_command(payload, payload + len, command_queue[cmd_queue_index_w], parsed_commands[cmd_queue_index_w])) {
+      gcode_line_error(PSTR(MSG_ERR_BINARY_PACKET));
+      return;
+    }
+    const parsed_command_t &parsed = parsed_commands[cmd_queue_index_w];
+    const char code = parsed.code;
+    const uint16_t codenum = parsed.codenum;
+    const char* const command = command_queue[cmd_queue_index_w] + parsed.command;
+
+    const bool M110 = (code == 'M' && codenum == 110);
+    if (M110)
+      gcode_N = seq;
+    else {
+      gcode_N = gcode_LastN + 1;
+      if ((uint16_t)gcode_N != seq) {
+        gcode_line_error(PSTR(MSG_ERR_LINE_NO));
+        return;
+      }
+    }
+    gcode_LastN = gcode_N;
+
+    if (code == 'G' && codenum <= 3 && IsStopped()) {
+      SERIAL_LM(ER, MSG_ERR_STOPPED);
+      LCD_MESSAGEPGM(MSG_STOPPED);
+    }
+
+    // If command was e-stop process now
+    if (code == 'M' && !strchr(command, ' ')) {
+      if (codenum == 108) wait_for_heatup = false;
+      if (codenum == 112) kill(PSTR(MSG_KILLED));
+      if (codenum == 410) quickstop_stepper();
+    }
+
+    _commit_command(true, false);
+  }
+
+  /**
+   * Collect one byte of a packet, processing it once complete
+   */
+  static void binary_gcode_byte(const uint8_t c) {
+    binary_packet[binary_count++] = c;
+    binary_packet_ms = millis();
+    if (binary_count > BINARY_GCODE_HEADER
+        && binary_count == BINARY_GCODE_HEADER + binary_packet[3] + 2)
+      binary_process_packet();
+  }
+
+#endif // BINARY_GCODE
+
+#if ENABLED(SD_BINARY_UPLOAD)
+
+  /**
+   * Binary upload frames, sent after M28 B<size> <filename> until the
+   * file has its size. Values are little-endian.
+   *
+   *   0xD5         Sync
+   *   uint16       Sequence, from 0
+   *   uint16       Payload length, 1 to 512
+   *   Payload      File data
+   *   uint16       CRC-16/CCITT of sequence, length and payload
+   *
+   * A frame is answered with "ok" once it's buffered or written, or
+   * with "Resend:" and the sequence expected. Bytes between frames are
+   * dropped, so the host can send the frame again after an error.
+   */
+  static void upload_frame_done() {
+    const uint16_t seq = upload_frame[1] | (upload_frame[2] << 8),
+                   len = upload_frame[3] | (upload_frame[4] << 8);
+    const uint8_t* const payload = &upload_frame[UPLOAD_HEADER];
+    const uint16_t crc = payload[len] | (payload[len + 1] << 8);
+
+    upload_count = 0;
+    if (seq != upload_seq || crc16_ccitt(&upload_frame[1], UPLOAD_HEADER - 1 + len) != crc) {
+      SERIAL_LV(RESEND, upload_seq);
+      return;
+    }
+    if (!card.writeUpload(payload, len)) return;
+    upload_seq++;
+    SERIAL_L(OK);
+  }
+
+  inline void get_upload_data() {
+    if (ELAPSED(millis(), upload_frame_ms + (upload_count ? UPLOAD_FRAME_TIMEOUT : UPLOAD_TIMEOUT))) {
+      if (upload_count) {
+        upload_count = 0;
+        upload_frame_ms = millis();
+        SERIAL_LV(RESEND, upload_seq);
+      }
+      else
+        card.abortUpload();
+      return;
+    }
+
+    while (card.uploading && HAL::serialByteAvailable() > 0) {
+      const uint8_t c = HAL::serialReadByte();
+      if (!upload_count && c != UPLOAD_SYNC) continue;
+      upload_frame[upload_count++] = c;
+      upload_frame_ms = millis();
+      if (upload_count == UPLOAD_HEADER) {
+        const uint16_t len = upload_frame[3] | (upload_frame[4] << 8);
+        if (!len || len > UPLOAD_CHUNK) {
+          upload_count = 0;
+          SERIAL_LV(RESEND, upload_seq);
+        }
+      }
+      else if (upload_count > UPLOAD_HEADER
+          && upload_count == UPLOAD_HEADER + (upload_frame[3] | (upload_frame[4] << 8)) + 2)
+        upload_frame_done();
+    }
+  }
+
+#endif // SD_BINARY_UPLOAD
+
 inline void get_serial_commands() {
   static char serial_line_buffer[MAX_CMD_SIZE];
   static boolean serial_comment_mode = false;
@@ -900,6 +1114,19 @@ inline void get_serial_commands() {
     }
   #endif
 
+  #if ENABLED(SD_BINARY_UPLOAD)
+    if (card.uploading) {
+      get_upload_data();
+      return;
+    }
+  #endif
+
+  #if ENABLED(BINARY_GCODE)
+    // Drop a packet whose remaining bytes never arrived
+    if (binary_count && ELAPSED(millis(), binary_packet_ms + BINARY_GCODE_TIMEOUT))
+      gcode_line_error(PSTR(MSG_ERR_BINARY_PACKET));
+  #endif
+
   /**
    * Loop while serial characters are incoming and the queue is not full
    */
@@ -907,6 +1134,13 @@ inline void get_serial_commands() {
 
     char serial_char = HAL::serialReadByte();
 
+    #if ENABLED(BINARY_GCODE)
+      if (binary_count || (binary_gcode_enabled && !serial_count && (uint8_t)serial_char == BINARY_GCODE_SYNC)) {
+        binary_gcode_byte(serial_char);
+        continue;
+      }
+    #endif
+
     /**
      * If the character ends the line
      */
@@ -1028,6 +1262,40 @@ inline void get_serial_commands() {
 
     if (commands_in_queue == 0) stop_buffering = false;
 
+    #if ENABLED(SD_BINARY_PRINT)
+      if (card.binaryFile) {
+        // Tokenized commands with a length byte, a zero length stands for '#'
+        uint8_t record[255], skipped = 0;
+        while (commands_in_queue < BUFSIZE && !card.eof() && !stop_buffering && skipped < 255) {
+          int16_t n = card.get();
+          const int16_t len = n;
+          // After a seek the commands up to the position only rebuild the delta bases
+          const bool skip = card.sdpos < card.binaryResume;
+          for (uint8_t i = 0; n >= 0 && !card.eof() && i < len; i++)
+            record[i] = n = card.get();
+          if (card.eof()) break;
+          if (n < 0) {
+            SERIAL_LM(ER, MSG_SD_ERR_READ);
+            break;
+          }
+          if (skip) skipped++;
+          if (!len) {
+            if (!skip) stop_buffering = true;
+          }
+          else if (!binary_decode_command(record, record + len, command_queue[cmd_queue_index_w], parsed_commands[cmd_queue_index_w], card.binaryValue, card.binaryDecimals))
+            SERIAL_LM(ER, MSG_SD_ERR_READ);
+          else if (!skip)
+            _commit_command(false, false);
+        }
+        if (card.eof()) {
+          SERIAL_EM(MSG_FILE_PRINTED);
+          card.printingHasFinished();
+          card.checkautostart(true);
+        }
+        return;
+      }
+    #endif
+
     uint16_t sd_count = 0;
     bool card_eof = card.eof();
     while (commands_in_queue < BUFSIZE && !card_eof && !stop_buffering) {
@@ -1099,6 +1367,7 @@ inline bool code_has_value() {
 }
 
 inline float code_value_float() {
+  if (seen_letter != 0xFF) return current_parsed->value[seen_letter];
   float ret;
   char* e = strchr(seen_pointer, 'E');
   if (e) {
@@ -1189,6 +1458,13 @@ FORCE_INLINE millis_t code_value_millis() { return code_value_ulong(); }
 inline millis_t code_value_millis_from_seconds() { return code_value_float() * 1000; }
 
 bool code_seen(char code) {
+  if (code >= 'A' && code <= 'Z') {
+    seen_letter = code - 'A';
+    if (!TEST(current_parsed->letters, seen_letter)) return false;
+    seen_pointer = current_command_args + current_parsed->offset[seen_letter];
+    return true;
+  }
+  seen_letter = 0xFF;
   seen_pointer = strchr(current_command_args, code);
   return (seen_pointer != NULL); // Return TRUE if the code-letter was found
 }
@@ -3677,6 +3953,157 @@ void unknown_command_error() {
 
 #endif //HOST_KEEPALIVE_FEATURE
 
+#if ENABLED(AUTO_REPORT)
+
+  #if ENABLED(AUTO_REPORT_BINARY)
+
+    #define TELEMETRY_SYNC1 0xA5
+    #define TELEMETRY_SYNC2 0x5A
+    #define TELEMETRY_TYPE  'T'
+
+    static uint8_t* telemetry_put(uint8_t* p, const void* val, const uint8_t size) {
+      memcpy(p, val, size);
+      return p + size;
+    }
+
+    static uint8_t* telemetry_put_heater(uint8_t* p, const int8_t id, const float temp, const float target, const int power) {
+      const int16_t t = (int16_t)(temp * 10.0), tt = (int16_t)(target * 10.0);
+      const uint8_t pwm = constrain(power, 0, 255);
+      *p++ = (uint8_t)id;
+      p = telemetry_put(p, &t, sizeof(t));
+      p = telemetry_put(p, &tt, sizeof(tt));
+      *p++ = pwm;
+      return p;
+    }
+
+    /**
+     * Send the binary telemetry frame. All values are little-endian.
+     *
+     *   0xA5 0x5A    Sync
+     *   uint8        Payload length
+     *   Payload:
+     *     uint8      Frame type 'T'
+     *     uint32     millis()
+     *     uint8      Number of heater records, then for each heater:
+     *       int8     Id: 0-3 hotend, -1 bed, -2 chamber, -3 cooler
+     *       int16    Current temperature in 0.1 degC
+     *       int16    Target temperature in 0.1 degC
+     *       uint8    Heater PWM
+     *     uint8      Blocks in the planner
+     *     uint8      Planner buffer size
+     *     uint8      Commands in the command queue
+     *     int32 x4   X Y Z E position in microns
+     *     uint32     SD position in bytes (0 if not printing from SD)
+     *     uint32     SD file size in bytes
+     *   uint8 x2     Fletcher-16 sums of the length byte and payload
+     */
+    static void send_telemetry_frame() {
+      uint8_t frame[3 + 7 + (HOTENDS + 3) * 6 + 3 + 4 * 4 + 2 * 4 + 2],
+              *p = &frame[3], *count;
+
+      *p++ = TELEMETRY_TYPE;
+      const uint32_t ms = millis();
+      p = telemetry_put(p, &ms, sizeof(ms));
+
+      count = p++;
+      *count = 0;
+      #if HAS(TEMP_0) || ENABLED(HEATER_0_USES_MAX6675)
+        for (uint8_t h = 0; h < HOTENDS; h++, (*count)++)
+          p = telemetry_put_heater(p, h, degHotend(h), degTargetHotend(h), getHeaterPower(h));
+      #endif
+      #if HAS(TEMP_BED)
+        p = telemetry_put_heater(p, -1, degBed(), degTargetBed(), getBedPower());
+        (*count)++;
+      #endif
+      #if HAS(TEMP_CHAMBER)
+        p = telemetry_put_heater(p, -2, degChamber(), degTargetChamber(), getChamberPower());
+        (*count)++;
+      #endif
+      #if HAS(TEMP_COOLER)
+        p = telemetry_put_heater(p, -3, degCooler(), degTargetCooler(), getCoolerPower());
+        (*count)++;
+      #endif
+
+      *p++ = planner.movesplanned();
+      *p++ = BLOCK_BUFFER_SIZE;
+      *p++ = commands_in_queue;
+
+      LOOP_XYZE(i) {
+        const int32_t um = (int32_t)(current_position[i] * 1000.0);
+        p = telemetry_put(p, &um, sizeof(um));
+      }
+
+      uint32_t sd_pos = 0, sd_size = 0;
+      #if ENABLED(SDSUPPORT)
+        if (IS_SD_PRINTING) {
+          sd_pos = card.sdpos;
+          sd_size = card.fileSize;
+        }
+      #endif
+      p = telemetry_put(p, &sd_pos, sizeof(sd_pos));
+      p = telemetry_put(p, &sd_size, sizeof(sd_size));
+
+      frame[0] = TELEMETRY_SYNC1;
+      frame[1] = TELEMETRY_SYNC2;
+      frame[2] = p - &frame[3];
+
+      uint16_t sum1 = 0, sum2 = 0;
+      for (uint8_t* c = &frame[2]; c < p; c++) {
+        sum1 = (sum1 + *c) % 255;
+        sum2 = (sum2 + sum1) % 255;
+      }
+      *p++ = sum1;
+      *p++ = sum2;
+
+      for (uint8_t* c = frame; c < p; c++) HAL::serialWriteByte(*c);
+    }
+
+  #endif // AUTO_REPORT_BINARY
+
+  /**
+   * Send the temperature and position reports requested
+   * with M155 and M154 once their interval has elapsed.
+   * Reports are held back while a file is being uploaded.
+   */
+  void auto_report() {
+    #if ENABLED(SDSUPPORT)
+      if (card.saving) return;
+    #endif
+
+    millis_t ms = millis();
+
+    if (auto_report_temp_interval && ELAPSED(ms, next_temp_report_ms)) {
+      next_temp_report_ms = ms + auto_report_temp_interval;
+      #if ENABLED(AUTO_REPORT_BINARY)
+        if (auto_report_binary) send_telemetry_frame();
+        else
+      #endif
+      {
+        #if HAS(TEMP_0) || HAS(TEMP_BED) || ENABLED(HEATER_0_USES_MAX6675)
+          // Report on the active tool without disturbing a command in progress
+          const uint8_t old_target_extruder = target_extruder;
+          target_extruder = active_extruder;
+          print_heaterstates();
+          target_extruder = old_target_extruder;
+        #endif
+        #if HAS(TEMP_CHAMBER)
+          print_chamberstate();
+        #endif
+        #if HAS(TEMP_COOLER)
+          print_coolerstate();
+        #endif
+        SERIAL_E;
+      }
+    }
+
+    if (auto_report_pos_interval && ELAPSED(ms, next_pos_report_ms)) {
+      next_pos_report_ms = ms + auto_report_pos_interval;
+      report_current_position();
+    }
+  }
+
+#endif // AUTO_REPORT
+
 /**
  * G0, G1: Coordinated movement of X Y Z E axes
  */
@@ -3844,7 +4271,11 @@ inline void gcode_G4() {
     laser.mode = RASTER;
     laser.status = LASER_ON;
     laser.fired = RASTER;
+
+    // Scale the line once into the raster pool, the planned blocks share it
+    const uint8_t raster_line = laser_raster_line_fill();
     prepare_move_to_destination();
+    laser_raster_line_release(raster_line);
   }
 #endif
 
@@ -5339,10 +5770,18 @@ inline void gcode_M17() {
 
   /**
    * M26: Set SD Card file index
+   *
+   *  S<pos>   Byte position, binary print files continue at the next command
+   *  L<layer> Start of a layer in a binary print file (SD_BINARY_PRINT)
    */
   inline void gcode_M26() {
-    if (card.cardOK && code_seen('S'))
+    if (!card.cardOK) return;
+    if (code_seen('S'))
       card.setIndex(code_value_long());
+    #if ENABLED(SD_BINARY_PRINT)
+      else if (code_seen('L') && !card.setLayer(code_value_long()))
+        SERIAL_LM(ER, MSG_SD_BINARY_NO_LAYER);
+    #endif
   }
 
   /**
@@ -5354,8 +5793,22 @@ inline void gcode_M17() {
 
   /**
    * M28: Start SD Write
+   *
+   *  M28 B<size> <filename> uploads the file as binary frames (SD_BINARY_UPLOAD)
    */
   inline void gcode_M28() {
+    #if ENABLED(SD_BINARY_UPLOAD)
+      // M28 B<size> <filename>: binary upload, see get_upload_data()
+      char* name = current_command_args;
+      if (*name == 'B' && NUMERIC(name[1]) && (name = strchr(name, ' '))) {
+        while (*name == ' ') name++;
+        if (card.startUpload(name, strtoul(current_command_args + 1, NULL, 10))) {
+          upload_count = upload_seq = 0;
+          upload_frame_ms = millis();
+        }
+        return;
+      }
+    #endif
     card.startWrite(current_command_args, false);
   }
 
@@ -6261,9 +6714,10 @@ inline void gcode_M111() {
   const static char str_debug_8[]   PROGMEM = MSG_DEBUG_DRYRUN;
   const static char str_debug_16[]  PROGMEM = MSG_DEBUG_COMMUNICATION;
   const static char str_debug_32[]  PROGMEM = MSG_DEBUG_ALL;
+  const static char str_debug_64[]  PROGMEM = MSG_DEBUG_PLANNER;
 
   const static char* const debug_strings[] PROGMEM = {
-    str_debug_1, str_debug_2, str_debug_4, str_debug_8, str_debug_16, str_debug_32
+    str_debug_1, str_debug_2, str_debug_4, str_debug_8, str_debug_16, str_debug_32, str_debug_64
   };
 
   SERIAL_S(DEB);
@@ -6366,6 +6820,64 @@ inline void gcode_M122() {
   SERIAL_E;
 }
 
+/**
+ * M123: Report look-ahead planner statistics
+ *
+ * Usage: M123 to report, M123 R to reset the counters
+ */
+inline void gcode_M123() {
+  if (code_seen('R')) planner.planned_blocks = planner.kernel_calls = 0;
+  SERIAL_SMV(ECHO, "Planner blocks:", planner.planned_blocks);
+  SERIAL_MV(" kernel calls:", planner.kernel_calls);
+  if (planner.planned_blocks) SERIAL_MV(" per block:", (float)planner.kernel_calls / planner.planned_blocks);
+  SERIAL_E;
+}
+
+#if ENABLED(ISR_PROFILING)
+  /**
+   * M124: Report the load of the interrupts
+   *
+   * For each interrupt: calls, min/avg/max cycles per call, missed
+   * deadlines (late step or call longer than its period) and share of
+   * the CPU since the last reset. Cycles include the interrupts of
+   * higher priority that preempted it.
+   *
+   * Usage: M124 to report, M124 R to reset the counters
+   */
+  inline void gcode_M124() {
+    if (code_seen('R')) HAL_isr_profile_reset();
+
+    static const char* const isr_name[ISR_PROFILE_COUNT] = { "Stepper", "Advance", "Shaping", "Temperature", "Block prep" };
+    const float elapsed_cycles = (float)(millis() - isr_profile_start_ms) * (F_CPU / 1000UL);
+    float total_load = 0.0;
+
+    for (uint8_t i = 0; i < ISR_PROFILE_COUNT; i++) {
+      CRITICAL_SECTION_START;
+      const uint32_t calls = isr_profile[i].calls,
+                     min_cycles = isr_profile[i].min_cycles,
+                     max_cycles = isr_profile[i].max_cycles,
+                     missed = isr_profile[i].missed;
+      const uint64_t total_cycles = isr_profile[i].total_cycles;
+      CRITICAL_SECTION_END;
+
+      if (!calls) continue;
+
+      const float load = elapsed_cycles > 0 ? 100.0 * total_cycles / elapsed_cycles : 0.0;
+      total_load += load;
+
+      SERIAL_ST(ECHO, isr_name[i]);
+      SERIAL_MV(" ISR calls:", calls);
+      SERIAL_MV(" cycles min:", min_cycles);
+      SERIAL_MV(" avg:", (uint32_t)(total_cycles / calls));
+      SERIAL_MV(" max:", max_cycles);
+      SERIAL_MV(" missed:", missed);
+      SERIAL_EMV(" load:", load, 2);
+    }
+
+    SERIAL_LMV(ECHO, "Headroom %:", 100.0 - total_load, 2);
+  }
+#endif
+
 #if ENABLED(BARICUDA)
   #if HAS(HEATER_1)
     /**
@@ -6529,6 +7041,59 @@ inline void gcode_M122() {
 
 #endif // BLINKM
 
+#if ENABLED(AUTO_REPORT)
+  /**
+   * M154: Set the position auto-report interval (0 to disable)
+   *
+   *   S<seconds> Interval, fractions allowed down to 0.1 s
+   */
+  inline void gcode_M154() {
+    if (code_seen('S')) {
+      const float s = code_value_float();
+      auto_report_pos_interval = s > 0 ? max(100UL, (millis_t)(s * 1000.0)) : 0;
+      next_pos_report_ms = millis() + auto_report_pos_interval;
+    }
+    else
+      SERIAL_EMV("M154 S", auto_report_pos_interval * 0.001, 1);
+  }
+
+  /**
+   * M155: Set the temperature auto-report interval (0 to disable)
+   *
+   *   S<seconds> Interval, fractions allowed down to 0.1 s
+   *   B<bool>    Send the binary telemetry frame instead of text (AUTO_REPORT_BINARY)
+   */
+  inline void gcode_M155() {
+    #if ENABLED(AUTO_REPORT_BINARY)
+      if (code_seen('B')) auto_report_binary = code_value_bool();
+    #endif
+    if (code_seen('S')) {
+      const float s = code_value_float();
+      auto_report_temp_interval = s > 0 ? max(100UL, (millis_t)(s * 1000.0)) : 0;
+      next_temp_report_ms = millis() + auto_report_temp_interval;
+    }
+    else {
+      SERIAL_MV("M155 S", auto_report_temp_interval * 0.001, 1);
+      #if ENABLED(AUTO_REPORT_BINARY)
+        SERIAL_MV(" B", auto_report_binary ? 1 : 0);
+      #endif
+      SERIAL_E;
+    }
+  }
+#endif // AUTO_REPORT
+
+#if ENABLED(BINARY_GCODE)
+  /**
+   * M160: Enable or disable binary G-code packets
+   *
+   *   S<bool> Accept binary packets besides ASCII lines
+   */
+  inline void gcode_M160() {
+    if (code_seen('S')) binary_gcode_enabled = code_value_bool();
+    SERIAL_EMV("BINARY_GCODE:", binary_gcode_enabled ? 1 : 0);
+  }
+#endif // BINARY_GCODE
+
 #if ENABLED(COLOR_MIXING_EXTRUDER)
   /**
    * M163: Set a single mix factor for a mixing extruder
@@ -6749,6 +7314,7 @@ inline void gcode_M204() {
  *    X = Max XY Jerk (units/sec^2)
  *    Z = Max Z Jerk (units/sec^2)
  *    E = Max E Jerk (units/sec^2)
+ *    J = Junction Deviation (units) (Requires JUNCTION_DEVIATION)
  */
 inline void gcode_M205() {
   if (get_target_extruder_from_command(205)) return;
@@ -6759,6 +7325,9 @@ inline void gcode_M205() {
   if (code_seen('X')) planner.max_xy_jerk = code_value_linear_units();
   if (code_seen('Z')) planner.max_z_jerk = code_value_axis_units(Z_AXIS);
   if (code_seen('E')) planner.max_e_jerk[target_extruder] = code_value_axis_units(E_AXIS + target_extruder);
+  #if ENABLED(JUNCTION_DEVIATION)
+    if (code_seen('J')) planner.junction_deviation_mm = code_value_linear_units();
+  #endif
 }
 
 /**
@@ -6835,6 +7404,23 @@ inline void gcode_M206() {
   }
 #endif // FWRETRACT
 
+#if ENABLED(ARC_SUPPORT) && ENABLED(ARC_CHORD_TOLERANCE) && NOMECH(SCARA)
+  /**
+   * M215: Set the arc chord tolerance
+   *
+   *   T<mm> Maximum distance between the arc and its segments
+   *
+   * Without parameters report the current value
+   */
+  inline void gcode_M215() {
+    if (code_seen('T')) {
+      arc_chord_tolerance = code_value_linear_units();
+      NOLESS(arc_chord_tolerance, 0.001);
+    }
+    SERIAL_LMV(ECHO, "Arc chord tolerance: ", arc_chord_tolerance, 3);
+  }
+#endif
+
 /**
  * M218 - set hotend offset (in linear units)
  *
@@ -7181,6 +7767,59 @@ inline void gcode_M226() {
   }
 #endif // PIDTEMPCOOLER
 
+#if ENABLED(MPCTEMP)
+  /**
+   * M307: Set or measure the MPC model of a hotend
+   *
+   *  H<hotend>  Hotend to set (default 0)
+   *  T          Autotune the model, S<temperature> (default MPC_TUNING_TEMP)
+   *  P<watt>    Heater power
+   *  C<J/K>     Heat capacity of the heater block
+   *  R<K/s/K>   Sensor responsiveness
+   *  A<W/K>     Losses to the ambient with the fan off
+   *  F<W/K>     Losses to the ambient with the fan at 255
+   *  K<J/K/mm>  Heat capacity of the filament
+   */
+  inline void gcode_M307() {
+    int h = code_seen('H') ? code_value_int() : 0;
+
+    if (h < 0 || h >= HOTENDS) {
+      SERIAL_LM(ER, MSG_INVALID_EXTRUDER);
+      return;
+    }
+
+    if (code_seen('T')) {
+      float temp = code_seen('S') ? code_value_temp_abs() : MPC_TUNING_TEMP;
+      stepper.synchronize();
+      KEEPALIVE_STATE(NOT_BUSY); // don't send "busy: processing" messages during autotune output
+      MPC_autotune(h, temp);
+      KEEPALIVE_STATE(IN_HANDLER);
+      return;
+    }
+
+    mpc_t &c = mpc[h];
+    if (code_seen('P')) c.heater_power = code_value_float();
+    if (code_seen('C')) c.block_heat_capacity = code_value_float();
+    if (code_seen('R')) c.sensor_responsiveness = code_value_float();
+    if (code_seen('A')) {
+      const float fan255 = c.ambient_xfer_coeff_fan0 + c.fan255_adjustment;
+      c.ambient_xfer_coeff_fan0 = code_value_float();
+      c.fan255_adjustment = fan255 - c.ambient_xfer_coeff_fan0;
+    }
+    if (code_seen('F')) c.fan255_adjustment = code_value_float() - c.ambient_xfer_coeff_fan0;
+    if (code_seen('K')) c.filament_heat_capacity_permm = code_value_float();
+    reset_mpc_model();
+
+    SERIAL_SMV(ECHO, "H", h);
+    SERIAL_MV(" P:", c.heater_power);
+    SERIAL_MV(" C:", c.block_heat_capacity);
+    SERIAL_MV(" R:", c.sensor_responsiveness, 4);
+    SERIAL_MV(" A:", c.ambient_xfer_coeff_fan0, 4);
+    SERIAL_MV(" F:", c.ambient_xfer_coeff_fan0 + c.fan255_adjustment, 4);
+    SERIAL_EMV(" K:", c.filament_heat_capacity_permm, 4);
+  }
+#endif // MPCTEMP
+
 #if HAS(MICROSTEPS)
   // M350 Set microstepping mode. Warning: Steps per unit remains unchanged. S code sets stepping mode for all drivers.
   inline void gcode_M350() {
@@ -7824,6 +8463,48 @@ inline void gcode_M503() {
 
 #endif // ABORT_ON_ENDSTOP_HIT_FEATURE_ENABLED
 
+#if ENABLED(INPUT_SHAPING)
+  /**
+   * M593: Set the input shaping of the X and Y motors
+   *
+   *   X       Only the X motor
+   *   Y       Only the Y motor
+   *   T<type> Shaper (0=None 1=ZV 2=ZVD 3=MZV)
+   *   F<Hz>   Resonant frequency, 0 disables shaping
+   *   D<zeta> Damping ratio, 0 - 0.5
+   *
+   * Without X or Y both motors are set. Always report the current values.
+   */
+  inline void gcode_M593() {
+    const bool seen_x = code_seen('X'), seen_y = code_seen('Y'),
+               axis[2] = { seen_x || !seen_y, seen_y || !seen_x };
+
+    if (code_seen('T') || code_seen('F') || code_seen('D')) {
+      stepper.synchronize();
+
+      for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+        if (!axis[i]) continue;
+        if (code_seen('T')) stepper.shaping_type[i] = constrain(code_value_byte(), SHAPER_NONE, SHAPER_MZV);
+        if (code_seen('F')) {
+          const float freq = code_value_float();
+          stepper.shaping_frequency[i] = freq > 0.0 ? max(freq, SHAPING_MIN_FREQ) : 0.0;
+        }
+        if (code_seen('D')) stepper.shaping_zeta[i] = constrain(code_value_float(), 0.0, SHAPING_MAX_ZETA);
+      }
+
+      stepper.refresh_shaping();
+    }
+
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      SERIAL_SMV(ECHO, "Input shaping ", axis_codes[i]);
+      SERIAL_MV(" T", (int)stepper.shaping_type[i]);
+      SERIAL_MV(" F", stepper.shaping_frequency[i]);
+      SERIAL_EMV(" D", stepper.shaping_zeta[i], 3);
+    }
+    if (stepper.shaping_overflows) SERIAL_LMV(ECHO, "Input shaping unshaped steps: ", stepper.shaping_overflows);
+  }
+#endif // INPUT_SHAPING
+
 #if HEATER_USES_AD595
   /**
    * M595 - set Hotend AD595 offset & Gain H<hotend_number> O<offset> S<gain>
@@ -8908,50 +9589,30 @@ void tool_change(const uint8_t tmp_extruder, const float fr_mm_s/*=0.0*/, bool n
  * This is called from the main loop()
  */
 void process_next_command() {
-  current_command = command_queue[cmd_queue_index_r];
+  char* const line = command_queue[cmd_queue_index_r];
+  current_parsed = &parsed_commands[cmd_queue_index_r];
 
   if (DEBUGGING(ECHO)) {
-    SERIAL_LV(ECHO, current_command);
+    SERIAL_LV(ECHO, line);
   }
 
   // Sanitize the current command:
-  //  - Skip leading spaces
-  //  - Bypass N[-0-9][0-9]*[ ]*
+  //  - Skip leading spaces and N[-0-9][0-9]*[ ]* (done by parse_command)
   //  - Overwrite * with nul to mark the end
-  while (*current_command == ' ') ++current_command;
-  if (*current_command == 'N' && NUMERIC_SIGNED(current_command[1])) {
-    current_command += 2; // skip N[-0-9]
-    while (NUMERIC(*current_command)) ++current_command; // skip [0-9]*
-    while (*current_command == ' ') ++current_command; // skip [ ]*
-  }
+  current_command = line + current_parsed->command;
   char* starpos = strchr(current_command, '*');  // * should always be the last parameter
   if (starpos) while (*starpos == ' ' || *starpos == '*') *starpos-- = '\0'; // nullify '*' and ' '
 
-  char *cmd_ptr = current_command;
-
-  // Get the command code, which must be G, M, or T
-  char command_code = *cmd_ptr++;
-
-  // Skip spaces to get the numeric part
-  while (*cmd_ptr == ' ') cmd_ptr++;
-
-  uint16_t codenum = 0; // define ahead of goto
+  // The command code, which must be G, M, or T, and its number
+  const char command_code = current_parsed->code;
+  const uint16_t codenum = current_parsed->codenum;
 
   // Bail early if there's no code
-  bool code_is_good = NUMERIC(*cmd_ptr);
+  bool code_is_good = (command_code != 0);
   if (!code_is_good) goto ExitUnknownCommand;
 
-  // Get and skip the code number
-  do {
-    codenum = (codenum * 10) + (*cmd_ptr - '0');
-    cmd_ptr++;
-  } while (NUMERIC(*cmd_ptr));
-
-  // Skip all spaces to get to the first argument, or nul
-  while (*cmd_ptr == ' ') cmd_ptr++;
-
   // The command's arguments (if any) start here, for sure!
-  current_command_args = cmd_ptr;
+  current_command_args = line + current_parsed->args;
 
   KEEPALIVE_STATE(IN_HANDLER);
 
@@ -9227,6 +9888,13 @@ void process_next_command() {
         gcode_M121(); break;
       case 122: // M122 Disable or enable software endstops
         gcode_M122(); break;
+      case 123: // M123 Report look-ahead planner statistics
+        gcode_M123(); break;
+
+      #if ENABLED(ISR_PROFILING)
+        case 124: // M124 Report the load of the interrupts, R resets
+          gcode_M124(); break;
+      #endif
 
       #if ENABLED(BARICUDA)
         // PWM for HEATER_1_PIN
@@ -9266,6 +9934,18 @@ void process_next_command() {
           gcode_M150(); break;
       #endif //BLINKM
 
+      #if ENABLED(AUTO_REPORT)
+        case 154: // M154 S<seconds> position auto-report interval
+          gcode_M154(); break;
+        case 155: // M155 S<seconds> [B<bool>] temperature auto-report interval
+          gcode_M155(); break;
+      #endif // AUTO_REPORT
+
+      #if ENABLED(BINARY_GCODE)
+        case 160: // M160 S<bool> enable binary G-code packets
+          gcode_M160(); break;
+      #endif // BINARY_GCODE
+
       #if ENABLED(COLOR_MIXING_EXTRUDER)
         case 163: // M163 S<int> P<float> set weight for a mixing extruder
           gcode_M163(); break;
@@ -9319,6 +9999,11 @@ void process_next_command() {
           gcode_M209(); break;
       #endif // FWRETRACT
 
+      #if ENABLED(ARC_SUPPORT) && ENABLED(ARC_CHORD_TOLERANCE) && NOMECH(SCARA)
+        case 215: // M215 - Set the arc chord tolerance: T<mm>
+          gcode_M215(); break;
+      #endif
+
       case 218: // M218 - Set a tool offset: T<index> X<offset> Y<offset> Z<offset>
         gcode_M218(); break;
       case 220: // M220 - Set Feedrate Percentage: S<percent> ("FR" on your LCD)
@@ -9380,6 +10065,11 @@ void process_next_command() {
           gcode_M306(); break;
       #endif // PIDTEMPCOOLER
 
+      #if ENABLED(MPCTEMP)
+        case 307: // M307 - Set or autotune the hotend MPC model
+          gcode_M307(); break;
+      #endif // MPCTEMP
+
       #if HAS(MICROSTEPS)
         case 350: // M350 Set microstepping mode. Warning: Steps per unit remains unchanged. S code sets stepping mode for all drivers.
           gcode_M350(); break;
@@ -9460,6 +10150,11 @@ void process_next_command() {
           gcode_M540(); break;
       #endif
 
+      #if ENABLED(INPUT_SHAPING)
+        case 593: // M593 - Set the input shaping of X and Y: X Y T<type> F<Hz> D<zeta>
+          gcode_M593(); break;
+      #endif
+
       #if HEATER_USES_AD595
         case 595: // M595 set Hotends AD595 offset & gain
           gcode_M595(); break;
@@ -9855,6 +10550,7 @@ void prepare_move_to_destination() {
  *
  * The arc is approximated by generating many small linear segments.
  * The length of each segment is configured in MM_PER_ARC_SEGMENT (Default 1mm)
+ * or, with ARC_CHORD_TOLERANCE, derived from the maximum chord error.
  * Arcs should only be made relatively large (over 5mm), as larger arcs with
  * larger segments will tend to be more efficient. Your slicer should have
  * options for G2/G3 arc generation. In future these options may be GCode tunable.
@@ -9886,7 +10582,23 @@ void plan_arc(
   
   float mm_of_travel = hypot(angular_travel * radius, fabs(linear_travel));
   if (mm_of_travel < 0.001) { return; }
-  uint16_t segments = floor(mm_of_travel / (MM_PER_ARC_SEGMENT));
+
+  float fr_mm_s = MMS_SCALED(feedrate_mm_s);
+
+  #if ENABLED(ARC_CHORD_TOLERANCE)
+    // Longest chord whose sagitta stays within the tolerance
+    float mm_per_segment = radius > arc_chord_tolerance
+                             ? 2.0 * sqrt(arc_chord_tolerance * (2.0 * radius - arc_chord_tolerance))
+                             : (MAX_ARC_SEGMENT_MM);
+    // Scale the XY chord to the helix travel
+    if (fabs(angular_travel) * radius > 0.001) mm_per_segment *= mm_of_travel / (fabs(angular_travel) * radius);
+    // Don't make segments shorter than the planner can execute in the minimum segment time
+    NOLESS(mm_per_segment, fr_mm_s * planner.min_segment_time / 1000000.0);
+    mm_per_segment = constrain(mm_per_segment, MIN_ARC_SEGMENT_MM, MAX_ARC_SEGMENT_MM);
+    uint16_t segments = ceil(mm_of_travel / mm_per_segment);
+  #else
+    uint16_t segments = floor(mm_of_travel / (MM_PER_ARC_SEGMENT));
+  #endif
   if (segments == 0) segments = 1;
   
   float theta_per_segment = angular_travel / segments;
@@ -9920,8 +10632,14 @@ void plan_arc(
    * This is important when there are successive arc motions.
    */
   // Vector rotation matrix values
-  float cos_T = 1 - 0.5 * theta_per_segment * theta_per_segment; // Small angle approximation
-  float sin_T = theta_per_segment;
+  #if ENABLED(ARC_CHORD_TOLERANCE)
+    // Adaptive segments can span large angles on tight arcs, use the exact rotation
+    float cos_T = cos(theta_per_segment),
+          sin_T = sin(theta_per_segment);
+  #else
+    float cos_T = 1 - 0.5 * theta_per_segment * theta_per_segment; // Small angle approximation
+    float sin_T = theta_per_segment;
+  #endif
   
   float arc_target[NUM_AXIS];
   float sin_Ti, cos_Ti, r_new_Y;
@@ -9934,8 +10652,6 @@ void plan_arc(
   // Initialize the extruder axis
   arc_target[E_AXIS] = current_position[E_AXIS];
 
-  float fr_mm_s = MMS_SCALED(feedrate_mm_s);
-
   millis_t next_idle_ms = millis() + 200UL;
 
   for (i = 1; i < segments; i++) { // Increment (segments-1)
@@ -10001,6 +10717,135 @@ void plan_arc(
   set_current_to_destination();
 }
 
+#if ENABLED(G5_BEZIER)
+
+  /**
+   * True if the midpoint of the step strays more than the flatness from its chord.
+   * The midpoint offset is (D2 - D3 / 2) / 8, its distance from the chord D1 is
+   * compared squared and multiplied by |D1|^2 to avoid any sqrt or division.
+   */
+  static bool bezier_step_coarse(const float d1[2], const float d2[2], const float d3[2], const float max_error) {
+    const float cross = (d2[X_AXIS] - 0.5 * d3[X_AXIS]) * d1[Y_AXIS] - (d2[Y_AXIS] - 0.5 * d3[Y_AXIS]) * d1[X_AXIS];
+    return sq(cross) > max_error * (sq(d1[X_AXIS]) + sq(d1[Y_AXIS]));
+  }
+
+  /**
+   * Plan a cubic Bezier curve from current_position to destination
+   *
+   * offset[0..1] is the first control point relative to current_position (I J),
+   * offset[2..3] the second control point relative to destination (P Q).
+   * Z and E are interpolated linearly along the curve parameter.
+   *
+   * The curve is walked by forward differencing: with the step h, D1, D2 and D3
+   * are the first, second and third forward differences of the curve, so every
+   * segment costs three additions per axis. The step is halved while a segment
+   * strays more than BEZIER_FLATNESS_MM from the curve and doubled while the
+   * doubled step would still be flat enough. Halving and doubling only rescale
+   * the differences by constants, so there is no division in the loop.
+   * Segments are never shorter than the distance covered in the planner
+   * minimum segment time at the current feedrate.
+   */
+  void plan_cubic_move(const float offset[4]) {
+
+    const float fr_mm_s = MMS_SCALED(feedrate_mm_s),
+                max_error = sq(8.0 * (BEZIER_FLATNESS_MM)), // See bezier_step_coarse()
+                min_length = sq(fr_mm_s * planner.min_segment_time / 1000000.0),
+                min_step = 1.0 / 4096.0,
+                dz = destination[Z_AXIS] - current_position[Z_AXIS],
+                de = destination[E_AXIS] - current_position[E_AXIS];
+
+    float bez_target[NUM_AXIS], d1[2], d2[2], d3[2],
+          t = 0.0, h = 0.125;
+
+    // Polynomial coefficients a t^3 + b t^2 + c t + p0, turned into forward differences for the step h
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      const float p0 = current_position[i],
+                  p1 = p0 + offset[i],
+                  p3 = destination[i],
+                  p2 = p3 + offset[i + 2],
+                  a = p3 - p0 + 3.0 * (p1 - p2),
+                  b = 3.0 * (p0 - 2.0 * p1 + p2),
+                  c = 3.0 * (p1 - p0);
+      d1[i] = ((a * h + b) * h + c) * h;
+      d2[i] = (6.0 * a * h + 2.0 * b) * h * h;
+      d3[i] = 6.0 * a * h * h * h;
+      bez_target[i] = p0;
+    }
+
+    millis_t next_idle_ms = millis() + 200UL;
+
+    while (t < 1.0) {
+
+      manage_temp_controller();
+      millis_t now = millis();
+      if (ELAPSED(now, next_idle_ms)) {
+        next_idle_ms = now + 200UL;
+        idle();
+      }
+
+      // Halve the step while it overshoots the end of the curve or the segment isn't flat enough
+      while (h > min_step && (t + h > 1.0 || (bezier_step_coarse(d1, d2, d3, max_error) && sq(d1[X_AXIS]) + sq(d1[Y_AXIS]) > min_length))) {
+        for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+          d1[i] = 0.5 * d1[i] - 0.125 * d2[i] + 0.0625 * d3[i];
+          d2[i] = 0.25 * d2[i] - 0.125 * d3[i];
+          d3[i] *= 0.125;
+        }
+        h *= 0.5;
+      }
+
+      // Double the step while the doubled segment is still flat enough or too short for the planner
+      while (t + 2.0 * h <= 1.0) {
+        float n1[2], n2[2], n3[2];
+        for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+          n1[i] = 2.0 * d1[i] + d2[i];
+          n2[i] = 4.0 * (d2[i] + d3[i]);
+          n3[i] = 8.0 * d3[i];
+        }
+        if (bezier_step_coarse(n1, n2, n3, max_error) && sq(d1[X_AXIS]) + sq(d1[Y_AXIS]) >= min_length) break;
+        for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+          d1[i] = n1[i];
+          d2[i] = n2[i];
+          d3[i] = n3[i];
+        }
+        h *= 2.0;
+      }
+
+      // Step along the curve
+      t += h;
+      for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+        bez_target[i] += d1[i];
+        d1[i] += d2[i];
+        d2[i] += d3[i];
+      }
+
+      if (t >= 1.0) {
+        // Land exactly on the destination
+        bez_target[X_AXIS] = destination[X_AXIS];
+        bez_target[Y_AXIS] = destination[Y_AXIS];
+        t = 1.0;
+      }
+      bez_target[Z_AXIS] = current_position[Z_AXIS] + t * dz;
+      bez_target[E_AXIS] = current_position[E_AXIS] + t * de;
+
+      clamp_to_software_endstops(bez_target);
+
+      #if MECH(DELTA) || MECH(SCARA)
+        inverse_kinematics(bez_target);
+        #if ENABLED(AUTO_BED_LEVELING_FEATURE)
+          adjust_delta(bez_target);
+        #endif
+        planner.buffer_line(delta[TOWER_1], delta[TOWER_2], delta[TOWER_3], bez_target[E_AXIS], fr_mm_s, active_extruder, active_driver);
+      #else
+        planner.buffer_line(bez_target[X_AXIS], bez_target[Y_AXIS], bez_target[Z_AXIS], bez_target[E_AXIS], fr_mm_s, active_extruder, active_driver);
+      #endif
+    }
+
+    // As far as the parser is concerned, the position is now == target.
+    set_current_to_destination();
+  }
+
+#endif // G5_BEZIER
+
 #if HAS(CONTROLLERFAN)
 
   void controllerFan() {
@@ -10156,6 +11001,9 @@ void idle(
     bool no_stepper_sleep/*=false*/
   #endif
 ) {
+  #if ENABLED(STEP_EVENT_QUEUE)
+    stepper.fill_step_queue();
+  #endif
   manage_temp_controller();
   #if ENABLED(FLOWMETER_SENSOR)
     flowrate_manage();
@@ -10166,7 +11014,12 @@ void idle(
     #endif
   );
   host_keepalive();
+  auto_report();
+  planner.trace_blocks();
   lcd_update();
+  #if ENABLED(STEP_EVENT_QUEUE)
+    stepper.fill_step_queue(); // The LCD update can take a while
+  #endif
   print_job_counter.tick();
 }
 
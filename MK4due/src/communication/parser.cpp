@@ -0,0 +1,199 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "../../base.h"
+
+static const float pow10_table[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+
+/**
+ * Read a number as strtod() does, but without the exponent
+ * so the 'E' axis letter can follow the value directly.
+ * Up to 9 significant digits and 9 decimals are used, so the
+ * scale always stays within pow10_table.
+ */
+float parse_float(const char* p) {
+  while (*p == ' ') p++;
+  const bool neg = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+  uint32_t mant = 0;
+  int8_t exp = 0;
+  for (; NUMERIC(*p); p++) {
+    if (mant < 100000000UL) mant = mant * 10 + (*p - '0');
+    else exp++;
+  }
+  if (*p == '.') {
+    for (p++; NUMERIC(*p); p++) {
+      if (mant < 100000000UL && exp > -9) { mant = mant * 10 + (*p - '0'); exp--; }
+    }
+  }
+  NOMORE(exp, 9);
+  float v = (float)mant;
+  if (exp < 0) v /= pow10_table[-exp];
+  else if (exp > 0) v *= pow10_table[exp];
+  return neg ? -v : v;
+}
+
+/**
+ * Parse a queued line into parsed. The line is left untouched:
+ * process_next_command() still does the in-place sanitizing that
+ * string arguments rely on.
+ */
+void parse_command(const char* line, parsed_command_t &parsed) {
+  const char* p = line;
+
+  parsed.code = 0;
+  parsed.letters = 0;
+
+  // Skip leading spaces and N[-0-9][0-9]*[ ]*
+  while (*p == ' ') p++;
+  if (*p == 'N' && NUMERIC_SIGNED(p[1])) {
+    p += 2;
+    while (NUMERIC(*p)) p++;
+    while (*p == ' ') p++;
+  }
+  parsed.command = p - line;
+
+  // The command code, which must be G, M, or T, and its number
+  const char code = *p++;
+  while (*p == ' ') p++;
+  if (!NUMERIC(*p)) return;
+
+  uint16_t codenum = 0;
+  do {
+    codenum = (codenum * 10) + (*p - '0');
+    p++;
+  } while (NUMERIC(*p));
+  while (*p == ' ') p++;
+
+  parsed.code = code;
+  parsed.codenum = codenum;
+  parsed.args = p - line;
+
+  // Record the first occurrence of each letter, up to the checksum
+  for (const char* const args = p; *p && *p != '*'; p++) {
+    if (*p < 'A' || *p > 'Z') continue;
+    const uint8_t i = *p - 'A';
+    if (TEST(parsed.letters, i)) continue;
+    SBI(parsed.letters, i);
+    parsed.offset[i] = p - args;
+    parsed.value[i] = parse_float(p + 1);
+  }
+}
+
+#if ENABLED(BINARY_GCODE) || ENABLED(SD_BINARY_PRINT)
+
+  // 7 bits per byte, least significant first, bit 7 set if more follow
+  static bool binary_read_varint(const uint8_t* &p, const uint8_t* end, uint32_t &val) {
+    val = 0;
+    for (uint8_t shift = 0; p < end && shift < 35; shift += 7) {
+      const uint8_t b = *p++;
+      val |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) return true;
+    }
+    return false;
+  }
+
+  bool binary_decode_command(const uint8_t* p, const uint8_t* end, char* line, parsed_command_t &parsed, int32_t* last_value, int8_t* last_decimals) {
+    char* const cmd_end = line + MAX_CMD_SIZE - 1;
+    char* cmd = line;
+    if (p >= end) return false;
+
+    const uint8_t op = *p++;
+    if ((op >> 6) == 3) {
+      // Plain ASCII command
+      if (end - p > cmd_end - cmd) return false;
+      while (p < end) *cmd++ = *p++;
+      *cmd = '\0';
+      parse_command(line, parsed);
+      return true;
+    }
+
+    const char code = "GMT"[op >> 6];
+    uint32_t num = op & 0x3F;
+    if (num == 0x3F && !binary_read_varint(p, end, num)) return false;
+    parsed.code = code;
+    parsed.codenum = num;
+    parsed.command = 0;
+    parsed.letters = 0;
+
+    char buf[12];
+    uint8_t n = 0;
+    do { buf[n++] = '0' + num % 10; num /= 10; } while (num);
+    if (cmd + n + 1 > cmd_end) return false;
+    *cmd++ = code;
+    while (n) *cmd++ = buf[--n];
+
+    const char* args = NULL;
+    while (p < end) {
+      const uint8_t param = *p++,
+                    letter = param & 0x1F,
+                    type = param >> 5;
+      if (letter > 25 || type > 6 || (type == 6 && (!last_decimals || last_decimals[letter] < 0))) return false;
+      if (cmd + 2 > cmd_end) return false;
+      *cmd++ = ' ';
+      if (!args) args = cmd;
+      const bool first = !TEST(parsed.letters, letter);
+      if (first) {
+        SBI(parsed.letters, letter);
+        parsed.offset[letter] = cmd - args;
+        parsed.value[letter] = 0;
+      }
+      *cmd++ = 'A' + letter;
+      if (!type) continue;
+
+      uint32_t zz;
+      if (!binary_read_varint(p, end, zz)) return false;
+      int32_t value = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+      uint8_t decimals = type > 1 ? type : 0;
+      if (type == 6) {
+        value += last_value[letter];
+        decimals = last_decimals[letter];
+      }
+      if (last_decimals) {
+        last_value[letter] = value;
+        last_decimals[letter] = decimals;
+      }
+
+      const bool neg = value < 0;
+      uint32_t val = neg ? -(uint32_t)value : value;
+      if (first) {
+        const float v = (float)val / pow10_table[decimals];
+        parsed.value[letter] = neg ? -v : v;
+      }
+
+      // Digits in reverse, with the decimal point for fixed point values
+      n = 0;
+      do {
+        if (decimals && n == decimals) buf[n++] = '.';
+        buf[n++] = '0' + val % 10;
+        val /= 10;
+      } while (val || n <= decimals);
+      if (cmd + n + (neg ? 1 : 0) > cmd_end) return false;
+      if (neg) *cmd++ = '-';
+      while (n) *cmd++ = buf[--n];
+    }
+    *cmd = '\0';
+    parsed.args = (args ? args : cmd) - line;
+    return true;
+  }
+
+#endif // BINARY_GCODE || SD_BINARY_PRINT
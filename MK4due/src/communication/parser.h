@@ -0,0 +1,79 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PARSER_H
+#define PARSER_H
+
+/**
+ * Each queued line is parsed once when it is committed. The first
+ * occurrence of each parameter letter A-Z is recorded in a bitmask
+ * together with its position and numeric value, so code_seen() and
+ * code_value_float() don't have to scan the string again.
+ */
+typedef struct {
+  char      code;               // 'G', 'M', 'T'... or 0 if there is no code number
+  uint16_t  codenum;
+  uint8_t   command,            // Offset of the command letter (after N)
+            args;               // Offset of the first argument
+  uint32_t  letters;            // Bit n set if letter 'A' + n was seen
+  uint8_t   offset[26];         // Offset of each letter from the args
+  float     value[26];          // Value following each letter
+} parsed_command_t;
+
+// Number without exponent, so an 'E' letter can follow it
+float parse_float(const char* p);
+
+// Fill parsed from a queued line
+void parse_command(const char* line, parsed_command_t &parsed);
+
+#if ENABLED(BINARY_GCODE) || ENABLED(SD_BINARY_PRINT)
+
+  /**
+   * Tokenized commands, as sent in binary packets (BINARY_GCODE) and
+   * stored in binary print files (SD_BINARY_PRINT):
+   *
+   *   uint8      Opcode: bits 7-6 letter (0 = G, 1 = M, 2 = T, 3 = ASCII)
+   *                      bits 5-0 code number, 63 = varint code number follows
+   *              For ASCII the rest of the command is its text.
+   *   Parameters, repeated to the end of the command:
+   *     uint8    Bits 4-0 letter (0 = A ... 25 = Z)
+   *              Bits 7-5 value: 0 none, 1 integer, 2-5 fixed point
+   *              with 2-5 decimals, both as zigzag varints.
+   *              6 (print files only): zigzag varint difference from the
+   *              last value of the letter, with the same decimals.
+   *
+   * Decode a tokenized command into line, a MAX_CMD_SIZE buffer. The
+   * ASCII line is still written for echo and the string and integer
+   * arguments, but parsed is filled from the decoded values, so the
+   * caller commits it with _commit_command(say_ok, false).
+   *
+   * last_value and last_decimals hold the last value of each letter for
+   * delta coded parameters, a negative decimals entry has none. Without
+   * them, as for packets, delta coded parameters are refused.
+   *
+   * Returns false if the command is malformed or doesn't fit.
+   */
+  bool binary_decode_command(const uint8_t* p, const uint8_t* end, char* line, parsed_command_t &parsed, int32_t* last_value = NULL, int8_t* last_decimals = NULL);
+
+#endif
+
+#endif // PARSER_H
@@ -543,10 +543,16 @@
   #ifdef __SAM3X8E__
     #if ENABLED(CONFIG_STEPPERS_TOSHIBA)
       #define MAX_STEP_FREQUENCY 150000 // Max step frequency for Toshiba Stepper Controllers
+      #undef DOUBLE_STEP_FREQUENCY
       #define DOUBLE_STEP_FREQUENCY MAX_STEP_FREQUENCY
     #else
       #define MAX_STEP_FREQUENCY 320000     // Max step frequency for the Due is approx. 330kHz
-      #define DOUBLE_STEP_FREQUENCY 90000  // 96kHz is close to maximum for an Arduino Due
+      #if DISABLED(DOUBLE_STEP_FREQUENCY)
+        #define DOUBLE_STEP_FREQUENCY 90000  // 96kHz is close to maximum for an Arduino Due
+      #endif
+    #endif
+    #if DISABLED(HIGH_SPEED_PULSE_WIDTH)
+      #define HIGH_SPEED_PULSE_WIDTH 1
     #endif
   #else
     #if ENABLED(CONFIG_STEPPERS_TOSHIBA)
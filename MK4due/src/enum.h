@@ -71,7 +71,18 @@ enum DebugFlags {
   DEBUG_ERRORS        = _BV(2), ///< Not implemented
   DEBUG_DRYRUN        = _BV(3), ///< Ignore temperature setting and E movement commands
   DEBUG_COMMUNICATION = _BV(4), ///< Not implemented
-  DEBUG_ALL           = _BV(5)  ///< Print all Debug
+  DEBUG_ALL           = _BV(5), ///< Print all Debug
+  DEBUG_PLANNER       = _BV(6)  ///< Print the final velocity profile and the virtual time of each planned block
+};
+
+/**
+ * Input shapers
+ */
+enum ShaperType {
+  SHAPER_NONE,
+  SHAPER_ZV,
+  SHAPER_ZVD,
+  SHAPER_MZV
 };
 
 enum EndstopEnum {
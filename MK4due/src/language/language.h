@@ -82,6 +82,7 @@
 #define MSG_ERR_CHECKSUM_MISMATCH            "checksum mismatch, Last Line: "
 #define MSG_ERR_NO_CHECKSUM                  "No Checksum with line number, Last Line: "
 #define MSG_ERR_NO_LINENUMBER_WITH_CHECKSUM  "No Line Number with checksum, Last Line: "
+#define MSG_ERR_BINARY_PACKET                "Bad binary packet, Last Line: "
 #define MSG_FILE_PRINTED                     "Done printing file"
 #define MSG_BEGIN_FILE_LIST                  "Begin file list"
 #define MSG_END_FILE_LIST                    "End file list"
@@ -143,6 +144,14 @@
 #define MSG_SD_DIRECTORY_CREATED             "Directory created"
 #define MSG_SD_CREATION_FAILED               "Creation failed"
 #define MSG_SD_SLASH                         "/"
+#define MSG_SD_BINARY_LAYERS                 "Binary print file, layers: "
+#define MSG_SD_BINARY_TIME                   " time: "
+#define MSG_SD_BINARY_NO_LAYER               "Layer not in the index"
+#define MSG_SD_UPLOAD_DONE                   "Upload: "
+#define MSG_SD_UPLOAD_TIME                   " bytes in "
+#define MSG_SD_UPLOAD_RATE                   " ms, kB/s: "
+#define MSG_SD_UPLOAD_ABORTED                "Upload aborted"
+#define MSG_SD_UPLOAD_BUSY                   "Card busy with an upload"
 #define MSG_SD_MAX_DEPTH                     "trying to call sub-gcode files with too many levels. MAX level is:"
 
 #define MSG_STEPPER_TOO_HIGH                 "Steprate too high: "
@@ -217,6 +226,7 @@
 #define MSG_DEBUG_DRYRUN                     "DRYRUN"
 #define MSG_DEBUG_COMMUNICATION              "COMMUNICATION"
 #define MSG_DEBUG_ALL                        "ALL"
+#define MSG_DEBUG_PLANNER                    "PLANNER"
 
 //other
 #define MSG_BED_LEVELLING_BED                "Bed"
@@ -102,6 +102,7 @@
 #define MSG_VXY_JERK                        "Vxy-jerk"
 #define MSG_VZ_JERK                         "Vz-jerk"
 #define MSG_VE_JERK                         "Ve-jerk"
+#define MSG_JUNCTION_DEVIATION              "Junction Dev"
 #define MSG_VMAX                            "Vmax "
 #define MSG_X                               "X"
 #define MSG_Y                               "Y"
@@ -48,6 +48,10 @@
 
   laser_t laser;
 
+  #if ENABLED(LASER_RASTER)
+    laser_raster_line_t laser_raster_lines[LASER_RASTER_LINES];
+  #endif
+
   void laser_init() {
 
     #if LASER_CONTROL == 1
@@ -84,11 +88,69 @@
       laser.raster_aspect_ratio = LASER_RASTER_ASPECT_RATIO;
       laser.raster_mm_per_pulse = LASER_RASTER_MM_PER_PULSE;
       laser.raster_direction = 1;
+      laser.raster_line = 0;
+      for (uint8_t i = 0; i < LASER_RASTER_LINES; i++) laser_raster_lines[i].refs = 0;
     #endif // LASER_RASTER
     
     laser_extinguish();
   }
 
+  #if ENABLED(LASER_RASTER)
+
+    /**
+     * Take a free line of the raster pool, waiting for the stepper
+     * to release one if needed, and fill it with raster_data scaled
+     * by the raster power. The caller owns a reference to the line.
+     */
+    uint8_t laser_raster_line_fill() {
+      uint8_t index = 0;
+      while (laser_raster_lines[index].refs) {
+        if (++index >= LASER_RASTER_LINES) {
+          index = 0;
+          idle();
+        }
+      }
+
+      laser_raster_line_t &line = laser_raster_lines[index];
+      line.refs = 1;
+
+      for (int i = 0; i < LASER_MAX_RASTER_LINE; i++) {
+        // Scale the image intensity based on the raster power.
+        // 100% power on a pixel basis is 255, convert back to 255 = 100.
+        int OldRange, NewRange;
+        float NewValue;
+
+        OldRange = (255.0 - 0.0);
+        NewRange = (laser.rasterlaserpower * 255.0 / 100.0 - LASER_REMAP_INTENSITY);
+        NewValue = (float)(((((float)laser.raster_data[i] - 0) * NewRange) / OldRange) + LASER_REMAP_INTENSITY);
+
+        // If less than 7%, turn off the laser tube.
+        if (NewValue <= LASER_REMAP_INTENSITY)
+          NewValue = 0;
+
+        line.data[i] = NewValue;
+      }
+
+      laser.raster_line = index;
+      return index;
+    }
+
+    // Add a user of the line. The stepper ISR drops references, so do it atomically.
+    void laser_raster_line_retain(uint8_t index) {
+      CRITICAL_SECTION_START;
+        laser_raster_lines[index].refs++;
+      CRITICAL_SECTION_END;
+    }
+
+    // Drop a user of the line, the line is free again when no one uses it.
+    void laser_raster_line_release(uint8_t index) {
+      CRITICAL_SECTION_START;
+        if (laser_raster_lines[index].refs) laser_raster_lines[index].refs--;
+      CRITICAL_SECTION_END;
+    }
+
+  #endif // LASER_RASTER
+
   void laser_fire(float intensity = 100.0) { // Fire with range 0-100
     laser.firing = LASER_ON;
     laser.last_firing = micros(); // microseconds of last laser firing
@@ -68,11 +68,26 @@
       int raster_raw_length;
       int raster_num_pixels;
       bool raster_direction;
+      uint8_t raster_line; // pool line holding the last scaled raster_data
     #endif // LASER_RASTER
   } laser_t;
 
   extern laser_t laser;
 
+  #if ENABLED(LASER_RASTER)
+    // Scaled raster lines are shared by the planner blocks instead of being copied in each one
+    typedef struct {
+      unsigned char data[LASER_MAX_RASTER_LINE];
+      volatile uint8_t refs; // G7 and the planner blocks still using the line
+    } laser_raster_line_t;
+
+    extern laser_raster_line_t laser_raster_lines[LASER_RASTER_LINES];
+
+    uint8_t laser_raster_line_fill();
+    void laser_raster_line_retain(uint8_t index);
+    void laser_raster_line_release(uint8_t index);
+  #endif // LASER_RASTER
+
   void laser_init();
   void laser_fire(float intensity);
   void laser_fire_byte(uint8_t intensity);
@@ -47,10 +47,6 @@
 
 #include "../../base.h"
 
-#ifndef __SAM3X8E__
-  #include "speed_lookuptable.h"
-#endif
-
 #if HAS(DIGIPOTSS)
   #include <SPI.h>
 #endif
@@ -73,6 +69,13 @@ block_t* Stepper::current_block = NULL;  // A pointer to the block currently bei
   bool Stepper::performing_homing = false;
 #endif
 
+#if ENABLED(INPUT_SHAPING)
+  uint8_t Stepper::shaping_type[2] = { SHAPING_TYPE_X, SHAPING_TYPE_Y };
+  float Stepper::shaping_frequency[2] = { SHAPING_FREQ_X, SHAPING_FREQ_Y },
+        Stepper::shaping_zeta[2] = { SHAPING_ZETA_X, SHAPING_ZETA_Y };
+  uint32_t Stepper::shaping_overflows = 0;
+#endif
+
 // private:
 
 unsigned char Stepper::last_direction_bits = 0;        // The next stepping-bits to be output
@@ -110,6 +113,39 @@ volatile uint32_t Stepper::step_events_completed = 0; // The number of step even
 
 long Stepper::acceleration_time, Stepper::deceleration_time;
 
+#if ENABLED(S_CURVE_ACCELERATION)
+  int32_t Stepper::bezier_A, Stepper::bezier_B, Stepper::bezier_C;
+  uint32_t Stepper::bezier_F, Stepper::bezier_AV;
+  bool Stepper::bezier_2nd_half = false;
+#endif
+
+#if ENABLED(STEP_EVENT_QUEUE)
+  step_event_t Stepper::step_events[STEP_EVENT_QUEUE_SIZE];
+  volatile uint16_t Stepper::step_queue_head = 0, Stepper::step_queue_tail = 0;
+  volatile uint32_t Stepper::step_queue_pushed_ticks = 0, Stepper::step_queue_popped_ticks = 0;
+  volatile bool Stepper::step_queue_abort = false,
+                Stepper::step_queue_locked = false;
+  block_t* Stepper::queue_block = NULL;
+  uint8_t Stepper::queue_block_index = 0;
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+  shaper_t Stepper::shaper[2];
+  shaping_event_t Stepper::shaping_events[SHAPING_BUFFER_SIZE];
+  volatile uint16_t Stepper::shaping_head = 0, Stepper::shaping_tail = 0;
+  uint16_t Stepper::shaping_clock = 0;
+
+  #define SHAPING_STEP_X _BV(0)
+  #define SHAPING_NEG_X  _BV(1)
+  #define SHAPING_STEP_Y _BV(2)
+  #define SHAPING_NEG_Y  _BV(3)
+#endif
+
+#if ENABLED(BLOCK_PREPARATION_ISR)
+  block_prep_t Stepper::block_prep;
+  block_t* volatile Stepper::block_prep_block = NULL;
+#endif
+
 volatile long Stepper::count_position[NUM_AXIS] = { 0 };
 volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
 
@@ -121,6 +157,7 @@ volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
   long Stepper::counter_L;
   #if ENABLED(LASER_RASTER)
     int Stepper::counter_raster;
+    unsigned char* Stepper::raster_data;
   #endif // LASER_RASTER
 #endif // LASERBEAM
 
@@ -128,6 +165,13 @@ volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
   uint32_t Stepper::acc_step_rate; // needed for deceleration start point
   uint8_t Stepper::step_loops, Stepper::step_loops_nominal;
   uint32_t Stepper::OCR1A_nominal;
+  #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+    uint8_t Stepper::amass_level = 0,
+            Stepper::amass_level_nominal = 0,
+            Stepper::amass_tick = 0;
+    uint32_t Stepper::amass_timer,
+             Stepper::amass_event_count;
+  #endif
 #else
   uint16_t Stepper::acc_step_rate; // needed for deceleration start point
   uint8_t Stepper::step_loops, Stepper::step_loops_nominal;
@@ -136,6 +180,16 @@ volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
 
 volatile long Stepper::endstops_trigsteps[XYZ];
 
+#if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+  // Bresenham terms in interrupts: the leading axis adds 2^(MAX - level) per
+  // interrupt, so a step event always sums up to the same ceiling
+  #define BRESENHAM_STEPS(AXIS) (current_block->steps[AXIS] << (AMASS_MAX_LEVEL - amass_level))
+  #define BRESENHAM_EVENTS      amass_event_count
+#else
+  #define BRESENHAM_STEPS(AXIS) current_block->steps[AXIS]
+  #define BRESENHAM_EVENTS      current_block->step_event_count
+#endif
+
 #if ENABLED(X_DUAL_STEPPER_DRIVERS)
   #define X_APPLY_DIR(v,Q)  { X_DIR_WRITE(v); X2_DIR_WRITE((v) != INVERT_X2_VS_X_DIR); }
   #define X_APPLY_STEP(v,Q) { X_STEP_WRITE(v); X2_STEP_WRITE(v); }
@@ -199,6 +253,66 @@ volatile long Stepper::endstops_trigsteps[XYZ];
   #define E_APPLY_STEP(v,Q) E_STEP_WRITE(v)
 #endif
 
+#if ENABLED(STEP_PORT_BATCHING)
+
+  #if ENABLED(X_DUAL_STEPPER_DRIVERS)
+    #define X_BATCH_STEP() { STEP_BATCH_PIN(X_STEP_PIN, INVERT_X_STEP_PIN); STEP_BATCH_PIN(X2_STEP_PIN, INVERT_X_STEP_PIN); }
+  #else
+    #define X_BATCH_STEP() STEP_BATCH_PIN(X_STEP_PIN, INVERT_X_STEP_PIN)
+  #endif
+  #if ENABLED(Y_DUAL_STEPPER_DRIVERS)
+    #define Y_BATCH_STEP() { STEP_BATCH_PIN(Y_STEP_PIN, INVERT_Y_STEP_PIN); STEP_BATCH_PIN(Y2_STEP_PIN, INVERT_Y_STEP_PIN); }
+  #else
+    #define Y_BATCH_STEP() STEP_BATCH_PIN(Y_STEP_PIN, INVERT_Y_STEP_PIN)
+  #endif
+  #if ENABLED(Z_DUAL_STEPPER_DRIVERS)
+    #define Z_BATCH_STEP() { STEP_BATCH_PIN(Z_STEP_PIN, INVERT_Z_STEP_PIN); STEP_BATCH_PIN(Z2_STEP_PIN, INVERT_Z_STEP_PIN); }
+  #else
+    #define Z_BATCH_STEP() STEP_BATCH_PIN(Z_STEP_PIN, INVERT_Z_STEP_PIN)
+  #endif
+
+  #if DRIVER_EXTRUDERS > 1 && DISABLED(COLOR_MIXING_EXTRUDER)
+    // The E driver changes with the block, look its pin up by driver index
+    typedef struct { uint8_t pio; uint32_t bit; } step_pin_t;
+    #define _E_STEP_PIN(N) { STEP_PIO_INDEX(E## N ##_STEP_PIN), STEP_PIO_BIT(E## N ##_STEP_PIN) }
+    static const step_pin_t e_step_pins[DRIVER_EXTRUDERS] = {
+      _E_STEP_PIN(0), _E_STEP_PIN(1)
+      #if DRIVER_EXTRUDERS > 2
+        , _E_STEP_PIN(2)
+        #if DRIVER_EXTRUDERS > 3
+          , _E_STEP_PIN(3)
+          #if DRIVER_EXTRUDERS > 4
+            , _E_STEP_PIN(4)
+            #if DRIVER_EXTRUDERS > 5
+              , _E_STEP_PIN(5)
+            #endif
+          #endif
+        #endif
+      #endif
+    };
+    #define E_BATCH_STEP() { \
+      const step_pin_t &e_pin = e_step_pins[TOOL_DE_INDEX]; \
+      if (INVERT_E_STEP_PIN) step_clr[e_pin.pio] |= e_pin.bit; else step_set[e_pin.pio] |= e_pin.bit; \
+    }
+  #else
+    #define E_BATCH_STEP() STEP_BATCH_PIN(E0_STEP_PIN, INVERT_E_STEP_PIN)
+  #endif
+
+  static Pio* const step_pio[STEP_PIO_COUNT] = { PIOA, PIOB, PIOC, PIOD };
+
+  /**
+   * One write per controller: pulse start is step_batch_write(step_set, step_clr),
+   * pulse end is step_batch_write(step_clr, step_set).
+   */
+  FORCE_INLINE void step_batch_write(const uint32_t high[STEP_PIO_COUNT], const uint32_t low[STEP_PIO_COUNT]) {
+    for (uint8_t p = 0; p < STEP_PIO_COUNT; p++) {
+      if (high[p]) step_pio[p]->PIO_SODR = high[p];
+      if (low[p]) step_pio[p]->PIO_CODR = low[p];
+    }
+  }
+
+#endif // STEP_PORT_BATCHING
+
 /**
  *         __________________________
  *        /|                        |\     _________________         ^
@@ -219,6 +333,9 @@ volatile long Stepper::endstops_trigsteps[XYZ];
 void Stepper::wake_up() {
   //  TCNT1 = 0;
   ENABLE_STEPPER_DRIVER_INTERRUPT();
+  #if ENABLED(BLOCK_PREPARATION_ISR)
+    HAL_block_prep_request(); // New or replanned blocks
+  #endif
   #ifdef __SAM3X8E__
     #if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
       ENABLE_ADVANCE_EXTRUDER_INTERRUPT();
@@ -246,11 +363,17 @@ void Stepper::set_directions() {
       count_direction[AXIS ##_AXIS] = 1; \
     }
 
-  #if HAS(X_DIR)
-    SET_STEP_DIR(X); // A
-  #endif
-  #if HAS(Y_DIR)
-    SET_STEP_DIR(Y); // B
+  #if ENABLED(INPUT_SHAPING)
+    // The X and Y direction pins are driven by the shaping ISR
+    count_direction[X_AXIS] = motor_direction(X_AXIS) ? -1 : 1;
+    count_direction[Y_AXIS] = motor_direction(Y_AXIS) ? -1 : 1;
+  #else
+    #if HAS(X_DIR)
+      SET_STEP_DIR(X); // A
+    #endif
+    #if HAS(Y_DIR)
+      SET_STEP_DIR(Y); // B
+    #endif
   #endif
   #if HAS(Z_DIR)
     SET_STEP_DIR(Z); // C
@@ -271,7 +394,15 @@ void Stepper::set_directions() {
 // "The Stepper Driver Interrupt" - This timer interrupt is the workhorse.
 // It pops blocks from the block_buffer and executes them by pulsing the stepper pins appropriately.
 #ifdef __SAM3X8E__
-  HAL_STEP_TIMER_ISR { Stepper::isr(); }
+  HAL_STEP_TIMER_ISR {
+    ISR_PROFILE_START();
+    #if ENABLED(STEP_EVENT_QUEUE)
+      Stepper::queue_isr();
+    #else
+      Stepper::isr();
+    #endif
+    ISR_PROFILE_END(ISR_PROFILE_STEPPER, 0); // Late steps are counted by HAL_timer_stepper_count
+  }
 #else
   ISR(TIMER1_COMPA_vect) { Stepper::isr(); }
 #endif
@@ -322,9 +453,12 @@ void Stepper::isr() {
     if (current_block) {
       current_block->busy = true;
       trapezoid_generator_reset();
+      #if ENABLED(BLOCK_PREPARATION_ISR)
+        HAL_block_prep_request(); // Get the next block ready
+      #endif
 
       // Initialize Bresenham counters to 1/2 the ceiling
-      counter_X = counter_Y = counter_Z = counter_E = -(current_block->step_event_count >> 1);
+      counter_X = counter_Y = counter_Z = counter_E = -(BRESENHAM_EVENTS >> 1);
 
       #if ENABLED(LASERBEAM)
         #ifdef __SAM3X8E__
@@ -357,7 +491,10 @@ void Stepper::isr() {
       #endif
 
       #if ENABLED(LASERBEAM) && ENABLED(LASER_RASTER)
-         if (current_block->laser_mode == RASTER) counter_raster = 0;
+         if (current_block->laser_mode == RASTER) {
+           counter_raster = 0;
+           raster_data = laser_raster_lines[current_block->laser_raster_line].data;
+         }
       #endif
 
       // #if ENABLED(ADVANCE)
@@ -400,12 +537,25 @@ void Stepper::isr() {
     #define _APPLY_STEP(AXIS) AXIS ##_APPLY_STEP
     #define _INVERT_STEP_PIN(AXIS) INVERT_## AXIS ##_STEP_PIN
 
-    #ifdef __SAM3X8E__
+    #if ENABLED(STEP_PORT_BATCHING)
+      #define _BATCH_STEP(AXIS) AXIS ##_BATCH_STEP
+      uint32_t step_set[STEP_PIO_COUNT] = { 0 }, step_clr[STEP_PIO_COUNT] = { 0 };
+    #endif
+
+    #if ENABLED(STEP_PORT_BATCHING)
       #define PULSE_START(AXIS) \
-        _COUNTER(AXIS) += current_block->steps[_AXIS(AXIS)]; \
+        _COUNTER(AXIS) += BRESENHAM_STEPS(_AXIS(AXIS)); \
+        if (_COUNTER(AXIS) > 0) { \
+          _BATCH_STEP(AXIS)(); \
+          _COUNTER(AXIS) -= BRESENHAM_EVENTS; \
+          count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+        }
+    #elif defined(__SAM3X8E__)
+      #define PULSE_START(AXIS) \
+        _COUNTER(AXIS) += BRESENHAM_STEPS(_AXIS(AXIS)); \
         if (_COUNTER(AXIS) > 0) { \
           _APPLY_STEP(AXIS)(!_INVERT_STEP_PIN(AXIS),0); \
-          _COUNTER(AXIS) -= current_block->step_event_count; \
+          _COUNTER(AXIS) -= BRESENHAM_EVENTS; \
           count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
         }
     #else
@@ -414,6 +564,17 @@ void Stepper::isr() {
         if (_COUNTER(AXIS) > 0) _APPLY_STEP(AXIS)(!_INVERT_STEP_PIN(AXIS),0);
     #endif
 
+    #if ENABLED(INPUT_SHAPING)
+      // Count the step and leave its output to the shaping ISR
+      #define SHAPED_PULSE_START(AXIS) \
+        _COUNTER(AXIS) += BRESENHAM_STEPS(_AXIS(AXIS)); \
+        if (_COUNTER(AXIS) > 0) { \
+          _COUNTER(AXIS) -= BRESENHAM_EVENTS; \
+          count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+          shaping_bits |= count_direction[_AXIS(AXIS)] < 0 ? SHAPING_STEP_## AXIS | SHAPING_NEG_## AXIS : SHAPING_STEP_## AXIS; \
+        }
+    #endif
+
     #ifdef __SAM3X8E__
       #define PULSE_STOP(AXIS) _APPLY_STEP(AXIS)(_INVERT_STEP_PIN(AXIS),0)
     #else
@@ -425,7 +586,7 @@ void Stepper::isr() {
         }
     #endif
 
-    #ifndef __SAM3X8E__ || ENABLED(ENABLE_HIGH_SPEED_STEPPING)
+    #if !defined(__SAM3X8E__) || ENABLED(ENABLE_HIGH_SPEED_STEPPING)
       // Take multiple steps per interrupt (For high speed moves)
       bool all_steps_done = false;
       for (int8_t i = 0; i < step_loops; i++) {
@@ -534,7 +695,9 @@ void Stepper::isr() {
           #endif
         #endif // !ADVANCE && !LIN_ADVANCE
 
-        #if ENABLED(STEPPER_HIGH_LOW) && STEPPER_HIGH_LOW_DELAY > 0
+        #ifdef __SAM3X8E__
+          HAL::delayMicroseconds(HIGH_SPEED_PULSE_WIDTH);
+        #elif ENABLED(STEPPER_HIGH_LOW) && STEPPER_HIGH_LOW_DELAY > 0
           #define CYCLES_EATEN_BY_CODE 10
           while ((uint32_t)(TCNT0 - pulse_start) < (STEPPER_HIGH_LOW_DELAY * (F_CPU / 1000000UL)) - CYCLES_EATEN_BY_CODE) { /* nada */ }
         #endif
@@ -588,16 +751,16 @@ void Stepper::isr() {
               if (current_block->laser_mode == RASTER && current_block->laser_status == LASER_ON) { // Raster Firing Mode
                 #if ENABLED(LASER_PULSE_METHOD)
                   uint32_t ulValue = current_block->laser_raster_intensity_factor * 
-                                     current_block->laser_raster_data[counter_raster];
+                                     raster_data[counter_raster];
                   laser_pulse(ulValue, current_block->laser_duration);
                   counter_raster++;
                   laser.time += current_block->laser_duration/1000; 
                 #else
                   // For some reason, when comparing raster power to ppm line burns the rasters were around 2% more powerful
                   // going from darkened paper to burning through paper.
-                  laser_fire(current_block->laser_raster_data[counter_raster]); 
+                  laser_fire(raster_data[counter_raster]); 
                 #endif
-                if (laser.diagnostics) SERIAL_MV("Pixel: ", (float)current_block->laser_raster_data[counter_raster]);
+                if (laser.diagnostics) SERIAL_MV("Pixel: ", (float)raster_data[counter_raster]);
                 counter_raster++;
               }
             #endif // LASER_RASTER
@@ -629,9 +792,9 @@ void Stepper::isr() {
 
       #if ENABLED(LIN_ADVANCE) // LIN_ADVANCE
 
-        counter_E += current_block->steps[E_AXIS];
+        counter_E += BRESENHAM_STEPS(E_AXIS);
         if (counter_E > 0) {
-          counter_E -= current_block->step_event_count;
+          counter_E -= BRESENHAM_EVENTS;
           #if DISABLED(COLOR_MIXING_EXTRUDER)
             // Don't step E here for mixing extruder
             count_position[E_AXIS] += count_direction[E_AXIS];
@@ -670,9 +833,9 @@ void Stepper::isr() {
       #elif ENABLED(ADVANCE)
 
         // Always count the unified E axis
-        counter_E += current_block->steps[E_AXIS];
+        counter_E += BRESENHAM_STEPS(E_AXIS);
         if (counter_E > 0) {
-          counter_E -= current_block->step_event_count;
+          counter_E -= BRESENHAM_EVENTS;
           #if DISABLED(COLOR_MIXING_EXTRUDER)
             // Don't step E for mixing extruder
             motor_direction(E_AXIS) ? --e_steps[TOOL_E_INDEX] : ++e_steps[TOOL_E_INDEX];
@@ -694,11 +857,35 @@ void Stepper::isr() {
 
       #endif // ADVANCE or LIN_ADVANCE
 
-      #if HAS(X_STEP)
-        PULSE_START(X);
-      #endif
-      #if HAS(Y_STEP)
-        PULSE_START(Y);
+      #if ENABLED(INPUT_SHAPING)
+        uint8_t shaping_bits = 0;
+        #if HAS(X_STEP)
+          SHAPED_PULSE_START(X);
+        #endif
+        #if HAS(Y_STEP)
+          SHAPED_PULSE_START(Y);
+        #endif
+        if (shaping_bits) {
+          const uint16_t next = (shaping_head + 1) & SHAPING_BUFFER_MASK;
+          if (next != shaping_tail) {
+            shaping_events[shaping_head].time = shaping_clock;
+            shaping_events[shaping_head].bits = shaping_bits;
+            shaping_head = next;
+          }
+          else {
+            // Shaper full: output the steps unshaped, M593 reports it
+            shaping_overflows++;
+            if (TEST(shaping_bits, 0)) shaper[X_AXIS].error += TEST(shaping_bits, 1) ? -65536 : 65536;
+            if (TEST(shaping_bits, 2)) shaper[Y_AXIS].error += TEST(shaping_bits, 3) ? -65536 : 65536;
+          }
+        }
+      #else
+        #if HAS(X_STEP)
+          PULSE_START(X);
+        #endif
+        #if HAS(Y_STEP)
+          PULSE_START(Y);
+        #endif
       #endif
       #if HAS(Z_STEP)
         PULSE_START(Z);
@@ -720,6 +907,10 @@ void Stepper::isr() {
         #endif
       #endif // !ADVANCE && !LIN_ADVANCE
 
+      #if ENABLED(STEP_PORT_BATCHING)
+        step_batch_write(step_set, step_clr);
+      #endif
+
       #if ENABLED(LASERBEAM)
         counter_L += current_block->steps_l;
         if (counter_L > 0) {
@@ -741,16 +932,16 @@ void Stepper::isr() {
             if (current_block->laser_mode == RASTER && current_block->laser_status == LASER_ON) { // Raster Firing Mode
               #if ENABLED(LASER_PULSE_METHOD)
                 uint32_t ulValue = current_block->laser_raster_intensity_factor * 
-                                   current_block->laser_raster_data[counter_raster];
+                                   raster_data[counter_raster];
                 laser_pulse(ulValue, current_block->laser_duration);
                 counter_raster++;
                 laser.time += current_block->laser_duration/1000; 
               #else
                 // For some reason, when comparing raster power to ppm line burns the rasters were around 2% more powerful
                 // going from darkened paper to burning through paper.
-                laser_fire(current_block->laser_raster_data[counter_raster]); 
+                laser_fire(raster_data[counter_raster]); 
               #endif
-              if (laser.diagnostics) SERIAL_MV("Pixel: ", (float)current_block->laser_raster_data[counter_raster]);
+              if (laser.diagnostics) SERIAL_MV("Pixel: ", (float)raster_data[counter_raster]);
               counter_raster++;
             }
           #endif // LASER_RASTER
@@ -770,9 +961,16 @@ void Stepper::isr() {
         #endif // DISABLED(LASER_PULSE_METHOD)
       #endif // LASERBEAM
 
-      if (++step_events_completed >= current_block->step_event_count) {
-        all_steps_done = true;
-      }
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        // A step event ends every 2^amass_level interrupts
+        amass_tick = (amass_tick + 1) & ((1 << amass_level) - 1);
+        if (!amass_tick && ++step_events_completed >= current_block->step_event_count)
+          all_steps_done = true;
+      #else
+        if (++step_events_completed >= current_block->step_event_count) {
+          all_steps_done = true;
+        }
+      #endif
 
     #endif // __SAM3X8E__ && DISABLED(ENABLE_HIGH_SPEED_STEPPING)
 
@@ -790,14 +988,26 @@ void Stepper::isr() {
       uint16_t timer, step_rate;
     #endif
 
+    #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+      // Inside a step event: keep its interval, the speed is updated once per event
+      if (amass_tick) timer = amass_timer;
+      else
+    #endif
     if (step_events_completed <= (uint32_t)current_block->accelerate_until) {
 
-      #ifdef __SAM3X8E__
-        MultiU32X32toH32(acc_step_rate, acceleration_time, current_block->acceleration_rate);
+      #if ENABLED(S_CURVE_ACCELERATION)
+        // Jerk limited speed: follow the Bezier curve up to the cruise rate
+        acc_step_rate = (uint32_t)acceleration_time < current_block->acceleration_time
+                          ? _eval_bezier_curve(acceleration_time)
+                          : current_block->cruise_rate;
       #else
-        MultiU24X32toH16(acc_step_rate, acceleration_time, current_block->acceleration_rate);
+        #ifdef __SAM3X8E__
+          MultiU32X32toH32(acc_step_rate, acceleration_time, current_block->acceleration_rate);
+        #else
+          MultiU24X32toH16(acc_step_rate, acceleration_time, current_block->acceleration_rate);
+        #endif
+        acc_step_rate += current_block->initial_rate;
       #endif
-      acc_step_rate += current_block->initial_rate;
 
       // upper limit
       NOMORE(acc_step_rate, current_block->nominal_rate);
@@ -847,19 +1057,34 @@ void Stepper::isr() {
       #endif
     }
     else if (step_events_completed > (uint32_t)current_block->decelerate_after) {
-      #ifdef __SAM3X8E__
-        MultiU32X32toH32(step_rate, deceleration_time, current_block->acceleration_rate);
+      #if ENABLED(S_CURVE_ACCELERATION)
+        if (!bezier_2nd_half) {
+          // First deceleration step: set up the curve down to the exit rate
+          _calc_bezier_curve_coeffs(current_block->cruise_rate, current_block->final_rate, current_block->deceleration_time_inverse);
+          bezier_2nd_half = true;
+          step_rate = current_block->cruise_rate;
+        }
+        else {
+          step_rate = (uint32_t)deceleration_time < current_block->deceleration_time
+                        ? _eval_bezier_curve(deceleration_time)
+                        : current_block->final_rate;
+          NOLESS(step_rate, current_block->final_rate);
+        }
       #else
-        MultiU24X32toH16(step_rate, deceleration_time, current_block->acceleration_rate);
-      #endif
+        #ifdef __SAM3X8E__
+          MultiU32X32toH32(step_rate, deceleration_time, current_block->acceleration_rate);
+        #else
+          MultiU24X32toH16(step_rate, deceleration_time, current_block->acceleration_rate);
+        #endif
 
-      if (step_rate < acc_step_rate) {
-        step_rate = acc_step_rate - step_rate; // Decelerate from acceleration end point.
-        NOLESS(step_rate, current_block->final_rate);
-      }
-      else {
-        step_rate = current_block->final_rate;
-      }
+        if (step_rate < acc_step_rate) {
+          step_rate = acc_step_rate - step_rate; // Decelerate from acceleration end point.
+          NOLESS(step_rate, current_block->final_rate);
+        }
+        else {
+          step_rate = current_block->final_rate;
+        }
+      #endif
 
       // step_rate to timer interval
       timer = calc_timer(step_rate);
@@ -921,18 +1146,33 @@ void Stepper::isr() {
       #endif
       // ensure we're running at the correct step rate, even if we just came off an acceleration
       step_loops = step_loops_nominal;
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        amass_level = amass_level_nominal;
+      #endif
     }
 
-    #ifdef __SAM3X8E__ && DISABLED(ENABLE_HIGH_SPEED_STEPPING)
+    #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+      // New step event: spread it over 2^amass_level interrupts
+      if (!amass_tick) amass_timer = timer >> amass_level;
+      timer = amass_timer;
+    #endif
 
-      #if HAS(X_STEP)
-        PULSE_STOP(X);
-      #endif
-      #if HAS(Y_STEP)
-        PULSE_STOP(Y);
-      #endif
-      #if HAS(Z_STEP)
-        PULSE_STOP(Z);
+    #if defined(__SAM3X8E__) && DISABLED(ENABLE_HIGH_SPEED_STEPPING)
+
+      #if ENABLED(STEP_PORT_BATCHING)
+        step_batch_write(step_clr, step_set);
+      #else
+        #if DISABLED(INPUT_SHAPING)
+          #if HAS(X_STEP)
+            PULSE_STOP(X);
+          #endif
+          #if HAS(Y_STEP)
+            PULSE_STOP(Y);
+          #endif
+        #endif
+        #if HAS(Z_STEP)
+          PULSE_STOP(Z);
+        #endif
       #endif
 
       #if DISABLED(ADVANCE) && DISABLED(LIN_ADVANCE)
@@ -948,7 +1188,7 @@ void Stepper::isr() {
               En_STEP_WRITE(j, INVERT_E_STEP_PIN);
             }
           }
-        #else // !COLOR_MIXING_EXTRUDER
+        #elif DISABLED(STEP_PORT_BATCHING)
           PULSE_STOP(E);
         #endif
       #endif // !ADVANCE && !LIN_ADVANCE
@@ -983,7 +1223,11 @@ void Stepper::isr() {
 #if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
 
   #ifdef __SAM3X8E__
-    HAL_ADVANCE_EXTRUDER_TIMER_ISR { Stepper::advance_isr(); }
+    HAL_ADVANCE_EXTRUDER_TIMER_ISR {
+      ISR_PROFILE_START();
+      Stepper::advance_isr();
+      ISR_PROFILE_END(ISR_PROFILE_ADVANCE, F_CPU / (ADVANCE_EXTRUDER_FREQUENCY));
+    }
   #else
     // Timer interrupt for E. e_steps is set in the main routine;
     // Timer 0 is shared with millies
@@ -1081,6 +1325,516 @@ void Stepper::isr() {
   }
 #endif // ADVANCE or LIN_ADVANCE
 
+#if ENABLED(STEP_EVENT_QUEUE)
+
+  /**
+   * Stepper ISR playing back the step events: set the directions at the
+   * start of a block, pulse the motors of the event, reload the timer
+   * and discard the block after its last event.
+   */
+  void Stepper::queue_isr() {
+
+    stepperChannel->TC_SR;
+
+    if (cleaning_buffer_counter) {
+      step_queue_tail = step_queue_head;
+      step_queue_popped_ticks = step_queue_pushed_ticks;
+      step_queue_abort = false;
+      current_block = NULL;
+      planner.discard_current_block();
+      #if ENABLED(SD_FINISHED_RELEASECOMMAND)
+        if ((cleaning_buffer_counter == 1) && (SD_FINISHED_STEPPERRELEASE)) enqueue_and_echo_commands_P(PSTR(SD_FINISHED_RELEASECOMMAND));
+      #endif
+      cleaning_buffer_counter--;
+      HAL_timer_stepper_count(HAL_TIMER_RATE / 200); // 5ms wait
+      return;
+    }
+
+    uint16_t tail = step_queue_tail;
+
+    // An endstop killed the current block: drop its events up to the last one
+    if (step_queue_abort) {
+      while (tail != step_queue_head) {
+        const uint8_t flags = step_events[tail].flags;
+        step_queue_popped_ticks += step_events[tail].interval;
+        tail = (tail + 1) & STEP_EVENT_QUEUE_MASK;
+        if (flags & STEP_EVENT_BLOCK_END) {
+          step_queue_abort = false;
+          current_block = NULL;
+          planner.discard_current_block();
+          break;
+        }
+      }
+      step_queue_tail = tail;
+      HAL_timer_stepper_count(HAL_TIMER_RATE / 10000);
+      return;
+    }
+
+    // Nothing to play, poll again in 100us
+    if (tail == step_queue_head) {
+      if (planner.blocks_queued()) HAL_step_queue_request();
+      HAL_timer_stepper_count(HAL_TIMER_RATE / 10000);
+      return;
+    }
+
+    const step_event_t &event = step_events[tail];
+    const uint32_t interval = event.interval;
+    const uint8_t steps = event.steps, flags = event.flags;
+
+    if (flags & STEP_EVENT_BLOCK_START) {
+      static int8_t last_extruder = -1;
+      current_block = planner.get_current_block();
+      if (current_block->direction_bits != last_direction_bits || current_block->active_extruder != last_extruder) {
+        last_direction_bits = current_block->direction_bits;
+        last_extruder = current_block->active_extruder;
+        set_directions();
+      }
+    }
+
+    // Update endstops state, if enabled
+    if (endstops.enabled
+      #if HAS(BED_PROBE)
+        || endstops.z_probe_enabled
+      #endif
+    ) {
+      endstops.update();
+      if (step_queue_abort) {
+        HAL_timer_stepper_count(HAL_TIMER_RATE / 10000);
+        return;
+      }
+    }
+
+    #if ENABLED(STEP_PORT_BATCHING)
+      uint32_t step_set[STEP_PIO_COUNT] = { 0 }, step_clr[STEP_PIO_COUNT] = { 0 };
+      #define QUEUE_PULSE_START(AXIS) \
+        if (TEST(steps, _AXIS(AXIS))) { \
+          _BATCH_STEP(AXIS)(); \
+          count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+        }
+    #else
+      #define QUEUE_PULSE_START(AXIS) \
+        if (TEST(steps, _AXIS(AXIS))) { \
+          _APPLY_STEP(AXIS)(!_INVERT_STEP_PIN(AXIS),0); \
+          count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+        }
+      #define QUEUE_PULSE_STOP(AXIS) \
+        if (TEST(steps, _AXIS(AXIS))) _APPLY_STEP(AXIS)(_INVERT_STEP_PIN(AXIS),0)
+    #endif
+
+    #if HAS(X_STEP)
+      QUEUE_PULSE_START(X);
+    #endif
+    #if HAS(Y_STEP)
+      QUEUE_PULSE_START(Y);
+    #endif
+    #if HAS(Z_STEP)
+      QUEUE_PULSE_START(Z);
+    #endif
+    QUEUE_PULSE_START(E);
+    #if ENABLED(STEP_PORT_BATCHING)
+      step_batch_write(step_set, step_clr);
+    #endif
+
+    step_queue_popped_ticks += interval;
+    step_queue_tail = (tail + 1) & STEP_EVENT_QUEUE_MASK;
+    HAL_timer_stepper_count(interval);
+
+    // The main loop is late: refill on PendSV before the queue runs dry
+    if (step_queue_pushed_ticks - step_queue_popped_ticks < (STEP_EVENT_QUEUE_TICKS) / 2)
+      HAL_step_queue_request();
+
+    HAL::delayMicroseconds(STEP_EVENT_PULSE_WIDTH);
+
+    #if ENABLED(STEP_PORT_BATCHING)
+      step_batch_write(step_clr, step_set);
+    #else
+      #if HAS(X_STEP)
+        QUEUE_PULSE_STOP(X);
+      #endif
+      #if HAS(Y_STEP)
+        QUEUE_PULSE_STOP(Y);
+      #endif
+      #if HAS(Z_STEP)
+        QUEUE_PULSE_STOP(Z);
+      #endif
+      QUEUE_PULSE_STOP(E);
+    #endif
+
+    if (flags & STEP_EVENT_BLOCK_END) {
+      current_block = NULL;
+      planner.discard_current_block();
+    }
+  }
+
+  // Start the trapezoid generator on queue_block
+  void Stepper::queue_block_reset() {
+    counter_X = counter_Y = counter_Z = counter_E = -(queue_block->step_event_count >> 1);
+    step_events_completed = 0;
+    deceleration_time = 0;
+    OCR1A_nominal = calc_timer(queue_block->nominal_rate);
+    acc_step_rate = queue_block->initial_rate;
+    acceleration_time = calc_timer(acc_step_rate);
+    #if ENABLED(S_CURVE_ACCELERATION)
+      _calc_bezier_curve_coeffs(queue_block->initial_rate, queue_block->cruise_rate, queue_block->acceleration_time_inverse);
+      bezier_2nd_half = false;
+    #endif
+  }
+
+  // Timer ticks to the next step event of queue_block, as the stepper ISR computes them
+  uint32_t Stepper::queue_block_timer() {
+    uint32_t timer, step_rate;
+
+    if (step_events_completed <= (uint32_t)queue_block->accelerate_until) {
+      #if ENABLED(S_CURVE_ACCELERATION)
+        acc_step_rate = (uint32_t)acceleration_time < queue_block->acceleration_time
+                          ? _eval_bezier_curve(acceleration_time)
+                          : queue_block->cruise_rate;
+      #else
+        MultiU32X32toH32(acc_step_rate, acceleration_time, queue_block->acceleration_rate);
+        acc_step_rate += queue_block->initial_rate;
+      #endif
+      NOMORE(acc_step_rate, queue_block->nominal_rate);
+      timer = calc_timer(acc_step_rate);
+      acceleration_time += timer;
+    }
+    else if (step_events_completed > (uint32_t)queue_block->decelerate_after) {
+      #if ENABLED(S_CURVE_ACCELERATION)
+        if (!bezier_2nd_half) {
+          _calc_bezier_curve_coeffs(queue_block->cruise_rate, queue_block->final_rate, queue_block->deceleration_time_inverse);
+          bezier_2nd_half = true;
+          step_rate = queue_block->cruise_rate;
+        }
+        else {
+          step_rate = (uint32_t)deceleration_time < queue_block->deceleration_time
+                        ? _eval_bezier_curve(deceleration_time)
+                        : queue_block->final_rate;
+          NOLESS(step_rate, queue_block->final_rate);
+        }
+      #else
+        MultiU32X32toH32(step_rate, deceleration_time, queue_block->acceleration_rate);
+        if (step_rate < acc_step_rate) {
+          step_rate = acc_step_rate - step_rate;
+          NOLESS(step_rate, queue_block->final_rate);
+        }
+        else
+          step_rate = queue_block->final_rate;
+      #endif
+      timer = calc_timer(step_rate);
+      deceleration_time += timer;
+    }
+    else
+      timer = OCR1A_nominal;
+
+    return timer;
+  }
+
+  /**
+   * Refill the queue from the main loop, unless the planner is replanning
+   */
+  void Stepper::fill_step_queue() {
+    if (step_queue_locked) return;
+    step_queue_locked = true;
+    produce_step_events();
+    step_queue_locked = false;
+  }
+
+  /**
+   * The stepper ISR requests PendSV when less than half of STEP_EVENT_QUEUE_MS
+   * is left in the queue, so a main loop stall doesn't stop the motion. PendSV
+   * runs below the stepper ISR and can't interrupt itself, and the main loop
+   * can't run while it does: the lock only has to keep it out of a main loop
+   * refill or replan in progress. Then the main loop refills right after.
+   */
+  HAL_STEP_QUEUE_ISR {
+    Stepper::step_queue_refill_isr();
+  }
+
+  void Stepper::step_queue_refill_isr() {
+    if (!step_queue_locked) produce_step_events();
+  }
+
+  /**
+   * Producer of the step event queue. Runs the Bresenham tracer and the
+   * trapezoid generator of the blocks, at most STEP_EVENT_QUEUE_MS ahead
+   * of the stepper ISR. A block is marked busy (frozen for the planner)
+   * when its first event is computed and discarded by the ISR after its
+   * last event is played.
+   */
+  void Stepper::produce_step_events() {
+
+    // Blocks are being flushed by quick_stop, restart from the tail
+    if (cleaning_buffer_counter) {
+      queue_block = NULL;
+      queue_block_index = planner.block_buffer_tail;
+      return;
+    }
+
+    for (;;) {
+      const uint16_t head = step_queue_head,
+                     next = (head + 1) & STEP_EVENT_QUEUE_MASK;
+      if (next == step_queue_tail || step_queue_pushed_ticks - step_queue_popped_ticks >= STEP_EVENT_QUEUE_TICKS) return;
+
+      step_event_t &event = step_events[head];
+      event.flags = 0;
+
+      if (!queue_block) {
+        if (queue_block_index == planner.block_buffer_head) return;
+        queue_block = &planner.block_buffer[queue_block_index];
+        queue_block->busy = true;
+        queue_block_reset();
+        event.flags = STEP_EVENT_BLOCK_START;
+      }
+
+      uint8_t steps = 0;
+
+      if (step_queue_abort && queue_block == current_block) {
+        // The ISR is dropping this block, just close it
+        event.interval = HAL_TIMER_RATE / 10000;
+        event.flags |= STEP_EVENT_BLOCK_END;
+      }
+      else {
+        #define QUEUE_STEP(AXIS) \
+          _COUNTER(AXIS) += queue_block->steps[_AXIS(AXIS)]; \
+          if (_COUNTER(AXIS) > 0) { \
+            _COUNTER(AXIS) -= queue_block->step_event_count; \
+            SBI(steps, _AXIS(AXIS)); \
+          }
+
+        QUEUE_STEP(X);
+        QUEUE_STEP(Y);
+        QUEUE_STEP(Z);
+        QUEUE_STEP(E);
+
+        if (++step_events_completed >= queue_block->step_event_count)
+          event.flags |= STEP_EVENT_BLOCK_END;
+
+        event.interval = queue_block_timer();
+      }
+
+      event.steps = steps;
+
+      if (event.flags & STEP_EVENT_BLOCK_END) {
+        queue_block = NULL;
+        queue_block_index = BLOCK_MOD(queue_block_index + 1);
+      }
+
+      step_queue_pushed_ticks += event.interval;
+      __DMB(); // The event must be complete before the ISR can see it
+      step_queue_head = next;
+    }
+  }
+
+#endif // STEP_EVENT_QUEUE
+
+#if ENABLED(INPUT_SHAPING)
+
+  // Timer interrupt for the X and Y step outputs.
+  // Every step of the stepper ISR is split into the impulses of the shaper,
+  // each one added to the motor error once its delay has passed. A step is
+  // output as soon as the error exceeds half a step, so the pulses follow
+  // the shaped motion with a resolution of one shaping tick.
+  HAL_SHAPING_TIMER_ISR {
+    ISR_PROFILE_START();
+    Stepper::shaping_isr();
+    ISR_PROFILE_END(ISR_PROFILE_SHAPING, F_CPU / (SHAPING_ISR_FREQUENCY));
+  }
+
+  void Stepper::shaping_isr() {
+
+    shapingChannel->TC_SR;
+
+    const uint16_t head = shaping_head;
+    ++shaping_clock;
+
+    // Apply the impulses that are due
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      shaper_t &s = shaper[i];
+      const uint8_t step_bit = i == X_AXIS ? SHAPING_STEP_X : SHAPING_STEP_Y,
+                    neg_bit = step_bit << 1;
+      for (uint8_t k = 0; k < s.impulses; k++) {
+        uint16_t t = s.tail[k];
+        while (t != head) {
+          const shaping_event_t &ev = shaping_events[t];
+          if ((uint16_t)(shaping_clock - ev.time) < s.delay[k]) break;
+          if (ev.bits & step_bit) s.error += (ev.bits & neg_bit) ? -s.amplitude[k] : s.amplitude[k];
+          t = (t + 1) & SHAPING_BUFFER_MASK;
+        }
+        s.tail[k] = t;
+      }
+    }
+
+    // The last impulse of the slowest motor frees the events
+    const uint16_t tail_x = shaper[X_AXIS].tail[shaper[X_AXIS].impulses - 1],
+                   tail_y = shaper[Y_AXIS].tail[shaper[Y_AXIS].impulses - 1];
+    shaping_tail = ((head - tail_x) & SHAPING_BUFFER_MASK) >= ((head - tail_y) & SHAPING_BUFFER_MASK) ? tail_x : tail_y;
+
+    // End the previous pulse, or change direction, or start a new pulse
+    #define SHAPED_OUTPUT(AXIS) { \
+      shaper_t &s = shaper[AXIS ##_AXIS]; \
+      if (s.pulse) { \
+        AXIS ##_APPLY_STEP(INVERT_## AXIS ##_STEP_PIN, 0); \
+        s.pulse = false; \
+      } \
+      else if (s.error > 32768 || s.error < -32768) { \
+        const bool neg = s.error < 0; \
+        if (neg != s.dir_neg) { \
+          AXIS ##_APPLY_DIR(neg ? INVERT_## AXIS ##_DIR : !INVERT_## AXIS ##_DIR, false); \
+          s.dir_neg = neg; \
+        } \
+        else { \
+          AXIS ##_APPLY_STEP(!INVERT_## AXIS ##_STEP_PIN, 0); \
+          s.error += neg ? 65536 : -65536; \
+          s.pulse = true; \
+        } \
+      } \
+    }
+
+    #if HAS(X_STEP)
+      SHAPED_OUTPUT(X);
+    #endif
+    #if HAS(Y_STEP)
+      SHAPED_OUTPUT(Y);
+    #endif
+  }
+
+  /**
+   * Impulses of the shapers, with K = e^(-zeta * PI / sqrt(1 - zeta^2))
+   * and Td = 1 / (f * sqrt(1 - zeta^2)) the damped period:
+   *
+   *   ZV:  [1, K]         at [0, Td/2]
+   *   ZVD: [1, 2K, K^2]   at [0, Td/2, Td]
+   *   MZV: three impulses at [0, 3Td/8, 3Td/4]
+   *
+   * The amplitudes are normalized so they sum to exactly one step.
+   */
+  void Stepper::refresh_shaping() {
+    shaper_t shape[2];
+
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      float a[3] = { 1.0, 0.0, 0.0 }, d[3] = { 0.0, 0.0, 0.0 };
+      uint8_t n = 1;
+
+      // Keep the delays within what the step buffer is sized for
+      const float f = shaping_frequency[i] > 0.0 ? max(shaping_frequency[i], SHAPING_MIN_FREQ) : 0.0;
+      if (f > 0.0 && shaping_type[i] != SHAPER_NONE) {
+        const float zeta = constrain(shaping_zeta[i], 0.0, SHAPING_MAX_ZETA),
+                    df = sqrt(1.0 - sq(zeta)),
+                    K = exp(-zeta * M_PI / df),
+                    td = 1.0 / (f * df);
+
+        switch (shaping_type[i]) {
+          case SHAPER_ZV:
+            n = 2;
+            a[1] = K;
+            d[1] = 0.5 * td;
+            break;
+          case SHAPER_ZVD:
+            n = 3;
+            a[1] = 2.0 * K;
+            a[2] = sq(K);
+            d[1] = 0.5 * td;
+            d[2] = td;
+            break;
+          case SHAPER_MZV: {
+            const float K2 = exp(-0.75 * zeta * M_PI / df);
+            n = 3;
+            a[0] = 1.0 - M_SQRT1_2;
+            a[1] = (M_SQRT2 - 1.0) * K2;
+            a[2] = a[0] * sq(K2);
+            d[1] = 0.375 * td;
+            d[2] = 0.75 * td;
+          } break;
+        }
+      }
+
+      float sum = 0.0;
+      for (uint8_t k = 0; k < n; k++) sum += a[k];
+
+      int32_t left = 65536;
+      for (uint8_t k = 0; k < n; k++) {
+        shape[i].amplitude[k] = k < n - 1 ? lround(a[k] * 65536.0 / sum) : left;
+        left -= shape[i].amplitude[k];
+        shape[i].delay[k] = lround(d[k] * SHAPING_ISR_FREQUENCY);
+      }
+      shape[i].impulses = n;
+    }
+
+    CRITICAL_SECTION_START;
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      shaper[i].impulses = shape[i].impulses;
+      for (uint8_t k = 0; k < shape[i].impulses; k++) {
+        shaper[i].amplitude[k] = shape[i].amplitude[k];
+        shaper[i].delay[k] = shape[i].delay[k];
+        shaper[i].tail[k] = shaping_head;
+      }
+    }
+    shaping_tail = shaping_head;
+    CRITICAL_SECTION_END;
+  }
+
+  void Stepper::shaping_flush() {
+    CRITICAL_SECTION_START;
+    const uint16_t head = shaping_head;
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      shaper_t &s = shaper[i];
+      const uint8_t step_bit = i == X_AXIS ? SHAPING_STEP_X : SHAPING_STEP_Y,
+                    neg_bit = step_bit << 1;
+
+      // Everything not output yet, always a whole number of steps
+      int32_t pending = s.error;
+      for (uint8_t k = 0; k < s.impulses; k++) {
+        for (uint16_t t = s.tail[k]; t != head; t = (t + 1) & SHAPING_BUFFER_MASK) {
+          const uint8_t bits = shaping_events[t].bits;
+          if (bits & step_bit) pending += (bits & neg_bit) ? -s.amplitude[k] : s.amplitude[k];
+        }
+        s.tail[k] = head;
+      }
+      s.error = 0;
+      count_position[i] -= pending / 65536;
+    }
+    shaping_tail = head;
+    CRITICAL_SECTION_END;
+  }
+
+  bool Stepper::shaping_busy() {
+    return shaping_tail != shaping_head || shaper[X_AXIS].error || shaper[Y_AXIS].error;
+  }
+
+#endif // INPUT_SHAPING
+
+#if ENABLED(BLOCK_PREPARATION_ISR)
+
+  // Block preparation runs on the PendSV exception, below the stepper and
+  // advance interrupts: it is requested when a block starts or the planner
+  // adds or replans blocks, and leaves the stepper ISR only a copy to do.
+  HAL_BLOCK_PREP_ISR {
+    ISR_PROFILE_START();
+    Stepper::block_prep_isr();
+    ISR_PROFILE_END(ISR_PROFILE_BLOCK_PREP, 0);
+  }
+
+  void Stepper::block_prep_isr() {
+
+    // The block the stepper takes next: the tail, or the one after it while the tail runs
+    CRITICAL_SECTION_START;
+      uint8_t index = planner.block_buffer_tail;
+      if (current_block) index = BLOCK_MOD(index + 1);
+      const bool queued = index != planner.block_buffer_head;
+    CRITICAL_SECTION_END;
+    if (!queued) return;
+
+    block_t* block = &planner.block_buffer[index];
+    if (block->busy || (block_prep_block == block && block->prepared)) return;
+
+    // The stepper ISR may preempt us, keep block_prep invalid while it is written
+    block_prep_block = NULL;
+    prepare_block(block, block_prep);
+    block->prepared = true;
+    block_prep_block = block;
+  }
+
+#endif // BLOCK_PREPARATION_ISR
+
 void Stepper::init() {
   digipot_init();   // Initialize Digipot Motor Current
   microstep_init(); // Initialize Microstepping Pins
@@ -1267,7 +2021,25 @@ void Stepper::init() {
   #endif
 
   #ifdef __SAM3X8E__
+    #if ENABLED(BLOCK_PREPARATION_ISR)
+      HAL_block_prep_start();
+    #endif
+    #if ENABLED(STEP_EVENT_QUEUE)
+      HAL_step_queue_start();
+    #endif
     HAL_step_timer_start();
+    #if ENABLED(INPUT_SHAPING)
+      // The shaping ISR starts with the X and Y motors going forward
+      #if HAS(X_DIR)
+        X_APPLY_DIR(!INVERT_X_DIR, true);
+      #endif
+      #if HAS(Y_DIR)
+        Y_APPLY_DIR(!INVERT_Y_DIR, true);
+      #endif
+      shaper[X_AXIS].dir_neg = shaper[Y_AXIS].dir_neg = false;
+      refresh_shaping();
+      HAL_shaping_timer_start();
+    #endif
   #else
     // waveform generation = 0100 = CTC
     CBI(TCCR1B, WGM13);
@@ -1280,9 +2052,7 @@ void Stepper::init() {
     TCCR1A &= ~(3 << COM1B0);
     // Set the timer pre-scaler
     // Generally we use a divider of 8, resulting in a 2MHz timer
-    // frequency on a 16MHz MCU. If you are going to change this, be
-    // sure to regenerate speed_lookuptable.h with
-    // create_speed_lookuptable.py
+    // frequency on a 16MHz MCU.
     TCCR1B = (TCCR1B & ~(0x07 << CS10)) | (2 << CS10);
 
     OCR1A = 0x4000;
@@ -1322,7 +2092,13 @@ void Stepper::init() {
 /**
  * Block until all buffered steps are executed
  */
-void Stepper::synchronize() { while (planner.blocks_queued()) idle(); }
+void Stepper::synchronize() {
+  while (planner.blocks_queued()
+    #if ENABLED(INPUT_SHAPING)
+      || shaping_busy()
+    #endif
+  ) idle();
+}
 
 /**
  * Set the stepper positions directly in steps
@@ -1442,6 +2218,18 @@ void Stepper::quick_stop() {
   DISABLE_STEPPER_DRIVER_INTERRUPT();
   while (planner.blocks_queued()) planner.discard_current_block();
   current_block = NULL;
+  #if ENABLED(STEP_EVENT_QUEUE)
+    lock_step_queue();
+    step_queue_tail = step_queue_head;
+    step_queue_popped_ticks = step_queue_pushed_ticks;
+    step_queue_abort = false;
+    queue_block = NULL;
+    queue_block_index = planner.block_buffer_tail;
+    unlock_step_queue();
+  #endif
+  #if ENABLED(INPUT_SHAPING)
+    shaping_flush();
+  #endif
   ENABLE_STEPPER_DRIVER_INTERRUPT();
   #ifdef __SAM3X8E__
     #if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
@@ -1452,6 +2240,11 @@ void Stepper::quick_stop() {
 
 void Stepper::endstop_triggered(AxisEnum axis) {
 
+  #if ENABLED(INPUT_SHAPING)
+    // Keep only the X and Y steps already output
+    shaping_flush();
+  #endif
+
   #if MECH(COREXY) || MECH(COREYX) || MECH(COREXZ) || MECH(COREZX)
 
     float axis_pos = count_position[axis];
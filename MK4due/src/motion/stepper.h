@@ -43,15 +43,79 @@
 #ifndef STEPPER_H
 #define STEPPER_H
 
-#ifndef __SAM3X8E__
-  #include "speed_lookuptable.h"
-#endif
-
 #include "stepper_indirection.h"
 
 class Stepper;
 extern Stepper stepper;
 
+#if ENABLED(INPUT_SHAPING)
+
+  // The shaping ISR needs a tick for the step pulse and a tick to end it
+  #define SHAPING_MAX_STEP_RATE ((SHAPING_ISR_FREQUENCY) / 2)
+
+  // Longest impulse delay in shaping ISR ticks: the damped period at
+  // SHAPING_MIN_FREQ and SHAPING_MAX_ZETA, 1 / (f * sqrt(1 - 0.5^2))
+  #define SHAPING_MAX_ZETA 0.5
+  #define SHAPING_MAX_DELAY ((SHAPING_ISR_FREQUENCY) * 1.1548 / (SHAPING_MIN_FREQ))
+
+  // Power of 2 ring holding the step events of the longest delay at SHAPING_MAX_STEP_RATE
+  constexpr uint16_t shaping_buffer_size(const uint32_t events, const uint16_t size = 16) {
+    return size > events ? size : shaping_buffer_size(events, size << 1);
+  }
+  #define SHAPING_BUFFER_SIZE shaping_buffer_size((uint32_t)(SHAPING_MAX_DELAY) / 2)
+  #define SHAPING_BUFFER_MASK (SHAPING_BUFFER_SIZE - 1)
+
+  // A step of the X and/or Y motor, as generated by the stepper ISR
+  typedef struct {
+    uint16_t time;                  // Shaping ISR tick of the step
+    uint8_t bits;                   // SHAPING_STEP_X, SHAPING_NEG_X, SHAPING_STEP_Y, SHAPING_NEG_Y
+  } shaping_event_t;
+
+  // The impulse train of a motor and the state of its step output
+  typedef struct {
+    uint8_t impulses;               // Number of impulses, 1 when shaping is disabled
+    int32_t amplitude[3];           // Impulse amplitudes in 1/65536 of a step, they sum to 65536
+    uint16_t delay[3];              // Impulse delays in shaping ISR ticks
+    uint16_t tail[3];               // Next event of the ring each impulse has to apply
+    int32_t error;                  // Steps applied but not output yet, in 1/65536 of a step
+    bool dir_neg, pulse;            // Current level of the direction and step pins
+  } shaper_t;
+
+#endif
+
+#if ENABLED(STEP_EVENT_QUEUE)
+
+  #define STEP_EVENT_QUEUE_MASK (STEP_EVENT_QUEUE_SIZE - 1)
+  #define STEP_EVENT_QUEUE_TICKS ((HAL_TIMER_RATE / 1000UL) * (STEP_EVENT_QUEUE_MS))
+
+  #define STEP_EVENT_BLOCK_START _BV(0) // First event of a block: set the directions
+  #define STEP_EVENT_BLOCK_END   _BV(1) // Last event of a block: discard it
+
+  // A step event, computed in the main loop and played back by the stepper ISR
+  typedef struct {
+    uint32_t interval;              // Timer ticks to the next event
+    uint8_t steps;                  // Motors to step, one bit per axis
+    uint8_t flags;                  // STEP_EVENT_BLOCK_START, STEP_EVENT_BLOCK_END
+  } step_event_t;
+
+#endif
+
+// Rate dependent state of a block, computed before the block starts
+typedef struct {
+  uint32_t nominal_timer,           // Timer ticks between steps at the nominal rate
+           initial_timer;           // Timer ticks of the first step
+  uint8_t nominal_loops,            // Steps per interrupt at the nominal and initial rate
+          initial_loops;
+  #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+    uint8_t nominal_level,          // AMASS level at the nominal and initial rate
+            initial_level;
+  #endif
+  #if ENABLED(LIN_ADVANCE)
+    int initial_estep_rate,         // Extruder speed at the initial and nominal rate
+        final_estep_rate;
+  #endif
+} block_prep_t;
+
 class Stepper {
 
   public:
@@ -66,6 +130,13 @@ class Stepper {
       static bool performing_homing;
     #endif
 
+    #if ENABLED(INPUT_SHAPING)
+      static uint8_t shaping_type[2];       // ShaperType of the X and Y motors
+      static float shaping_frequency[2],    // (Hz) 0 disables shaping
+                   shaping_zeta[2];         // Damping ratio
+      static uint32_t shaping_overflows;    // Steps output unshaped because the buffer was full
+    #endif
+
   private:
 
     static unsigned char last_direction_bits;        // The next stepping-bits to be output
@@ -109,6 +180,42 @@ class Stepper {
 
     static uint8_t step_loops, step_loops_nominal;
 
+    #if ENABLED(BLOCK_PREPARATION_ISR)
+      static block_prep_t block_prep;                   // Written by block_prep_isr, read when a block starts
+      static block_t* volatile block_prep_block;        // The block of block_prep, NULL while it is written
+    #endif
+
+    #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+      static uint8_t amass_level, amass_level_nominal,  // Each step event takes 2^level interrupts
+                     amass_tick;                        // Interrupts done in the current step event
+      static uint32_t amass_timer,                      // Timer ticks between two interrupts
+                      amass_event_count;                // Bresenham ceiling, step_event_count << AMASS_MAX_LEVEL
+    #endif
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      static int32_t bezier_A, bezier_B, bezier_C;  // Coefficients of the 5th order Bezier speed curve
+      static uint32_t bezier_F, bezier_AV;          // Start rate and timer ticks to curve position scale
+      static bool bezier_2nd_half;                  // true once the deceleration curve is set up
+    #endif
+
+    #if ENABLED(STEP_EVENT_QUEUE)
+      // Single producer (fill_step_queue) single consumer (queue_isr) ring
+      static step_event_t step_events[STEP_EVENT_QUEUE_SIZE];
+      static volatile uint16_t step_queue_head, step_queue_tail;
+      static volatile uint32_t step_queue_pushed_ticks, step_queue_popped_ticks;
+      static volatile bool step_queue_abort;  // Drop the rest of the current block
+      static volatile bool step_queue_locked; // The producer is running or the planner is replanning
+      static block_t* queue_block;            // Block being turned into step events
+      static uint8_t queue_block_index;       // Next block for the producer
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      static shaper_t shaper[2];
+      static shaping_event_t shaping_events[SHAPING_BUFFER_SIZE];
+      static volatile uint16_t shaping_head, shaping_tail;
+      static uint16_t shaping_clock;
+    #endif
+
     static volatile long endstops_trigsteps[XYZ];
     static volatile long endstops_stepsTotal, endstops_stepsDone;
 
@@ -140,6 +247,7 @@ class Stepper {
       static long counter_L;
       #if ENABLED(LASER_RASTER)
         static int counter_raster;
+        static unsigned char* raster_data; // pixels of the current block, in the laser raster pool
       #endif // LASER_RASTER
     #endif // LASERBEAM
 
@@ -164,6 +272,30 @@ class Stepper {
       static void advance_isr();
     #endif
 
+    #if ENABLED(INPUT_SHAPING)
+      static void shaping_isr();
+    #endif
+
+    #if ENABLED(BLOCK_PREPARATION_ISR)
+      static void block_prep_isr();
+    #endif
+
+    #if ENABLED(STEP_EVENT_QUEUE)
+      static void queue_isr();
+      static void step_queue_refill_isr();
+
+      //
+      // Turn the planned blocks into step events, called by idle()
+      //
+      static void fill_step_queue();
+
+      //
+      // Keep the producer off the blocks while the planner changes them
+      //
+      static FORCE_INLINE void lock_step_queue() { step_queue_locked = true; }
+      static FORCE_INLINE void unlock_step_queue() { step_queue_locked = false; }
+    #endif
+
     //
     // Block until all buffered steps are executed
     //
@@ -238,7 +370,14 @@ class Stepper {
     #endif
 
     static inline void kill_current_block() {
-      step_events_completed = current_block->step_event_count;
+      #if ENABLED(STEP_EVENT_QUEUE)
+        step_queue_abort = true;
+      #else
+        step_events_completed = current_block->step_event_count;
+        #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+          amass_tick = (1 << amass_level) - 1; // End the step event on the next interrupt
+        #endif
+      #endif
     }
 
     //
@@ -253,6 +392,24 @@ class Stepper {
       return endstops_trigsteps[axis] * planner.steps_to_mm[axis];
     }
 
+    #if ENABLED(INPUT_SHAPING)
+      //
+      // Compute the impulses of the X and Y shapers from the shaping settings
+      //
+      static void refresh_shaping();
+
+      //
+      // Drop the X and Y steps still waiting in the shaper. The steps
+      // not output yet are removed from the motor positions.
+      //
+      static void shaping_flush();
+
+      //
+      // True while the shaper has X or Y steps to output
+      //
+      static bool shaping_busy();
+    #endif
+
     #if ENABLED(NPR2) // Multiextruder
       static void colorstep(long csteps, const bool direction);
     #endif
@@ -263,58 +420,119 @@ class Stepper {
 
   private:
     
-    #ifdef __SAM3X8E__
-      static FORCE_INLINE uint32_t calc_timer(uint32_t step_rate) {
-        uint32_t timer;
-    #else
-      static FORCE_INLINE uint16_t calc_timer(uint16_t step_rate) {
-        uint16_t timer;
+    /**
+     * Timer ticks between two stepper interrupts for a step rate.
+     * The SAM3X8E divides in hardware, so the interval is a single exact
+     * (rounded) 32 bit division of the timer clock: no lookup table and
+     * no quantization over the whole rate range. With
+     * ENABLE_HIGH_SPEED_STEPPING the interrupt takes 2 steps above
+     * DOUBLE_STEP_FREQUENCY and 4 steps above twice that rate.
+     * With ADAPTIVE_STEP_SMOOTHING it also sets amass_level: below
+     * AMASS_CUTOFF_FREQUENCY each step event is split in 2, 4, ... interrupts
+     * (one more level every octave) so the slower axes get a finer timing.
+     */
+    static FORCE_INLINE uint32_t calc_timer(uint32_t step_rate) {
+      NOMORE(step_rate, MAX_STEP_FREQUENCY);
+      const uint8_t shift = calc_step_shift(step_rate);
+      step_loops = 1 << shift;
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        amass_level = calc_amass_level(step_rate);
+      #endif
+      return calc_interval(step_rate, shift);
+    }
+
+    // Steps per interrupt (as a power of 2) for a step rate
+    static FORCE_INLINE uint8_t calc_step_shift(const uint32_t step_rate) {
+      #if ENABLED(ENABLE_HIGH_SPEED_STEPPING)
+        if (step_rate > 2 * (DOUBLE_STEP_FREQUENCY)) return 2;
+        if (step_rate > DOUBLE_STEP_FREQUENCY) return 1;
+      #else
+        UNUSED(step_rate);
+      #endif
+      return 0;
+    }
+
+    static FORCE_INLINE uint32_t calc_interval(const uint32_t step_rate, const uint8_t shift) {
+      return (((uint32_t)HAL_TIMER_RATE << shift) + (step_rate >> 1)) / step_rate;
+    }
+
+    #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+      static FORCE_INLINE uint8_t calc_amass_level(const uint32_t step_rate) {
+        uint8_t level = 0;
+        while (level < AMASS_MAX_LEVEL && step_rate < ((AMASS_CUTOFF_FREQUENCY) >> level)) level++;
+        return level;
+      }
     #endif
 
-        NOMORE(step_rate, MAX_STEP_FREQUENCY);
-
-        #ifndef __SAM3X8E__ || ENABLED(ENABLE_HIGH_SPEED_STEPPING)
-          if(step_rate > (2 * DOUBLE_STEP_FREQUENCY)) { // If steprate > 2*DOUBLE_STEP_FREQUENCY >> step 4 times
-            step_rate >>= 2;
-            step_loops = 4;
-          }
-          else if(step_rate > DOUBLE_STEP_FREQUENCY) { // If steprate > DOUBLE_STEP_FREQUENCY >> step 2 times
-            step_rate >>= 1;
-            step_loops = 2;
-          }
-          else
-        #endif
-        {
-          step_loops = 1;
-        }
+    /**
+     * Compute the rate dependent state of a block. It only reads the block and
+     * writes prep, so it can run ahead of time in block_prep_isr.
+     */
+    static FORCE_INLINE void prepare_block(const block_t* block, block_prep_t &prep) {
+      uint32_t rate = block->nominal_rate;
+      NOMORE(rate, MAX_STEP_FREQUENCY);
+      uint8_t shift = calc_step_shift(rate);
+      prep.nominal_loops = 1 << shift;
+      prep.nominal_timer = calc_interval(rate, shift);
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        prep.nominal_level = calc_amass_level(rate);
+      #endif
 
-        #ifdef __SAM3X8E__
-          timer = HAL_TIMER_RATE / step_rate;
-        #else
-          NOLESS(step_rate, F_CPU / 500000);
-          step_rate -= F_CPU / 500000; // Correct for minimal speed
-          if (step_rate >= (8 * 256)) { // higher step rate
-            uint16_t table_address = (uint16_t)&speed_lookuptable_fast[(unsigned char)(step_rate >> 8)][0];
-            unsigned char tmp_step_rate = (step_rate & 0x00ff);
-            uint16_t gain = (uint16_t)pgm_read_word_near(table_address + 2);
-            MultiU16X8toH16(timer, tmp_step_rate, gain);
-            timer = (uint16_t)pgm_read_word_near(table_address) - timer;
-          }
-          else { // lower step rates
-            uint16_t table_address = (uint16_t)&speed_lookuptable_slow[0][0];
-            table_address += ((step_rate) >> 1) & 0xfffc;
-            timer = (uint16_t)pgm_read_word_near(table_address);
-            timer -= (((uint16_t)pgm_read_word_near(table_address + 2) * (unsigned char)(step_rate & 0x0007)) >> 3);
-          }
-
-          if (timer < 100) { // (20kHz this should never happen)
-            timer = 100;
-            SERIAL_EMT(MSG_STEPPER_TOO_HIGH, step_rate);
-          }
-        #endif
-      return timer;
+      rate = block->initial_rate;
+      NOMORE(rate, MAX_STEP_FREQUENCY);
+      shift = calc_step_shift(rate);
+      prep.initial_loops = 1 << shift;
+      prep.initial_timer = calc_interval(rate, shift);
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        prep.initial_level = calc_amass_level(rate);
+      #endif
+
+      #if ENABLED(LIN_ADVANCE)
+        if (block->use_advance_lead) {
+          prep.initial_estep_rate = ((uint32_t)block->initial_rate * block->e_speed_multiplier8) >> 8;
+          prep.final_estep_rate = (block->nominal_rate * block->e_speed_multiplier8) >> 8;
+        }
+      #endif
     }
-    
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+
+      /**
+       * Set up the speed curve from rate v0 to rate v1. The curve is a 5th order
+       * Bezier with the control points P0 = P1 = P2 = v0 and P3 = P4 = P5 = v1,
+       * so speed and acceleration are continuous at both ends:
+       *
+       *   V(t) = F + C * t^3 + B * t^4 + A * t^5
+       *
+       *   A = 6 * (v1 - v0), B = 15 * (v0 - v1), C = 10 * (v1 - v0), F = v0
+       *
+       * av is the 0.32 fixed point inverse of the curve duration in timer ticks.
+       */
+      static FORCE_INLINE void _calc_bezier_curve_coeffs(const int32_t v0, const int32_t v1, const uint32_t av) {
+        bezier_A = 6 * (v1 - v0);
+        bezier_B = 15 * (v0 - v1);
+        bezier_C = 10 * (v1 - v0);
+        bezier_F = v0;
+        bezier_AV = av;
+      }
+
+      /**
+       * Evaluate the speed curve after curr_time timer ticks (curr_time must be
+       * below the curve duration). t is the 0.32 fixed point curve position and
+       * the polynomial is computed with Horner's rule using only 32x32->64 bit
+       * multiplications, which are single cycle instructions on the Cortex-M3.
+       */
+      static FORCE_INLINE uint32_t _eval_bezier_curve(const uint32_t curr_time) {
+        const uint32_t t = bezier_AV * curr_time,
+                       t2 = ((uint64_t)t * t) >> 32,
+                       t3 = ((uint64_t)t2 * t) >> 32;
+        int32_t acc = bezier_B + (int32_t)(((int64_t)bezier_A * t) >> 32);
+        acc = bezier_C + (int32_t)(((int64_t)acc * t) >> 32);
+        return bezier_F + (int32_t)(((int64_t)acc * t3) >> 32);
+      }
+
+    #endif // S_CURVE_ACCELERATION
+
     // Initializes the trapezoid generator from the current block. Called whenever a new
     // block begins.
     static FORCE_INLINE void trapezoid_generator_reset() {
@@ -347,13 +565,38 @@ class Stepper {
 
       #endif
 
+      block_prep_t local_prep;
+      const block_prep_t* prep = &local_prep;
+      #if ENABLED(BLOCK_PREPARATION_ISR)
+        // Take the state prepared ahead of time, if the planner didn't change the block since
+        if (block_prep_block == current_block && current_block->prepared)
+          prep = &block_prep;
+        else
+      #endif
+          prepare_block(current_block, local_prep);
+
       deceleration_time = 0;
-      // step_rate to timer interval
-      OCR1A_nominal = calc_timer(current_block->nominal_rate);
+      OCR1A_nominal = prep->nominal_timer;
       // make a note of the number of step loops required at nominal speed
-      step_loops_nominal = step_loops;
+      step_loops_nominal = prep->nominal_loops;
       acc_step_rate = current_block->initial_rate;
-      acceleration_time = calc_timer(acc_step_rate);
+      acceleration_time = prep->initial_timer;
+      step_loops = prep->initial_loops;
+
+      #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+        amass_level_nominal = prep->nominal_level;
+        // The first step event runs at the initial rate
+        amass_level = prep->initial_level;
+        amass_timer = acceleration_time >> amass_level;
+        amass_tick = 0;
+        amass_event_count = current_block->step_event_count << AMASS_MAX_LEVEL;
+      #endif
+
+      #if ENABLED(S_CURVE_ACCELERATION)
+        // Set up the speed curve of the acceleration phase
+        _calc_bezier_curve_coeffs(current_block->initial_rate, current_block->cruise_rate, current_block->acceleration_time_inverse);
+        bezier_2nd_half = false;
+      #endif
 
       #ifdef __SAM3X8E__
         //HAL_timer_stepper_count(acceleration_time);
@@ -363,12 +606,18 @@ class Stepper {
 
       #if ENABLED(LIN_ADVANCE)
         if (current_block->use_advance_lead) {
-          current_estep_rate[current_block->active_extruder] = ((uint32_t)acc_step_rate * current_block->e_speed_multiplier8) >> 8;
-          final_estep_rate = (current_block->nominal_rate * current_block->e_speed_multiplier8) >> 8;
+          current_estep_rate[current_block->active_extruder] = prep->initial_estep_rate;
+          final_estep_rate = prep->final_estep_rate;
         }
       #endif
     }
 
+    #if ENABLED(STEP_EVENT_QUEUE)
+      static void queue_block_reset();
+      static uint32_t queue_block_timer();
+      static void produce_step_events();
+    #endif
+
     static void digipot_init();
     static void microstep_init();
 
@@ -582,6 +582,25 @@
 
 #endif
 
+/**
+ * Port batched step output
+ *
+ * Each step pin is reduced to its PIO controller and bit, as given by the
+ * board's fastio map. The stepper ISR ORs the pins stepping this tick into
+ * one mask per controller and writes every PIO_SODR/PIO_CODR only once.
+ */
+#if ENABLED(STEP_PORT_BATCHING)
+  #define _STEP_PIO(IO)       DIO ## IO ## _PORT
+  #define _STEP_PIO_BIT(IO)   DIO ## IO ## _PIN
+  #define STEP_PIO(IO)        _STEP_PIO(IO)
+  #define STEP_PIO_BIT(IO)    _STEP_PIO_BIT(IO)
+  #define STEP_PIO_INDEX(IO)  (STEP_PIO(IO) == PIOA ? 0 : STEP_PIO(IO) == PIOB ? 1 : STEP_PIO(IO) == PIOC ? 2 : 3)
+  #define STEP_PIO_COUNT      4
+
+  // Non inverted pins go in the set mask, inverted pins in the clear mask
+  #define STEP_BATCH_PIN(IO,INVERT) do{ if (INVERT) step_clr[STEP_PIO_INDEX(IO)] |= STEP_PIO_BIT(IO); else step_set[STEP_PIO_INDEX(IO)] |= STEP_PIO_BIT(IO); }while(0)
+#endif
+
 #define disable_e() { disable_e0(); disable_e1(); disable_e2(); disable_e3(); disable_e4(); disable_e5(); }
 
 #endif // STEPPER_INDIRECTION_H
@@ -70,6 +70,13 @@ Planner planner;
 block_t Planner::block_buffer[BLOCK_BUFFER_SIZE];
 volatile uint8_t Planner::block_buffer_head = 0;           // Index of the next block to be pushed
 volatile uint8_t Planner::block_buffer_tail = 0;
+uint8_t Planner::block_buffer_planned = 0;            // Index of the first block whose entry speed can't be improved anymore
+uint8_t Planner::block_buffer_traced = 0;             // Index of the first block not yet printed by DEBUG_PLANNER
+float Planner::traced_time = 0.0;
+uint16_t Planner::traced_dropped = 0;
+
+uint32_t Planner::planned_blocks = 0,
+         Planner::kernel_calls = 0;
 
 float Planner::max_feedrate_mm_s[3 + EXTRUDERS], // Max speeds in mm per second
       Planner::axis_steps_per_mm[3 + EXTRUDERS],
@@ -88,6 +95,10 @@ float Planner::min_feedrate_mm_s,
       Planner::max_z_jerk,
       Planner::max_e_jerk[EXTRUDERS];
 
+#if ENABLED(JUNCTION_DEVIATION)
+  float Planner::junction_deviation_mm = JUNCTION_DEVIATION_MM;
+#endif
+
 #if ENABLED(AUTO_BED_LEVELING_FEATURE) && NOMECH(DELTA)
   matrix_3x3 Planner::bed_level_matrix; // Transform to compensate for bed level
 #endif
@@ -106,6 +117,10 @@ long Planner::position[NUM_AXIS] = { 0 };
 float Planner::previous_speed[NUM_AXIS],
       Planner::previous_nominal_speed;
 
+#if ENABLED(JUNCTION_DEVIATION)
+  float Planner::previous_unit_vec[NUM_AXIS];
+#endif
+
 uint8_t Planner::last_extruder;
 
 #if ENABLED(DISABLE_INACTIVE_EXTRUDER)
@@ -126,10 +141,14 @@ uint8_t Planner::last_extruder;
 Planner::Planner() { init(); }
 
 void Planner::init() {
-  block_buffer_head = block_buffer_tail = 0;
+  block_buffer_head = block_buffer_tail = block_buffer_planned = block_buffer_traced = 0;
+  traced_dropped = 0;
   memset(position, 0, sizeof(position)); // clear position
   LOOP_XYZE(i) previous_speed[i] = 0.0;
   previous_nominal_speed = 0.0;
+  #if ENABLED(JUNCTION_DEVIATION)
+    LOOP_XYZE(i) previous_unit_vec[i] = 0.0;
+  #endif
   #if ENABLED(AUTO_BED_LEVELING_FEATURE) && NOMECH(DELTA)
     bed_level_matrix.set_to_identity();
   #endif
@@ -164,6 +183,23 @@ void Planner::calculate_trapezoid_for_block(block_t* block, float entry_factor,
     plateau_steps = 0;
   }
 
+  #if ENABLED(S_CURVE_ACCELERATION)
+    // The Bezier curves of the stepper are driven by time, not by steps.
+    // Find the rate reached at the end of the acceleration phase and the
+    // duration (in stepper timer ticks) of both speed ramps.
+    uint32_t cruise_rate = block->nominal_rate;
+    if (plateau_steps == 0 && accel > 0) {
+      cruise_rate = sqrt(sq((float)initial_rate) + 2.0 * accel * accelerate_steps);
+      NOMORE(cruise_rate, block->nominal_rate);
+      NOLESS(cruise_rate, initial_rate);
+    }
+    NOLESS(cruise_rate, final_rate);
+    uint32_t acceleration_time = accel > 0 ? ((float)(cruise_rate - initial_rate) / accel) * (HAL_TIMER_RATE) : 0,
+             deceleration_time = accel > 0 ? ((float)(cruise_rate - final_rate) / accel) * (HAL_TIMER_RATE) : 0,
+             acceleration_time_inverse = get_period_inverse(acceleration_time),
+             deceleration_time_inverse = get_period_inverse(deceleration_time);
+  #endif
+
   #if ENABLED(ADVANCE)
     volatile long initial_advance = block->advance * entry_factor * entry_factor;
     volatile long final_advance = block->advance * exit_factor * exit_factor;
@@ -173,10 +209,20 @@ void Planner::calculate_trapezoid_for_block(block_t* block, float entry_factor,
   // block->decelerate_after = accelerate_steps+plateau_steps;
   CRITICAL_SECTION_START;  // Fill variables used by the stepper in a critical section
   if (!block->busy) { // Don't update variables if block is busy.
+    #if ENABLED(BLOCK_PREPARATION_ISR)
+      block->prepared = false;
+    #endif
     block->accelerate_until = accelerate_steps;
     block->decelerate_after = accelerate_steps + plateau_steps;
     block->initial_rate = initial_rate;
     block->final_rate = final_rate;
+    #if ENABLED(S_CURVE_ACCELERATION)
+      block->cruise_rate = cruise_rate;
+      block->acceleration_time = acceleration_time;
+      block->deceleration_time = deceleration_time;
+      block->acceleration_time_inverse = acceleration_time_inverse;
+      block->deceleration_time_inverse = deceleration_time_inverse;
+    #endif
     #if ENABLED(ADVANCE)
       block->initial_advance = initial_advance;
       block->final_advance = final_advance;
@@ -190,6 +236,8 @@ void Planner::reverse_pass_kernel(block_t* current, block_t* next) {
   if (!current) return;
 
   if (next) {
+    kernel_calls++;
+
     // If entry speed is already at the maximum entry speed, no need to recheck. Block is cruising.
     // If not, block in state of acceleration or deceleration. Reset entry speed to maximum and
     // check for maximum allowable speed reductions to ensure maximum possible planned speed.
@@ -214,33 +262,29 @@ void Planner::reverse_pass_kernel(block_t* current, block_t* next) {
 /**
  * recalculate() needs to go over the current plan twice.
  * Once in reverse and once forward. This implements the reverse pass.
+ *
+ * The pass starts from the newest block and stops at block_buffer_planned,
+ * the first block whose entry speed can't be improved anymore.
  */
 void Planner::reverse_pass() {
-
-  if (movesplanned() > 3) {
-
-    block_t* block[3] = { NULL, NULL, NULL };
-
-    // Make a local copy of block_buffer_tail, because the interrupt can alter it
-    CRITICAL_SECTION_START;
-      uint8_t tail = block_buffer_tail;
-    CRITICAL_SECTION_END
-
-    uint8_t b = BLOCK_MOD(block_buffer_head - 3);
-    while (b != tail) {
-      b = prev_block_index(b);
-      block[2] = block[1];
-      block[1] = block[0];
-      block[0] = &block_buffer[b];
-      reverse_pass_kernel(block[1], block[2]);
-    }
+  block_t* next = NULL;
+  uint8_t b = block_buffer_head;
+
+  while (b != block_buffer_planned) {
+    b = prev_block_index(b);
+    if (b == block_buffer_planned) break;
+    block_t* current = &block_buffer[b];
+    reverse_pass_kernel(current, next);
+    next = current;
   }
 }
 
 // The kernel called by recalculate() when scanning the plan from first to last entry.
-void Planner::forward_pass_kernel(block_t* previous, block_t* current) {
+void Planner::forward_pass_kernel(block_t* previous, block_t* current, uint8_t block_index) {
   if (!previous) return;
 
+  kernel_calls++;
+
   // If the previous block is an acceleration block, but it is not long enough to complete the
   // full speed change within the block, we need to adjust the entry speed accordingly. Entry
   // speeds have already been reset, maximized, and reverse planned by reverse planner.
@@ -253,9 +297,17 @@ void Planner::forward_pass_kernel(block_t* previous, block_t* current) {
       if (current->entry_speed != entry_speed) {
         current->entry_speed = entry_speed;
         current->recalculate_flag = true;
+        // The block is accelerating as hard as it can: the plan is optimal up to here
+        block_buffer_planned = block_index;
       }
     }
   }
+
+  // A block at its maximum entry speed also closes an optimal plan. Every block before
+  // it is bracketed by the start of the buffer or by another maximum entry speed, so
+  // it can't be improved anymore and the next passes can stop here.
+  if (current->entry_speed == current->max_entry_speed)
+    block_buffer_planned = block_index;
 }
 
 /**
@@ -263,24 +315,21 @@ void Planner::forward_pass_kernel(block_t* previous, block_t* current) {
  * Once in reverse and once forward. This implements the forward pass.
  */
 void Planner::forward_pass() {
-  block_t* block[3] = { NULL, NULL, NULL };
+  block_t* previous = NULL;
 
-  for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
-    block[0] = block[1];
-    block[1] = block[2];
-    block[2] = &block_buffer[b];
-    forward_pass_kernel(block[0], block[1]);
+  for (uint8_t b = block_buffer_planned; b != block_buffer_head; b = next_block_index(b)) {
+    block_t* current = &block_buffer[b];
+    forward_pass_kernel(previous, current, b);
+    previous = current;
   }
-  forward_pass_kernel(block[1], block[2]);
 }
 
 /**
- * Recalculate the trapezoid speed profiles for all blocks in the plan
- * according to the entry_factor for each junction. Must be called by
- * recalculate() after updating the blocks.
+ * Recalculate the trapezoid speed profiles for the blocks in the plan starting
+ * from block_index, according to the entry_factor for each junction. Must be
+ * called by recalculate() after updating the blocks.
  */
-void Planner::recalculate_trapezoids() {
-  int8_t block_index = block_buffer_tail;
+void Planner::recalculate_trapezoids(uint8_t block_index) {
   block_t* current;
   block_t* next = NULL;
 
@@ -331,11 +380,105 @@ void Planner::recalculate_trapezoids() {
  *   3. Recalculate "trapezoids" for all blocks.
  */
 void Planner::recalculate() {
+
+  // Make a local copy of block_buffer_tail, because the interrupt can alter it
+  CRITICAL_SECTION_START;
+    uint8_t tail = block_buffer_tail;
+  CRITICAL_SECTION_END
+
+  // Blocks taken by the stepper (busy) can't be replanned, and neither can the
+  // entry speed of the block after them: it's the exit speed they run with.
+  // With STEP_EVENT_QUEUE several blocks past the tail may be busy.
+  uint8_t nonbusy = tail;
+  while (nonbusy != block_buffer_head && block_buffer[nonbusy].busy) nonbusy = next_block_index(nonbusy);
+
+  // If the optimal plan pointer fell behind that block (or the buffer was flushed) restart from it
+  if (BLOCK_MOD(block_buffer_planned - tail) > BLOCK_MOD(block_buffer_head - tail)
+      || BLOCK_MOD(block_buffer_planned - tail) < BLOCK_MOD(nonbusy - tail))
+    block_buffer_planned = nonbusy;
+
+  // A block queued after the stepper took the previous one starts at the speed that one ends with
+  if (nonbusy != tail && nonbusy != block_buffer_head) {
+    const block_t* busy = &block_buffer[prev_block_index(nonbusy)];
+    block_t* next = &block_buffer[nonbusy];
+    const float exit_speed = busy->final_rate * busy->millimeters / busy->step_event_count;
+    if (next->entry_speed != exit_speed) {
+      next->entry_speed = exit_speed;
+      next->recalculate_flag = true;
+    }
+  }
+
+  // The block before the first non optimal one has its exit speed changed too
+  uint8_t first = block_buffer_planned == tail ? tail : prev_block_index(block_buffer_planned);
+
   reverse_pass();
   forward_pass();
-  recalculate_trapezoids();
+  recalculate_trapezoids(first);
+  planned_blocks++;
 }
 
+/**
+ * With DEBUG_PLANNER (M111 S64) print each block once its profile is final,
+ * with the time the move takes at the planned speeds. A block is final when
+ * it's behind block_buffer_planned or the stepper has taken it. The speeds
+ * come from the block's own trapezoid, so they are the ones the stepper runs.
+ * Called from idle(), outside the planning path, so blocks that are reused
+ * before idle() runs are only counted. test/planner_sim replays a file on
+ * the host with every block and the step times.
+ */
+void Planner::trace_blocks() {
+
+  if (!DEBUGGING(PLANNER)) {
+    block_buffer_traced = block_buffer_head;
+    traced_time = 0.0;
+    traced_dropped = 0;
+    return;
+  }
+
+  if (traced_dropped) {
+    SERIAL_LMV(DEB, "Blocks not traced:", traced_dropped);
+    traced_dropped = 0;
+  }
+
+  while (block_buffer_traced != block_buffer_head) {
+    CRITICAL_SECTION_START;
+      const uint8_t tail = block_buffer_tail;
+    CRITICAL_SECTION_END;
+
+    const uint8_t b = block_buffer_traced;
+    const block_t* block = &block_buffer[b];
+    const bool in_buffer = BLOCK_MOD(b - tail) < BLOCK_MOD(block_buffer_head - tail);
+    if (in_buffer && !block->busy && BLOCK_MOD(b - tail) >= BLOCK_MOD(block_buffer_planned - tail)) break;
+
+    const float mm_per_step = block->millimeters / block->step_event_count,
+                v0 = block->initial_rate * mm_per_step,
+                v1 = block->final_rate * mm_per_step,
+                a = block->acceleration,
+                L = block->millimeters;
+    float vc = block->nominal_speed,
+          accel_mm = (sq(vc) - sq(v0)) / (2.0 * a),
+          decel_mm = (sq(vc) - sq(v1)) / (2.0 * a),
+          cruise_mm = L - accel_mm - decel_mm;
+
+    if (cruise_mm < 0) {
+      // The nominal speed is never reached, find the peak speed
+      vc = sqrt((2.0 * a * L + sq(v0) + sq(v1)) * 0.5);
+      cruise_mm = 0;
+    }
+
+    const float t = (vc - v0) / a + (vc - v1) / a + cruise_mm / vc;
+    traced_time += t;
+    block_buffer_traced = next_block_index(b);
+
+    SERIAL_SMV(DEB, "Block mm:", L);
+    SERIAL_MV(" v0:", v0);
+    SERIAL_MV(" vc:", vc);
+    SERIAL_MV(" v1:", v1);
+    SERIAL_MV(" a:", a);
+    SERIAL_MV(" t:", t, 4);
+    SERIAL_EMV(" time:", traced_time, 3);
+  }
+}
 
 #if ENABLED(AUTOTEMP)
 
@@ -490,6 +633,12 @@ void Planner::check_axes_activity() {
   // Rest here until there is room in the buffer.
   while (block_buffer_tail == next_buffer_head) idle();
 
+  // DEBUG_PLANNER doesn't hold up the planner, a block it hasn't printed yet is skipped
+  if (block_buffer_traced == next_buffer_head) {
+    block_buffer_traced = next_block_index(block_buffer_traced);
+    if (DEBUGGING(PLANNER)) traced_dropped++;
+  }
+
   #if ENABLED(MESH_BED_LEVELING) && NOMECH(DELTA)
     if (mbl.active())
       z += mbl.get_z(x - home_offset[X_AXIS], y - home_offset[Y_AXIS]);
@@ -561,6 +710,9 @@ void Planner::check_axes_activity() {
 
   // Mark block as not busy (Not executed by the stepper interrupt)
   block->busy = false;
+  #if ENABLED(BLOCK_PREPARATION_ISR)
+    block->prepared = false;
+  #endif
 
   #if MECH(COREXY)
     long da = dx + COREX_YZ_FACTOR * dy;
@@ -844,7 +996,8 @@ void Planner::check_axes_activity() {
   #endif
   delta_mm[E_AXIS] = 0.01 * (de * steps_to_mm[E_AXIS + extruder]) * volumetric_multiplier[extruder] * flow_percentage[extruder];
 
-  if (block->steps[X_AXIS] <= MIN_SEGMENTS_FOR_MOVE && block->steps[Y_AXIS] <= MIN_SEGMENTS_FOR_MOVE && block->steps[Z_AXIS] <= MIN_SEGMENTS_FOR_MOVE) {
+  bool extrude_only = block->steps[X_AXIS] <= MIN_SEGMENTS_FOR_MOVE && block->steps[Y_AXIS] <= MIN_SEGMENTS_FOR_MOVE && block->steps[Z_AXIS] <= MIN_SEGMENTS_FOR_MOVE;
+  if (extrude_only) {
     block->millimeters = fabs(delta_mm[E_AXIS]);
   }
   else {
@@ -870,22 +1023,13 @@ void Planner::check_axes_activity() {
     // interval between steps for X, Y, Z, E, L to feed to the motion control code.
     if (laser.mode == RASTER || laser.mode == PULSED) {
       block->steps_l = labs(1000 * block->millimeters * laser.ppm);
-      for (int i = 0; i < LASER_MAX_RASTER_LINE; i++) {
-        // Scale the image intensity based on the raster power.
-        // 100% power on a pixel basis is 255, convert back to 255 = 100.
-        int OldRange, NewRange;
-        float NewValue;
-
-        OldRange = (255.0 - 0.0);
-        NewRange = (laser.rasterlaserpower * 255.0 / 100.0 - LASER_REMAP_INTENSITY);
-        NewValue = (float)(((((float)laser.raster_data[i] - 0) * NewRange) / OldRange) + LASER_REMAP_INTENSITY);
-
-        // If less than 7%, turn off the laser tube.
-        if (NewValue <= LASER_REMAP_INTENSITY)
-          NewValue = 0;
-
-        block->laser_raster_data[i] = NewValue;
-      }
+      #if ENABLED(LASER_RASTER)
+        // Point the block at the scaled raster line, the stepper releases it when done
+        if (laser.mode == RASTER) {
+          block->laser_raster_line = laser.raster_line;
+          laser_raster_line_retain(laser.raster_line);
+        }
+      #endif
     }
     else
       block->steps_l = 0;
@@ -972,6 +1116,14 @@ void Planner::check_axes_activity() {
     if (cs > mf) speed_factor = min(speed_factor, mf / cs);
   }
 
+  #if ENABLED(INPUT_SHAPING)
+    // The shaping ISR can't step the X and Y motors faster than SHAPING_MAX_STEP_RATE
+    for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+      const float step_rate = block->steps[i] * inverse_mm_s;
+      if (step_rate > SHAPING_MAX_STEP_RATE) speed_factor = min(speed_factor, (SHAPING_MAX_STEP_RATE) / step_rate);
+    }
+  #endif
+
   // Max segement time in us.
   #if ENABLED(XY_FREQUENCY_LIMIT)
 
@@ -1050,16 +1202,30 @@ void Planner::check_axes_activity() {
     block->acceleration_rate = (long)(acc_st * 16777216.0 / ((F_CPU) * 0.125));
   #endif
 
-  #if 0  // Use old jerk for now
+  #if ENABLED(JUNCTION_DEVIATION)
 
-    float junction_deviation = 0.1;
-
-    // Compute path unit vector
-    double unit_vec[3];
-
-    unit_vec[X_AXIS] = delta_mm[X_AXIS] * inverse_millimeters;
-    unit_vec[Y_AXIS] = delta_mm[Y_AXIS] * inverse_millimeters;
-    unit_vec[Z_AXIS] = delta_mm[Z_AXIS] * inverse_millimeters;
+    // Compute path unit vector. Extruder only moves travel along E.
+    float unit_vec[NUM_AXIS];
+    if (extrude_only) {
+      unit_vec[X_AXIS] = unit_vec[Y_AXIS] = unit_vec[Z_AXIS] = 0.0;
+      unit_vec[E_AXIS] = delta_mm[E_AXIS] * inverse_millimeters;
+    }
+    else {
+      #if MECH(COREXY) || MECH(COREYX)
+        unit_vec[X_AXIS] = delta_mm[X_HEAD] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_HEAD] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_AXIS] * inverse_millimeters;
+      #elif MECH(COREXZ) || MECH(COREZX)
+        unit_vec[X_AXIS] = delta_mm[X_HEAD] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_AXIS] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_HEAD] * inverse_millimeters;
+      #else
+        unit_vec[X_AXIS] = delta_mm[X_AXIS] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_AXIS] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_AXIS] * inverse_millimeters;
+      #endif
+      unit_vec[E_AXIS] = 0.0;
+    }
 
     // Compute maximum allowable entry speed at junction by centripetal acceleration approximation.
     // Let a circle be tangent to both previous and current path line segments, where the junction
@@ -1070,57 +1236,64 @@ void Planner::check_axes_activity() {
     // path width or max_jerk in the previous grbl version. This approach does not actually deviate
     // from path, but used as a robust way to compute cornering speeds, as it takes into account the
     // nonlinearities of both the junction angle and junction velocity.
-    double vmax_junction = MINIMUM_PLANNER_SPEED; // Set default max junction speed
+    float vmax_junction = min(MINIMUM_PLANNER_SPEED, block->nominal_speed); // Set default max junction speed
+    float safe_speed = vmax_junction;
 
     // Skip first block or when previous_nominal_speed is used as a flag for homing and offset cycles.
-    if ((block_buffer_head != block_buffer_tail) && (previous_nominal_speed > 0.0)) {
-      // Compute cosine of angle between previous and current path. (prev_unit_vec is negative)
+    if ((moves_queued > 1) && (previous_nominal_speed > 0.0001)) {
+      // Compute cosine of angle between previous and current path. (previous_unit_vec is negative)
       // NOTE: Max junction velocity is computed without sin() or acos() by trig half angle identity.
-      double cos_theta = - previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
-                         - previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS]
-                         - previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS] ;
-      // Skip and use default max junction speed for 0 degree acute junction.
-      if (cos_theta < 0.95) {
+      float cos_theta = - previous_unit_vec[X_AXIS] * unit_vec[X_AXIS]
+                        - previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS]
+                        - previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS]
+                        - previous_unit_vec[E_AXIS] * unit_vec[E_AXIS];
+
+      // Skip and use default max junction speed for a full reversal (0 degree acute junction).
+      if (cos_theta < 0.999999) {
         vmax_junction = min(previous_nominal_speed, block->nominal_speed);
         // Skip and avoid divide by zero for straight junctions at 180 degrees. Limit to min() of nominal speeds.
-        if (cos_theta > -0.95) {
+        if (cos_theta > -0.999999) {
           // Compute maximum junction velocity based on maximum acceleration and junction deviation
-          double sin_theta_d2 = sqrt(0.5 * (1.0 - cos_theta)); // Trig half angle identity. Always positive.
+          float sin_theta_d2 = sqrt(0.5 * (1.0 - cos_theta)); // Trig half angle identity. Always positive.
           vmax_junction = min(vmax_junction,
-                              sqrt(block->acceleration * junction_deviation * sin_theta_d2 / (1.0 - sin_theta_d2)));
+                              sqrt(block->acceleration * junction_deviation_mm * sin_theta_d2 / (1.0 - sin_theta_d2)));
         }
       }
     }
-  #endif
 
-  // Start with a safe speed
-  float vmax_junction = max_xy_jerk * 0.5,
-        vmax_junction_factor = 1.0,
-        mz2 = max_z_jerk * 0.5,
-        me2 = max_e_jerk[extruder] * 0.5,
-        csz = current_speed[Z_AXIS],
-        cse = current_speed[E_AXIS];
-  if (fabs(csz) > mz2) vmax_junction = min(vmax_junction, mz2);
-  if (fabs(cse) > me2) vmax_junction = min(vmax_junction, me2);
-  vmax_junction = min(vmax_junction, block->nominal_speed);
-  float safe_speed = vmax_junction;
-
-  if ((moves_queued > 1) && (previous_nominal_speed > 0.0001)) {
-    float dsx = current_speed[X_AXIS] - previous_speed[X_AXIS],
-          dsy = current_speed[Y_AXIS] - previous_speed[Y_AXIS],
-          dsz = fabs(csz - previous_speed[Z_AXIS]),
-          dse = fabs(cse - previous_speed[E_AXIS]),
-          jerk = HYPOT(dsx, dsy);
-
-    //    if ((fabs(previous_speed[X_AXIS]) > 0.0001) || (fabs(previous_speed[Y_AXIS]) > 0.0001)) {
-    vmax_junction = block->nominal_speed;
-    //    }
-    if (jerk > max_xy_jerk) vmax_junction_factor = max_xy_jerk / jerk;
-    if (dsz > max_z_jerk) vmax_junction_factor = min(vmax_junction_factor, max_z_jerk / dsz);
-    if (dse > max_e_jerk[extruder]) vmax_junction_factor = min(vmax_junction_factor, max_e_jerk[extruder] / dse);
-
-    vmax_junction = min(previous_nominal_speed, vmax_junction * vmax_junction_factor); // Limit speed to max previous speed
-  }
+  #else // !JUNCTION_DEVIATION
+
+    // Start with a safe speed
+    float vmax_junction = max_xy_jerk * 0.5,
+          vmax_junction_factor = 1.0,
+          mz2 = max_z_jerk * 0.5,
+          me2 = max_e_jerk[extruder] * 0.5,
+          csz = current_speed[Z_AXIS],
+          cse = current_speed[E_AXIS];
+    if (fabs(csz) > mz2) vmax_junction = min(vmax_junction, mz2);
+    if (fabs(cse) > me2) vmax_junction = min(vmax_junction, me2);
+    vmax_junction = min(vmax_junction, block->nominal_speed);
+    float safe_speed = vmax_junction;
+
+    if ((moves_queued > 1) && (previous_nominal_speed > 0.0001)) {
+      float dsx = current_speed[X_AXIS] - previous_speed[X_AXIS],
+            dsy = current_speed[Y_AXIS] - previous_speed[Y_AXIS],
+            dsz = fabs(csz - previous_speed[Z_AXIS]),
+            dse = fabs(cse - previous_speed[E_AXIS]),
+            jerk = HYPOT(dsx, dsy);
+
+      //    if ((fabs(previous_speed[X_AXIS]) > 0.0001) || (fabs(previous_speed[Y_AXIS]) > 0.0001)) {
+      vmax_junction = block->nominal_speed;
+      //    }
+      if (jerk > max_xy_jerk) vmax_junction_factor = max_xy_jerk / jerk;
+      if (dsz > max_z_jerk) vmax_junction_factor = min(vmax_junction_factor, max_z_jerk / dsz);
+      if (dse > max_e_jerk[extruder]) vmax_junction_factor = min(vmax_junction_factor, max_e_jerk[extruder] / dse);
+
+      vmax_junction = min(previous_nominal_speed, vmax_junction * vmax_junction_factor); // Limit speed to max previous speed
+    }
+
+  #endif // !JUNCTION_DEVIATION
+
   block->max_entry_speed = vmax_junction;
 
   // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
@@ -1140,6 +1313,9 @@ void Planner::check_axes_activity() {
 
   // Update previous path unit_vector and nominal speed
   LOOP_XYZE(i) previous_speed[i] = current_speed[i];
+  #if ENABLED(JUNCTION_DEVIATION)
+    LOOP_XYZE(i) previous_unit_vec[i] = unit_vec[i];
+  #endif
   previous_nominal_speed = block->nominal_speed;
 
   #if ENABLED(ADVANCE)
@@ -1150,7 +1326,7 @@ void Planner::check_axes_activity() {
     }
     else {
       long acc_dist = estimate_acceleration_distance(0, block->nominal_rate, block->acceleration_steps_per_s2);
-      float advance = ((STEPS_PER_CUBIC_MM_E) * (EXTRUDER_ADVANCE_K)) * HYPOT(cse, EXTRUSION_AREA) * 256;
+      float advance = ((STEPS_PER_CUBIC_MM_E) * (EXTRUDER_ADVANCE_K)) * HYPOT(current_speed[E_AXIS], EXTRUSION_AREA) * 256;
       block->advance = advance;
       block->advance_rate = acc_dist ? advance / (float)acc_dist : 0;
     }
@@ -1175,6 +1351,11 @@ void Planner::check_axes_activity() {
 
   calculate_trapezoid_for_block(block, block->entry_speed / block->nominal_speed, safe_speed / block->nominal_speed);
 
+  #if ENABLED(STEP_EVENT_QUEUE)
+    // The step event producer mustn't take the new block before it's planned
+    stepper.lock_step_queue();
+  #endif
+
   // Move buffer head
   block_buffer_head = next_buffer_head;
 
@@ -1183,6 +1364,10 @@ void Planner::check_axes_activity() {
 
   recalculate();
 
+  #if ENABLED(STEP_EVENT_QUEUE)
+    stepper.unlock_step_queue();
+  #endif
+
   stepper.wake_up();
 
 } // buffer_line()
@@ -1237,6 +1422,9 @@ void Planner::check_axes_activity() {
   previous_nominal_speed = 0.0; // Resets planner junction speeds. Assumes start from rest.
 
   LOOP_XYZE(i) previous_speed[i] = 0.0;
+  #if ENABLED(JUNCTION_DEVIATION)
+    LOOP_XYZE(i) previous_unit_vec[i] = 0.0;
+  #endif
 }
 
 /**
@@ -92,6 +92,14 @@ typedef struct {
                 final_rate,                          // The minimal rate at exit
                 acceleration_steps_per_s2;           // acceleration steps/sec^2
 
+  #if ENABLED(S_CURVE_ACCELERATION)
+    unsigned long cruise_rate,                       // The step rate reached at the end of the acceleration phase
+                  acceleration_time,                 // Duration of the acceleration phase in stepper timer ticks
+                  deceleration_time,                 // Duration of the deceleration phase in stepper timer ticks
+                  acceleration_time_inverse,         // 2^32 / acceleration_time, to map timer ticks on the Bezier curve
+                  deceleration_time_inverse;         // 2^32 / deceleration_time
+  #endif
+
   unsigned long fan_speed;
 
   #if ENABLED(BARICUDA)
@@ -106,12 +114,16 @@ typedef struct {
     unsigned long steps_l; // step count between firings of the laser, for pulsed firing mode
     float laser_intensity; // Laser firing instensity in clock cycles for the PWM timer
     #if ENABLED(LASER_RASTER)
-      unsigned char laser_raster_data[LASER_MAX_RASTER_LINE];
+      uint8_t laser_raster_line; // index of the raster line in the laser raster pool, for raster firing mode
     #endif
   #endif 
 
   volatile char busy;
 
+  #if ENABLED(BLOCK_PREPARATION_ISR)
+    volatile bool prepared;                 // The stepper holds the rate state of this block, cleared on replanning
+  #endif
+
 } block_t;
 
 #define BLOCK_MOD(n) ((n)&(BLOCK_BUFFER_SIZE-1))
@@ -127,6 +139,12 @@ class Planner {
     static volatile uint8_t block_buffer_head;           // Index of the next block to be pushed
     static volatile uint8_t block_buffer_tail;
 
+    /**
+     * Look-ahead statistics, reported by M123
+     */
+    static uint32_t planned_blocks,                // Blocks added to the plan
+                    kernel_calls;                  // Reverse and forward pass kernel invocations
+
     static float  max_feedrate_mm_s[3 + EXTRUDERS], // Max speeds in mm per second
                   axis_steps_per_mm[3 + EXTRUDERS],
                   steps_to_mm[3 + EXTRUDERS];
@@ -144,6 +162,10 @@ class Planner {
                   max_z_jerk,
                   max_e_jerk[EXTRUDERS];
 
+    #if ENABLED(JUNCTION_DEVIATION)
+      static float junction_deviation_mm;          // Distance from the junction to the edge of the cornering circle. M205 JXXXX
+    #endif
+
     /**
      * The current position of the tool in absolute steps
      * Reclculated if any axis_steps_per_mm are changed by gcode
@@ -166,6 +188,29 @@ class Planner {
      */
     static float previous_nominal_speed;
 
+    /**
+     * Index of the first block whose entry speed can't be improved anymore.
+     * It and the blocks before it are optimally planned, recalculate() only
+     * changes the entry speeds of the blocks after it.
+     */
+    static uint8_t block_buffer_planned;
+
+    /**
+     * Index of the first block not yet printed by DEBUG_PLANNER, virtual
+     * time (s) of the printed blocks and blocks reused before idle()
+     * could print them
+     */
+    static uint8_t block_buffer_traced;
+    static float traced_time;
+    static uint16_t traced_dropped;
+
+    #if ENABLED(JUNCTION_DEVIATION)
+      /**
+       * Unit vector of previous path line segment
+       */
+      static float previous_unit_vec[NUM_AXIS];
+    #endif
+
     #if ENABLED(DISABLE_INACTIVE_EXTRUDER)
       /**
        * Counters to manage disabling inactive extruders
@@ -265,8 +310,14 @@ class Planner {
      * Called when the current block is no longer needed.
      */
     static void discard_current_block() {
-      if (blocks_queued())
+      if (blocks_queued()) {
+        #if ENABLED(LASERBEAM) && ENABLED(LASER_RASTER)
+          // Give the raster line back to the pool
+          const block_t* block = &block_buffer[block_buffer_tail];
+          if (block->laser_mode == RASTER) laser_raster_line_release(block->laser_raster_line);
+        #endif
         block_buffer_tail = BLOCK_MOD(block_buffer_tail + 1);
+      }
     }
 
     /**
@@ -283,6 +334,20 @@ class Planner {
         return NULL;
     }
 
+    /**
+     * The block the stepper is running or will run next,
+     * without marking it busy. NULL if the buffer is empty.
+     */
+    static const block_t* peek_current_block() {
+      return blocks_queued() ? &block_buffer[block_buffer_tail] : NULL;
+    }
+
+    /**
+     * Print the blocks whose profile became final since the last call,
+     * with DEBUG_PLANNER. Called from idle().
+     */
+    static void trace_blocks();
+
     #if ENABLED(AUTOTEMP)
       static float autotemp_max;
       static float autotemp_min;
@@ -297,8 +362,8 @@ class Planner {
     /**
      * Get the index of the next / previous block in the ring buffer
      */
-    static int8_t next_block_index(int8_t block_index) { return BLOCK_MOD(block_index + 1); }
-    static int8_t prev_block_index(int8_t block_index) { return BLOCK_MOD(block_index - 1); }
+    static uint8_t next_block_index(uint8_t block_index) { return BLOCK_MOD(block_index + 1); }
+    static uint8_t prev_block_index(uint8_t block_index) { return BLOCK_MOD(block_index - 1); }
 
     /**
      * Calculate the distance (not time) it takes to accelerate
@@ -331,15 +396,23 @@ class Planner {
       return sqrt(target_velocity * target_velocity - 2 * accel * distance);
     }
 
+    #if ENABLED(S_CURVE_ACCELERATION)
+      /**
+       * Return the 0.32 fixed point inverse of a period in timer ticks,
+       * used by the stepper to evaluate the Bezier speed curve.
+       */
+      static uint32_t get_period_inverse(uint32_t d) { return d ? 0xFFFFFFFF / d : 0xFFFFFFFF; }
+    #endif
+
     static void calculate_trapezoid_for_block(block_t* block, float entry_factor, float exit_factor);
 
     static void reverse_pass_kernel(block_t* current, block_t* next);
-    static void forward_pass_kernel(block_t* previous, block_t* current);
+    static void forward_pass_kernel(block_t* previous, block_t* current, uint8_t block_index);
 
     static void reverse_pass();
     static void forward_pass();
 
-    static void recalculate_trapezoids();
+    static void recalculate_trapezoids(uint8_t block_index);
 
     static void recalculate();
 
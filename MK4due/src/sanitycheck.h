@@ -52,6 +52,12 @@
   #if DISABLED(MACHINE_UUID)
     #error DEPENDENCY ERROR: Missing setting MACHINE_UUID
   #endif
+  #if ENABLED(AUTO_REPORT_BINARY) && DISABLED(AUTO_REPORT)
+    #error DEPENDENCY ERROR: You must set AUTO_REPORT to use AUTO_REPORT_BINARY
+  #endif
+  #if ENABLED(BINARY_GCODE) && DISABLED(BINARY_GCODE_TIMEOUT)
+    #error DEPENDENCY ERROR: Missing setting BINARY_GCODE_TIMEOUT
+  #endif
 
   // Board
   #if DISABLED(MOTHERBOARD)
@@ -253,6 +259,19 @@
       #error DEPENDENCY ERROR: Missing setting DEFAULT_Kd
     #endif
   #endif
+  #if ENABLED(MPCTEMP)
+    #if ENABLED(PIDTEMP)
+      #error MPCTEMP replaces the hotend PID, disable PIDTEMP.
+    #elif DISABLED(MPC_HEATER_POWER) || DISABLED(MPC_BLOCK_HEAT_CAPACITY) || DISABLED(MPC_SENSOR_RESPONSIVENESS)
+      #error DEPENDENCY ERROR: Missing setting MPC_HEATER_POWER, MPC_BLOCK_HEAT_CAPACITY or MPC_SENSOR_RESPONSIVENESS
+    #elif DISABLED(MPC_AMBIENT_XFER_COEFF) || DISABLED(MPC_AMBIENT_XFER_COEFF_FAN255) || DISABLED(MPC_FILAMENT_HEAT_CAPACITY_PERMM)
+      #error DEPENDENCY ERROR: Missing setting MPC_AMBIENT_XFER_COEFF, MPC_AMBIENT_XFER_COEFF_FAN255 or MPC_FILAMENT_HEAT_CAPACITY_PERMM
+    #elif DISABLED(MPC_SMOOTHING_FACTOR) || DISABLED(MPC_MIN_AMBIENT_CHANGE) || DISABLED(MPC_STEADYSTATE) || DISABLED(MPC_TUNING_TEMP)
+      #error DEPENDENCY ERROR: Missing setting MPC_SMOOTHING_FACTOR, MPC_MIN_AMBIENT_CHANGE, MPC_STEADYSTATE or MPC_TUNING_TEMP
+    #elif ENABLED(SLOW_PWM_HEATERS)
+      #error MPCTEMP is not compatible with SLOW_PWM_HEATERS.
+    #endif
+  #endif
   #if ENABLED(PIDTEMPBED)
     #if DISABLED(PID_BED_INTEGRAL_DRIVE_MAX)
       #error DEPENDENCY ERROR: Missing setting PID_BED_INTEGRAL_DRIVE_MAX
@@ -785,8 +804,50 @@
       #error DEPENDENCY ERROR: Missing setting POWER_EFFICIENCY 
     #endif
   #endif
+  #if ENABLED(ADC_DMA)
+    #if DISABLED(ADC_DMA_UPDATE_FREQUENCY) || DISABLED(ADC_DMA_MEDIAN)
+      #error DEPENDENCY ERROR: Missing setting ADC_DMA_UPDATE_FREQUENCY or ADC_DMA_MEDIAN
+    #elif ADC_DMA_UPDATE_FREQUENCY < 16 || ADC_DMA_UPDATE_FREQUENCY > 1000
+      #error ADC_DMA_UPDATE_FREQUENCY must be between 16 and 1000.
+    #elif ADC_DMA_MEDIAN < 1 || ADC_DMA_MEDIAN > 9 || !(ADC_DMA_MEDIAN & 1)
+      #error ADC_DMA_MEDIAN must be odd and between 1 and 9.
+    #endif
+  #endif
 
   //addon
+  #if ENABLED(SD_EXTENT_MAP)
+    #if DISABLED(SDSUPPORT)
+      #error DEPENDENCY ERROR: You must set SDSUPPORT to use SD_EXTENT_MAP
+    #elif SD_EXTENT_MAP < 1 || SD_EXTENT_MAP > 255
+      #error SD_EXTENT_MAP must be between 1 and 255.
+    #endif
+  #endif
+  #if ENABLED(SD_DIR_INDEX)
+    #if DISABLED(SDSUPPORT)
+      #error DEPENDENCY ERROR: You must set SDSUPPORT to use SD_DIR_INDEX
+    #elif SD_DIR_INDEX < 1 || SD_DIR_INDEX > 255
+      #error SD_DIR_INDEX must be between 1 and 255.
+    #elif !defined(SD_DIR_INDEX_SORT) || SD_DIR_INDEX_SORT < 0 || SD_DIR_INDEX_SORT > 2
+      #error SD_DIR_INDEX_SORT must be 0, 1 or 2.
+    #endif
+  #endif
+  #if ENABLED(SD_BINARY_PRINT) && DISABLED(SDSUPPORT)
+    #error DEPENDENCY ERROR: You must set SDSUPPORT to use SD_BINARY_PRINT
+  #endif
+  #if ENABLED(SD_BINARY_UPLOAD)
+    #if DISABLED(SDSUPPORT)
+      #error DEPENDENCY ERROR: You must set SDSUPPORT to use SD_BINARY_UPLOAD
+    #elif !defined(SD_UPLOAD_BLOCKS) || SD_UPLOAD_BLOCKS < 1 || SD_UPLOAD_BLOCKS > 64
+      #error SD_UPLOAD_BLOCKS must be between 1 and 64.
+    #endif
+  #endif
+  #if ENABLED(SD_SPI_DMA)
+    #if DISABLED(SDSUPPORT)
+      #error DEPENDENCY ERROR: You must set SDSUPPORT to use SD_SPI_DMA
+    #elif defined(DUE_SOFTWARE_SPI)
+      #error SD_SPI_DMA requires the hardware SPI of the board.
+    #endif
+  #endif
   #if ENABLED(SDSUPPORT)
     #if DISABLED(SD_FINISHED_STEPPERRELEASE)
       #error DEPENDENCY ERROR: Missing setting SD_FINISHED_STEPPERRELEASE
@@ -1129,11 +1190,65 @@
     #endif
   #endif
   //buffer
+  #if ENABLED(ARC_SUPPORT) && ENABLED(ARC_CHORD_TOLERANCE)
+    #if DISABLED(ARC_CHORD_TOLERANCE_MM) || DISABLED(MIN_ARC_SEGMENT_MM) || DISABLED(MAX_ARC_SEGMENT_MM)
+      #error DEPENDENCY ERROR: Missing setting ARC_CHORD_TOLERANCE_MM, MIN_ARC_SEGMENT_MM or MAX_ARC_SEGMENT_MM
+    #endif
+  #endif
+  #if ENABLED(INPUT_SHAPING)
+    #if MECH(DELTA) || MECH(SCARA)
+      #error INPUT_SHAPING is only for Cartesian and Core machines.
+    #elif ENABLED(ENABLE_HIGH_SPEED_STEPPING)
+      #error INPUT_SHAPING is not compatible with ENABLE_HIGH_SPEED_STEPPING.
+    #elif DISABLED(SHAPING_TYPE_X) || DISABLED(SHAPING_TYPE_Y) || DISABLED(SHAPING_FREQ_X) || DISABLED(SHAPING_FREQ_Y) || DISABLED(SHAPING_ZETA_X) || DISABLED(SHAPING_ZETA_Y)
+      #error DEPENDENCY ERROR: Missing setting SHAPING_TYPE, SHAPING_FREQ or SHAPING_ZETA for X or Y
+    #elif DISABLED(SHAPING_MIN_FREQ) || DISABLED(SHAPING_ISR_FREQUENCY)
+      #error DEPENDENCY ERROR: Missing setting SHAPING_MIN_FREQ or SHAPING_ISR_FREQUENCY
+    #elif defined(SHAPING_BUFFER_SIZE)
+      #error SHAPING_BUFFER_SIZE is now sized from SHAPING_MIN_FREQ. Please remove it from your configuration.
+    #endif
+  #endif
+  #if ENABLED(STEP_EVENT_QUEUE)
+    #if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE) || ENABLED(LASERBEAM) || ENABLED(COLOR_MIXING_EXTRUDER) || ENABLED(INPUT_SHAPING) || ENABLED(Z_LATE_ENABLE)
+      #error STEP_EVENT_QUEUE is not compatible with ADVANCE, LIN_ADVANCE, LASERBEAM, COLOR_MIXING_EXTRUDER, INPUT_SHAPING or Z_LATE_ENABLE.
+    #elif ENABLED(ENABLE_HIGH_SPEED_STEPPING)
+      #error STEP_EVENT_QUEUE plays one step per interrupt, disable ENABLE_HIGH_SPEED_STEPPING.
+    #elif DISABLED(STEP_EVENT_QUEUE_SIZE) || DISABLED(STEP_EVENT_QUEUE_MS) || DISABLED(STEP_EVENT_PULSE_WIDTH)
+      #error DEPENDENCY ERROR: Missing setting STEP_EVENT_QUEUE_SIZE, STEP_EVENT_QUEUE_MS or STEP_EVENT_PULSE_WIDTH
+    #elif STEP_EVENT_QUEUE_SIZE & (STEP_EVENT_QUEUE_SIZE - 1)
+      #error STEP_EVENT_QUEUE_SIZE must be a power of 2.
+    #endif
+  #endif
+  #if ENABLED(ADAPTIVE_STEP_SMOOTHING)
+    #if ENABLED(ENABLE_HIGH_SPEED_STEPPING) || ENABLED(STEP_EVENT_QUEUE)
+      #error ADAPTIVE_STEP_SMOOTHING is not compatible with ENABLE_HIGH_SPEED_STEPPING or STEP_EVENT_QUEUE.
+    #elif ENABLED(LASERBEAM) || ENABLED(COLOR_MIXING_EXTRUDER)
+      #error ADAPTIVE_STEP_SMOOTHING is not compatible with LASERBEAM or COLOR_MIXING_EXTRUDER.
+    #elif DISABLED(AMASS_MAX_LEVEL) || DISABLED(AMASS_CUTOFF_FREQUENCY)
+      #error DEPENDENCY ERROR: Missing setting AMASS_MAX_LEVEL or AMASS_CUTOFF_FREQUENCY
+    #elif AMASS_MAX_LEVEL < 1 || AMASS_MAX_LEVEL > 4
+      #error AMASS_MAX_LEVEL must be between 1 and 4.
+    #endif
+  #endif
+  #if ENABLED(BLOCK_PREPARATION_ISR) && ENABLED(STEP_EVENT_QUEUE)
+    #error BLOCK_PREPARATION_ISR is not compatible with STEP_EVENT_QUEUE.
+  #endif
+  #if ENABLED(STEP_PORT_BATCHING)
+    #if ENABLED(DUAL_X_CARRIAGE) || ENABLED(Z_DUAL_ENDSTOPS)
+      #error STEP_PORT_BATCHING is not compatible with DUAL_X_CARRIAGE or Z_DUAL_ENDSTOPS.
+    #elif ENABLED(ENABLE_HIGH_SPEED_STEPPING)
+      #error STEP_PORT_BATCHING is not compatible with ENABLE_HIGH_SPEED_STEPPING.
+    #endif
+  #endif
   #if DISABLED(BLOCK_BUFFER_SIZE)
     #error DEPENDENCY ERROR: Missing setting BLOCK_BUFFER_SIZE
+  #elif BLOCK_BUFFER_SIZE > 128 || (BLOCK_BUFFER_SIZE & (BLOCK_BUFFER_SIZE - 1))
+    #error BLOCK_BUFFER_SIZE must be a power of 2 up to 128.
   #endif
   #if DISABLED(MAX_CMD_SIZE)
     #error DEPENDENCY ERROR: Missing setting MAX_CMD_SIZE
+  #elif MAX_CMD_SIZE > 255
+    #error MAX_CMD_SIZE must be 255 or less.
   #endif
   #if DISABLED(BUFSIZE)
     #error DEPENDENCY ERROR: Missing setting BUFSIZE
@@ -1311,6 +1426,9 @@
   #if DISABLED(DEFAULT_ZJERK)
     #error DEPENDENCY ERROR: Missing setting DEFAULT_ZJERK
   #endif
+  #if ENABLED(JUNCTION_DEVIATION) && DISABLED(JUNCTION_DEVIATION_MM)
+    #error DEPENDENCY ERROR: Missing setting JUNCTION_DEVIATION_MM
+  #endif
   #if DISABLED(X_HOME_BUMP_MM)
     #error DEPENDENCY ERROR: Missing setting X_HOME_BUMP_MM
   #endif
@@ -1878,6 +1996,14 @@
     #if (!ENABLED(LASER_REMAP_INTENSITY) && ENABLED(LASER_RASTER))
       #error DEPENDENCY ERROR: You have to set LASER_REMAP_INTENSITY with LASER_RASTER enabled
     #endif
+    #if ENABLED(G5_BEZIER) && DISABLED(BEZIER_FLATNESS_MM)
+      #error DEPENDENCY ERROR: Missing setting BEZIER_FLATNESS_MM
+    #endif
+    #if ENABLED(LASER_RASTER) && (DISABLED(LASER_RASTER_LINES) || LASER_RASTER_LINES < 2)
+      #error DEPENDENCY ERROR: You have to set LASER_RASTER_LINES to 2 or more with LASER_RASTER enabled
+    #elif ENABLED(LASER_RASTER) && LASER_RASTER_LINES > BLOCK_BUFFER_SIZE
+      #error LASER_RASTER_LINES must be BLOCK_BUFFER_SIZE or less.
+    #endif
     #if (!ENABLED(LASER_CONTROL) || ((LASER_CONTROL != 1) && (LASER_CONTROL != 2)))
        #error DEPENDENCY ERROR: You have to set LASER_CONTROL to 1 or 2
     #else
@@ -359,6 +359,9 @@ void (*SdBaseFile::dateTime_)(uint16_t* date, uint16_t* time) = 0;
 //------------------------------------------------------------------------------
 // add a cluster to a file
 bool SdBaseFile::addCluster() {
+  #if ENABLED(SD_EXTENT_MAP)
+  extents_ = NULL;
+  #endif
   if (!vol_->allocContiguous(1, &curCluster_)) {
     DBG_FAIL_MACRO;
     goto fail;
@@ -434,6 +437,9 @@ fail:
 bool SdBaseFile::close() {
   bool rtn = sync();
   type_ = FAT_FILE_TYPE_CLOSED;
+  #if ENABLED(SD_EXTENT_MAP)
+  extents_ = NULL;
+  #endif
   return rtn;
 }
 //------------------------------------------------------------------------------
@@ -473,10 +479,71 @@ bool SdBaseFile::contiguousRange(uint32_t* bgnBlock, uint32_t* endBlock) {
     }
   }
 
+fail:
+  return false;
+}
+#if ENABLED(SD_EXTENT_MAP)
+//------------------------------------------------------------------------------
+/** Map the clusters of a file as runs of contiguous clusters.
+ *
+ * The FAT chain is followed once. Until the file is closed or grows,
+ * read() and seekSet() then find clusters from the map with no FAT
+ * access. A contiguous file is a single run.
+ *
+ * \param[out] map Array that receives the runs, owned by the caller
+ * and kept until the file is closed.
+ * \param[in] size Number of entries in \a map.
+ *
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ * Reasons for failure include the file has more than \a size runs,
+ * is empty or is not a normal file, or an I/O error occurred.
+ */
+bool SdBaseFile::mapExtents(sd_extent_t* map, uint8_t size) {
+  uint32_t c = firstCluster_;
+  uint32_t count;
+  uint8_t n = 1;
+
+  extents_ = NULL;
+  if (type_ != FAT_FILE_TYPE_NORMAL || firstCluster_ == 0 || fileSize_ == 0 || size == 0) {
+    DBG_FAIL_MACRO;
+    goto fail;
+  }
+  // clusters holding data
+  count = ((fileSize_ - 1) >> (vol_->clusterSizeShift_ + 9)) + 1;
+  map[0].fileCluster = 0;
+  map[0].cluster = c;
+  for (uint32_t i = 1; i < count; i++) {
+    uint32_t next;
+    if (!vol_->fatGet(c, &next) || vol_->isEOC(next)) {
+      DBG_FAIL_MACRO;
+      goto fail;
+    }
+    if (next != c + 1) {
+      // start of a new run
+      if (n == size) goto fail;
+      map[n].fileCluster = i;
+      map[n].cluster = next;
+      n++;
+    }
+    c = next;
+  }
+  extents_ = map;
+  extentCount_ = n;
+  return true;
+
 fail:
   return false;
 }
 //------------------------------------------------------------------------------
+// volume cluster holding cluster index of the file, from the extent map
+uint32_t SdBaseFile::extentCluster(uint32_t index) {
+  uint8_t i = extentCount_ - 1;
+  while (i && extents_[i].fileCluster > index) i--;
+  return extents_[i].cluster + index - extents_[i].fileCluster;
+}
+#endif  // SD_EXTENT_MAP
+//------------------------------------------------------------------------------
 /** Create and open a new contiguous file of a specified size.
  *
  * \note This function only supports short DOS 8.3 names.
@@ -1049,7 +1116,7 @@ bool SdBaseFile::open(const char* path, uint8_t oflag) {
   SdBaseFile *parent = dirFile;
   //dir_t *pEntry;
   SdBaseFile *sub = &dir1;
-  char *p;
+  const char *p;
   //boolean bFound;
 
   *dname = 0;
@@ -1354,6 +1421,9 @@ bool SdBaseFile::openCachedEntry(uint8_t dirIndex, uint8_t oflag) {
   }
   // remember location of directory entry on SD
   dirBlock_ = vol_->cacheBlockNumber();
+  #if ENABLED(SD_EXTENT_MAP)
+  extents_ = NULL;
+  #endif
   dirIndex_ = dirIndex;
 
   // copy first cluster number for directory fields
@@ -1790,6 +1860,58 @@ fail:
   return false;
 }
 //------------------------------------------------------------------------------
+/** Get the device block of the current position and advance to the next block.
+ *
+ * Lets the caller read the file a whole block at a time with its own
+ * buffers, for example in the background. The current position must be
+ * at the start of a block.
+ *
+ * \param[out] block Raw device block number holding the current position.
+ *
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ */
+bool SdBaseFile::readBlockNumber(uint32_t* block) {
+  uint8_t blockOfCluster;
+
+  if (!isOpen() || !(flags_ & O_READ) || (curPosition_ & 0X1FF) || curPosition_ >= fileSize_) {
+    DBG_FAIL_MACRO;
+    goto fail;
+  }
+  blockOfCluster = vol_->blockOfCluster(curPosition_);
+  if (type_ == FAT_FILE_TYPE_ROOT_FIXED) {
+    *block = vol_->rootDirStart() + (curPosition_ >> 9);
+  }
+  else {
+    if (blockOfCluster == 0) {
+      // start of new cluster
+      if (curPosition_ == 0) {
+        // use first cluster in file
+        curCluster_ = firstCluster_;
+      }
+      #if ENABLED(SD_EXTENT_MAP)
+      else if (extents_) {
+        curCluster_ = extentCluster(curPosition_ >> (vol_->clusterSizeShift_ + 9));
+      }
+      #endif
+      else {
+        // get next cluster from FAT
+        if (!vol_->fatGet(curCluster_, &curCluster_)) {
+          DBG_FAIL_MACRO;
+          goto fail;
+        }
+      }
+    }
+    *block = vol_->clusterStartBlock(curCluster_) + blockOfCluster;
+  }
+  curPosition_ += 512;
+  if (curPosition_ > fileSize_) curPosition_ = fileSize_;
+  return true;
+
+fail:
+  return false;
+}
+//------------------------------------------------------------------------------
 /** Read the next byte from a file.
  *
  * \return For success read returns the next byte in the file as an int.
@@ -1846,6 +1968,11 @@ int SdBaseFile::read(void* buf, size_t nbyte) {
           // use first cluster in file
           curCluster_ = firstCluster_;
         }
+        #if ENABLED(SD_EXTENT_MAP)
+        else if (extents_) {
+          curCluster_ = extentCluster(curPosition_ >> (vol_->clusterSizeShift_ + 9));
+        }
+        #endif
         else {
           // get next cluster from FAT
           if (!vol_->fatGet(curCluster_, &curCluster_)) {
@@ -2405,6 +2532,9 @@ fail:
 SdBaseFile::SdBaseFile(const char* path, uint8_t oflag) {
   type_ = FAT_FILE_TYPE_CLOSED;
   writeError = false;
+  #if ENABLED(SD_EXTENT_MAP)
+  extents_ = NULL;
+  #endif
   open(path, oflag);
 }
 //------------------------------------------------------------------------------
@@ -2438,6 +2568,14 @@ bool SdBaseFile::seekSet(uint32_t pos) {
   nCur = (curPosition_ - 1) >> (vol_->clusterSizeShift_ + 9);
   nNew = (pos - 1) >> (vol_->clusterSizeShift_ + 9);
 
+  #if ENABLED(SD_EXTENT_MAP)
+  if (extents_) {
+    curCluster_ = extentCluster(nNew);
+    curPosition_ = pos;
+    goto done;
+  }
+  #endif
+
   if (nNew < nCur || curPosition_ == 0) {
     // must follow chain from first cluster
     curCluster_ = firstCluster_;
@@ -3089,11 +3227,20 @@ static uint16_t CRC_CCITT(const uint8_t* data, size_t n) {
 //------------------------------------------------------------------------------
 // send command and return error code.  Return zero for OK
 uint8_t Sd2Card::cardCommand(uint8_t cmd, uint32_t arg) {
+  #if ENABLED(SD_SPI_DMA)
+    // End the background multi-block read before any other command
+    if (streamOpen_ && cmd != CMD12) {
+      streamOpen_ = false;
+      streamBlock_ = 0xFFFFFFFF;
+      cardCommand(CMD12, 0);
+    }
+  #endif
+
   // select card
   chipSelectLow();
 
-  // wait up to 300 ms if busy
-  waitNotBusy(300);
+  // wait up to 300 ms if busy, CMD12 may interrupt a data transfer
+  if (cmd != CMD12) waitNotBusy(300);
 
   uint8_t *pa = reinterpret_cast<uint8_t *>(&arg);
 
@@ -3161,6 +3308,10 @@ void Sd2Card::chipSelectHigh() {
 }
 //------------------------------------------------------------------------------
 void Sd2Card::chipSelectLow() {
+  #if ENABLED(SD_SPI_DMA)
+    // A background read holds the card selected until it is finished
+    readBlockFinish();
+  #endif
   #ifndef SOFTWARE_SPI
     spiInit(spiRate_);
   #endif  // SOFTWARE_SPI
@@ -3238,6 +3389,12 @@ bool Sd2Card::eraseSingleBlockEnable() {
 bool Sd2Card::init(uint8_t sckRateID, uint8_t chipSelectPin) {
   errorCode_ = type_ = 0;
   chipSelectPin_ = chipSelectPin;
+  #if ENABLED(SD_SPI_DMA)
+    asyncDst_ = NULL;
+    asyncOk_ = true;
+    streamOpen_ = false;
+    streamBlock_ = 0xFFFFFFFF;
+  #endif
   // 16-bit init start time allows over a minute
   uint16_t t0 = (uint16_t)HAL::timeInMilliseconds();
   uint32_t arg;
@@ -3354,39 +3511,138 @@ bool Sd2Card::readData(uint8_t* dst) {
 //------------------------------------------------------------------------------
 bool Sd2Card::readData(uint8_t* dst, size_t count) {
   uint16_t crc;
-  // wait for start block token
+  if (!waitStartBlock()) goto fail;
+  // transfer data
+  if ((status_ = spiRec(dst, count))) {
+    error(SD_CARD_ERROR_SPI_DMA);
+    goto fail;
+  }
+  // get crc
+  crc = (spiRec() << 8) | spiRec();
+  #if USE_SD_CRC
+    if (crc != CRC_CCITT(dst, count)) {
+      error(SD_CARD_ERROR_READ_CRC);
+      goto fail;
+    }
+  #endif  // USE_SD_CRC
+
+  chipSelectHigh();
+  return true;
+
+fail:
+  chipSelectHigh();
+  return false;
+}
+//------------------------------------------------------------------------------
+/** Wait for the start block token of a data block */
+bool Sd2Card::waitStartBlock() {
   uint16_t t0 = HAL::timeInMilliseconds();
   while ((status_ = spiRec()) == 0XFF) {
     if (((uint16_t)HAL::timeInMilliseconds() - t0) > SD_READ_TIMEOUT) {
       error(SD_CARD_ERROR_READ_TIMEOUT);
-      goto fail;
+      return false;
     }
   }
   if (status_ != DATA_START_BLOCK) {
     error(SD_CARD_ERROR_READ);
-    goto fail;
+    return false;
   }
-  // transfer data
-  if ((status_ = spiRec(dst, count))) {
+  return true;
+}
+//------------------------------------------------------------------------------
+#if ENABLED(SD_SPI_DMA)
+// Card with a background read, finished before another device uses the bus
+static Sd2Card* asyncCard = NULL;
+static void asyncCardRelease() {
+  if (asyncCard) asyncCard->readBlockFinish();
+}
+//------------------------------------------------------------------------------
+/**
+ * Start reading a 512 byte block in the background.
+ *
+ * The command and start token are handled here, the data moves by DMA
+ * while the caller goes on. The card stays selected, any other access
+ * to the card or the SPI bus first completes the transfer.
+ *
+ * Blocks are read with CMD18 and the multi-block read is left open, so
+ * when the next call asks for the following block only its start token
+ * is awaited. Any other card command ends the read with CMD12 first.
+ *
+ * \param[in] blockNumber Logical block to be read.
+ * \param[out] dst Pointer to the location that will receive the data.
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ */
+bool Sd2Card::readBlockStart(uint32_t blockNumber, uint8_t* dst) {
+  SD_TRACE("RA", blockNumber);
+  if (streamOpen_ && blockNumber == streamBlock_) {
+    // The card sends this block next, no command needed
+    chipSelectLow();
+  }
+  else {
+    // use address if not SDHC card
+    if (cardCommand(CMD18, type() != SD_CARD_TYPE_SDHC ? blockNumber << 9 : blockNumber)) {
+      error(SD_CARD_ERROR_CMD18);
+      goto fail;
+    }
+    streamOpen_ = true;
+  }
+  streamBlock_ = 0xFFFFFFFF;
+  if (!waitStartBlock()) goto fail;
+  streamBlock_ = blockNumber + 1;
+
+  asyncDst_ = dst;
+  asyncOk_ = false;
+  asyncCard = this;
+  HAL::spiDmaRelease = asyncCardRelease;
+  HAL::spiDmaReadStart(dst, 512);
+  return true;
+
+fail:
+  chipSelectHigh();
+  return false;
+}
+//------------------------------------------------------------------------------
+/**
+ * Wait for the block started by readBlockStart() and check it.
+ *
+ * \return The value one, true, is returned if the last background read
+ * succeeded, the value zero, false, is returned for failure.
+ */
+bool Sd2Card::readBlockFinish() {
+  if (!asyncDst_) return asyncOk_;
+
+  uint8_t* dst = asyncDst_;
+  uint16_t crc;
+  asyncDst_ = NULL;
+  asyncCard = NULL;
+  HAL::spiDmaRelease = NULL;
+
+  if (!HAL::spiDmaFinish()) {
     error(SD_CARD_ERROR_SPI_DMA);
     goto fail;
   }
   // get crc
   crc = (spiRec() << 8) | spiRec();
   #if USE_SD_CRC
-    if (crc != CRC_CCITT(dst, count)) {
+    if (crc != CRC_CCITT(dst, 512)) {
       error(SD_CARD_ERROR_READ_CRC);
       goto fail;
     }
+  #else
+    UNUSED(crc);
+    UNUSED(dst);
   #endif  // USE_SD_CRC
 
   chipSelectHigh();
+  asyncOk_ = true;
   return true;
 
 fail:
   chipSelectHigh();
   return false;
 }
+#endif  // SD_SPI_DMA
 //------------------------------------------------------------------------------
 /** read CID or CSR register */
 bool Sd2Card::readRegister(uint8_t cmd, void* buf) {
@@ -653,6 +653,12 @@ class Sd2Card {
   bool readData(uint8_t *dst);
   bool readStart(uint32_t blockNumber);
   bool readStop();
+  #if ENABLED(SD_SPI_DMA)
+    bool readBlockStart(uint32_t blockNumber, uint8_t* dst);
+    bool readBlockFinish();
+    /** \return true while a readBlockStart() transfer is in progress. */
+    bool readBlockBusy() { return asyncDst_ && HAL::spiDmaBusy(); }
+  #endif
   bool setSckRate(uint8_t sckRateID);
   /** Return the card type: SD V1, SD V2 or SDHC
    * \return 0 - SD V1, 1 - SD V2, or 3 - SDHC.
@@ -670,6 +676,12 @@ class Sd2Card {
   uint8_t spiRate_;
   uint8_t status_;
   uint8_t type_;
+  #if ENABLED(SD_SPI_DMA)
+    uint8_t* asyncDst_;   // Block being read in the background, NULL if none
+    bool asyncOk_;        // Result of the last background read
+    bool streamOpen_;     // A CMD18 multi-block read is open, any other command ends it
+    uint32_t streamBlock_; // Block that the open read delivers next, 0xFFFFFFFF if unknown
+  #endif
   // private functions
   uint8_t cardAcmd(uint8_t cmd, uint32_t arg) {
     cardCommand(CMD55, 0);
@@ -678,6 +690,7 @@ class Sd2Card {
   uint8_t cardCommand(uint8_t cmd, uint32_t arg);
   bool readData(uint8_t* dst, size_t count);
   bool readRegister(uint8_t cmd, void* buf);
+  bool waitStartBlock();
   void chipSelectHigh();
   void chipSelectLow();
   void type(uint8_t value) {type_ = value;}
@@ -1518,6 +1531,20 @@ struct FatPos_t {
   FatPos_t() : position(0), cluster(0) {}
 };
 
+#if ENABLED(SD_EXTENT_MAP)
+//------------------------------------------------------------------------------
+/**
+ * \struct sd_extent_t
+ * \brief run of contiguous clusters in a file, see SdBaseFile::mapExtents()
+ */
+struct sd_extent_t {
+  /** index in the file of the first cluster of the run */
+  uint32_t fileCluster;
+  /** volume cluster number of the first cluster of the run */
+  uint32_t cluster;
+};
+#endif
+
 // use the gnu style oflag in open()
 /** open() oflag for reading */
 uint8_t const O_READ = 0X01;
@@ -1657,7 +1684,11 @@ uint16_t const FAT_DEFAULT_TIME = (1 << 11);
 class SdBaseFile {
  public:
   /** Create an instance. */
+  #if ENABLED(SD_EXTENT_MAP)
+  SdBaseFile() : writeError(false), type_(FAT_FILE_TYPE_CLOSED), extents_(NULL), extentCount_(0) {}
+  #else
   SdBaseFile() : writeError(false), type_(FAT_FILE_TYPE_CLOSED) {}
+  #endif
   SdBaseFile(const char* path, uint8_t oflag);
   #if DESTRUCTOR_CLOSES_FILE
   ~SdBaseFile() {if(isOpen()) close();}
@@ -1689,6 +1720,11 @@ class SdBaseFile {
   bool contiguousRange(uint32_t* bgnBlock, uint32_t* endBlock);
   bool createContiguous(SdBaseFile* dirFile,
                         const char* path, uint32_t size);
+  #if ENABLED(SD_EXTENT_MAP)
+  bool mapExtents(sd_extent_t* map, uint8_t size);
+  /** \return The number of runs in the extent map, zero if none. */
+  uint8_t extentCount() const {return extents_ ? extentCount_ : 0;}
+  #endif
   /** \return The current cluster number for a file or directory. */
   uint32_t curCluster() const {return curCluster_;}
   /** \return The current position for a file or directory. */
@@ -1777,6 +1813,7 @@ class SdBaseFile {
   bool printName();
   int16_t read();
   int read(void* buf, size_t nbyte);
+  bool readBlockNumber(uint32_t* block);
   int8_t readDir(dir_t* dir, char *longfilename);
 
   static bool remove(SdBaseFile* dirFile, const char* path);
@@ -1840,6 +1877,11 @@ class SdBaseFile {
   uint32_t  dirBlock_;      // block for this files directory entry
   uint32_t  fileSize_;      // file size in bytes
   uint32_t  firstCluster_;  // first cluster of file
+  #if ENABLED(SD_EXTENT_MAP)
+  sd_extent_t* extents_;    // cluster runs of the file, NULL to follow the FAT
+  uint8_t   extentCount_;   // number of entries in extents_
+  uint32_t extentCluster(uint32_t index);
+  #endif
   char *pathend;
 
   /** experimental don't use */
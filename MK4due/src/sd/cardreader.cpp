@@ -37,12 +37,30 @@ CardReader::CardReader() {
   sdprinting = false;
   cardOK = false;
   saving = false;
+  #if ENABLED(SD_BINARY_UPLOAD)
+    uploading = false;
+  #endif
+  #if ENABLED(SD_BINARY_PRINT)
+    binaryFile = false;
+    binaryResume = 0;
+  #endif
+  #if ENABLED(SD_DIR_INDEX)
+    dirIndexCount = 0;
+    dirIndexState = DIR_INDEX_STALE;
+  #endif
 
   workDirDepth = 0;
   memset(workDirParents, 0, sizeof(workDirParents));
 
   autostart_stilltocheck = true; //the SD start is delayed, because otherwise the serial cannot answer fast enough to make contact with the host software.
 
+  #if ENABLED(SD_SPI_DMA)
+    stream_cur = 0;
+    stream_next = 0;
+    stream_pending = false;
+    stream_block[0] = stream_block[1] = STREAM_NONE;
+  #endif
+
   //power to SD reader
   #if SDPOWER > -1
     OUT_WRITE(SDPOWER, HIGH);
@@ -51,6 +69,63 @@ CardReader::CardReader() {
   next_autostart_ms = millis() + SPLASH_SCREEN_DURATION;
 }
 
+#if ENABLED(SD_SPI_DMA)
+
+  /**
+   * Drop the buffered blocks, the next get() reads at sdpos again
+   */
+  void CardReader::stream_reset() {
+    if (stream_pending) {
+      fat.card()->readBlockFinish();
+      stream_pending = false;
+    }
+    stream_block[0] = stream_block[1] = STREAM_NONE;
+  }
+
+  /**
+   * get() when sdpos isn't in the current buffer: switch to the block
+   * read in the background, or read it now after a seek, then start
+   * reading the following block into the other buffer so it arrives
+   * while the commands of this one are processed.
+   */
+  int16_t CardReader::stream_get() {
+    if (sdpos >= fileSize) return -1;
+
+    const uint32_t block = sdpos >> 9;
+    uint32_t dev_block;
+    uint8_t next = stream_cur ^ 1;
+
+    if (stream_block[next] == block) {
+      stream_cur = next;
+      if (stream_pending) {
+        stream_pending = false;
+        if (!fat.card()->readBlockFinish()) {
+          stream_reset();
+          return -1;
+        }
+      }
+    }
+    else {
+      stream_reset();
+      if (!file.seekSet(block << 9) || !file.readBlockNumber(&dev_block)
+          || !fat.card()->readBlock(dev_block, stream_buf[stream_cur])) return -1;
+      stream_block[stream_cur] = block;
+    }
+
+    next = stream_cur ^ 1;
+    stream_block[next] = STREAM_NONE;
+    if (((block + 1) << 9) < fileSize && file.readBlockNumber(&dev_block)
+        && fat.card()->readBlockStart(dev_block, stream_buf[next])) {
+      stream_block[next] = block + 1;
+      stream_pending = true;
+    }
+
+    stream_next = sdpos + 1;
+    return stream_buf[stream_cur][sdpos & 0x1FF];
+  }
+
+#endif // SD_SPI_DMA
+
 char* CardReader::createFilename(char* buffer, const dir_t& p) { //buffer > 12characters
   char* pos = buffer, *src = (char*)p.name;
   for (uint8_t i = 0; i < 11; i++, src++) {
@@ -99,11 +174,76 @@ void CardReader::lsDive(SdBaseFile parent, const char* const match/*=NULL*/) {
   } // while readDir
 }
 
+#if ENABLED(SD_DIR_INDEX)
+
+  #if SD_DIR_INDEX_SORT > 0
+    // True if a is listed before b: folders first, then by name or newest first
+    static bool dirIndexBefore(const sd_dir_entry_t &a, const sd_dir_entry_t &b) {
+      if (a.isDir != b.isDir) return a.isDir;
+      #if SD_DIR_INDEX_SORT == 1
+        return strcasecmp(a.longName, b.longName) < 0;
+      #else
+        return ((uint32_t)a.date << 16 | a.time) > ((uint32_t)b.date << 16 | b.time);
+      #endif
+    }
+  #endif
+
+  /**
+   * Read the working directory into dirIndex if it's stale, with the
+   * entries lsDive would list, sorted as set by SD_DIR_INDEX_SORT.
+   * Returns false if the directory has more entries than fit, then
+   * it's left to lsDive until the next change.
+   */
+  bool CardReader::updateDirIndex() {
+    if (dirIndexState != DIR_INDEX_STALE) return dirIndexState == DIR_INDEX_VALID;
+
+    dir_t* p;
+    dirIndexCount = 0;
+    dirIndexState = DIR_INDEX_VALID;
+    workDir.rewind();
+
+    while ((p = workDir.getLongFilename(p, fullName, 0, NULL)) != NULL) {
+      char pn0 = p->name[0];
+      if (pn0 == DIR_NAME_FREE) break;
+      if (pn0 == DIR_NAME_DELETED || pn0 == '.') continue;
+      if (fullName[0] == '.') continue;
+      if (!DIR_IS_FILE_OR_SUBDIR(p)) continue;
+      if (!DIR_IS_SUBDIR(p) && (p->name[8] != 'G' || p->name[9] == '~')) continue;
+
+      if (dirIndexCount == SD_DIR_INDEX) {
+        dirIndexState = DIR_INDEX_FULL;
+        return false;
+      }
+
+      sd_dir_entry_t &e = dirIndex[dirIndexCount];
+      createFilename(e.shortName, *p);
+      strncpy(e.longName, fullName, LONG_FILENAME_LENGTH - 1);
+      e.longName[LONG_FILENAME_LENGTH - 1] = '\0';
+      e.size = p->fileSize;
+      e.date = p->lastWriteDate;
+      e.time = p->lastWriteTime;
+      e.isDir = DIR_IS_SUBDIR(p);
+
+      // Insertion sort, the entries come in one at a time
+      uint8_t i = dirIndexCount;
+      #if SD_DIR_INDEX_SORT > 0
+        for (; i > 0 && dirIndexBefore(e, dirIndex[dirIndexOrder[i - 1]]); i--)
+          dirIndexOrder[i] = dirIndexOrder[i - 1];
+      #endif
+      dirIndexOrder[i] = dirIndexCount++;
+    }
+    return true;
+  }
+
+#endif // SD_DIR_INDEX
+
 void CardReader::ls()  {
+  if (isUploading()) return;
   root.openRoot(fat.vol());
   root.ls(0, 0);
   workDir = root;
   curDir = &root;
+  invalidateDirIndex();
 }
 
 void CardReader::initsd() {
@@ -133,6 +273,7 @@ void CardReader::initsd() {
   root = *fat.vwd();
   workDir = root;
   curDir = &root;
+  invalidateDirIndex();
 }
 
 void CardReader::mount() {
@@ -145,7 +286,7 @@ void CardReader::unmount() {
 }
 
 void CardReader::startPrint() {
-  if (cardOK) sdprinting = true;
+  if (cardOK && !isUploading()) sdprinting = true;
 }
 
 void CardReader::pausePrint() {
@@ -156,7 +297,7 @@ void CardReader::continuePrint(bool intern) {}
 
 void CardReader::stopPrint(bool store_location /*=false*/) {
   sdprinting = false;
-  if (isFileOpen()) closeFile(store_location);
+  if (isFileOpen() && !isUploading()) closeFile(store_location);
 }
 
 void CardReader::write_command(char* buf) {
@@ -182,12 +323,17 @@ bool CardReader::selectFile(const char* filename, bool silent/*=false*/) {
   const char *oldP = filename;
 
   if(!cardOK) return false;
+  if (isUploading()) {
+    if (!silent) SERIAL_LM(ER, MSG_SD_UPLOAD_BUSY);
+    return false;
+  }
 
   file.close();
 
   if (!file.exists("restart.gcode")) {
     file.createContiguous(&workDir, "restart.gcode", 1);
     file.close();
+    invalidateDirIndex();
   }
 
   if (file.open(curDir, filename, O_READ)) {
@@ -207,8 +353,19 @@ bool CardReader::selectFile(const char* filename, bool silent/*=false*/) {
     #if ENABLED(JSON_OUTPUT)
       parsejson(file);
     #endif
-    sdpos = 0;
     fileSize = file.fileSize();
+    #if ENABLED(SD_BINARY_PRINT)
+      readBinaryHeader();
+      if (binaryFile && !silent) {
+        SERIAL_MV(MSG_SD_BINARY_LAYERS, binaryLayers);
+        SERIAL_EMV(MSG_SD_BINARY_TIME, printTime);
+      }
+    #endif
+    #if ENABLED(SD_EXTENT_MAP)
+      // A fragmented file that doesn't fit the map still reads through the FAT
+      file.mapExtents(extents, SD_EXTENT_MAP);
+    #endif
+    setIndex(0);
     SERIAL_EM(MSG_SD_FILE_SELECTED);
     return true;
   }
@@ -218,6 +375,89 @@ bool CardReader::selectFile(const char* filename, bool silent/*=false*/) {
   }
 }
 
+void CardReader::setIndex(uint32_t newpos) {
+  #if ENABLED(SD_BINARY_PRINT)
+    if (binaryFile) {
+      // A byte position is rarely a command boundary, and the delta coded
+      // parameters need the commands before it: decode from its layer start
+      // and queue from the first command at or after the position
+      binaryResume = newpos;
+      if (newpos > binaryStart && newpos < fileSize) newpos = binaryLayerStart(newpos);
+      NOLESS(newpos, binaryStart);
+      for (uint8_t i = 0; i < COUNT(binaryDecimals); i++) binaryDecimals[i] = -1;
+    }
+  #endif
+  #if ENABLED(SD_SPI_DMA)
+    sdpos = stream_next = newpos;
+    stream_reset();
+  #else
+    sdpos = newpos;
+    file.seekSet(sdpos);
+  #endif
+}
+
+#if ENABLED(SD_BINARY_PRINT)
+
+  /**
+   * Recognize a binary print file by its header and take the metadata
+   * from it. The commands end where the layer index starts.
+   */
+  void CardReader::readBinaryHeader() {
+    binary_print_header_t header;
+    binaryFile = file.seekSet(0)
+      && file.read(&header, sizeof(header)) == sizeof(header)
+      && !memcmp(header.magic, BINARY_PRINT_MAGIC, 4)
+      && header.version == 1
+      && header.size >= sizeof(header) && header.size <= fileSize
+      && (!header.index || (header.index >= header.size && header.index + header.layers * 4 <= fileSize));
+    file.seekSet(0);
+    if (!binaryFile) return;
+
+    binaryStart = header.size;
+    binaryIndex = header.index;
+    binaryLayers = header.index ? header.layers : 0;
+    printTime = header.print_time;
+    filamentNeeded = header.filament;
+    firstlayerHeight = header.first_layer_height;
+    layerHeight = header.layer_height;
+    objectHeight = header.object_height;
+    if (binaryIndex) fileSize = binaryIndex;
+  }
+
+  /**
+   * Start of the last layer beginning at or before pos. Without an
+   * index the first command is the only place to start decoding.
+   */
+  uint32_t CardReader::binaryLayerStart(uint32_t pos) {
+    uint32_t start = binaryStart, lo = 0, hi = binaryLayers, entry;
+    // The layer starts in the index are ascending
+    while (lo < hi) {
+      const uint32_t mid = (lo + hi) >> 1;
+      if (!file.seekSet(binaryIndex + mid * 4) || file.read(&entry, 4) != 4) break;
+      if (entry <= pos) {
+        NOLESS(start, entry);
+        lo = mid + 1;
+      }
+      else
+        hi = mid;
+    }
+    return start;
+  }
+
+  /**
+   * Continue a binary print file from the start of a layer
+   */
+  bool CardReader::setLayer(uint32_t layer) {
+    uint32_t pos;
+    if (!binaryFile || layer >= binaryLayers
+        || !file.seekSet(binaryIndex + layer * 4) || file.read(&pos, 4) != 4
+        || pos < binaryStart || pos >= fileSize) return false;
+    setIndex(pos);
+    return true;
+  }
+
+#endif // SD_BINARY_PRINT
+
 void CardReader::printStatus() {
   if (cardOK) {
     SERIAL_MV(MSG_SD_PRINTING_BYTE, sdpos);
@@ -228,13 +468,14 @@ void CardReader::printStatus() {
 }
 
 void CardReader::startWrite(char *filename, bool lcd_status/*=true*/) {
-  if(!cardOK) return;
+  if(!cardOK || isUploading()) return;
   file.close();
 
   if(!file.open(curDir, filename, O_CREAT | O_APPEND | O_WRITE | O_TRUNC)) {
     SERIAL_LMT(ER, MSG_SD_OPEN_FILE_FAIL, filename);
   }
   else {
+    invalidateDirIndex();
     saving = true;
     SERIAL_EMT(MSG_SD_WRITE_TO_FILE, filename);
     if (lcd_status) lcd_setstatus(filename);
@@ -242,9 +483,10 @@ void CardReader::startWrite(char *filename, bool lcd_status/*=true*/) {
 }
 
 void CardReader::deleteFile(char *filename) {
-  if(!cardOK) return;
+  if(!cardOK || isUploading()) return;
   sdprinting = false;
   file.close();
+  invalidateDirIndex();
   if(fat.remove(filename)) {
     SERIAL_EMT(MSG_SD_FILE_DELETED, filename);
   }
@@ -261,13 +503,121 @@ void CardReader::finishWrite() {
     file.sync();
     file.close();
     saving = false;
+    invalidateDirIndex();
     SERIAL_EM(MSG_SD_FILE_SAVED);
 }
 
+#if ENABLED(SD_BINARY_UPLOAD)
+
+  /**
+   * Create a contiguous file of the announced size and start a
+   * multi-block write over all of it, with the blocks pre-erased.
+   * An existing file of the same name is replaced.
+   */
+  bool CardReader::startUpload(char* filename, uint32_t size) {
+    uint32_t firstBlock, lastBlock;
+
+    if (!cardOK) return false;
+    sdprinting = false;
+    file.close();
+    invalidateDirIndex();
+
+    SdBaseFile::remove(curDir, filename);
+    if (!size || !file.createContiguous(curDir, filename, size)
+        || !file.contiguousRange(&firstBlock, &lastBlock)
+        || !fat.card()->writeStart(firstBlock, (size + 511) >> 9)) {
+      if (file.isOpen()) file.remove();
+      SERIAL_LMT(ER, MSG_SD_OPEN_FILE_FAIL, filename);
+      return false;
+    }
+
+    uploading = true;
+    upload_size = size;
+    upload_pos = 0;
+    upload_fill = 0;
+    upload_start_ms = millis();
+    SERIAL_EMT(MSG_SD_WRITE_TO_FILE, filename);
+    return true;
+  }
+
+  /**
+   * Write the filled part of the buffer, padding the last block
+   */
+  bool CardReader::flushUpload() {
+    while (upload_fill & 0x1FF) upload_buf[upload_fill++] = 0;
+    for (uint16_t i = 0; i < upload_fill; i += 512) {
+      if (!fat.card()->writeData(&upload_buf[i])) {
+        SERIAL_LM(ER, MSG_SD_ERR_WRITE_TO_FILE);
+        abortUpload();
+        return false;
+      }
+    }
+    upload_fill = 0;
+    return true;
+  }
+
+  /**
+   * Add received data to the file, finishing it once the announced
+   * size is reached. Returns false if the upload was aborted.
+   */
+  bool CardReader::writeUpload(const uint8_t* data, uint16_t len) {
+    if (!uploading) return false;
+    if (len > upload_size - upload_pos) {
+      abortUpload();
+      return false;
+    }
+
+    while (len) {
+      uint16_t n = sizeof(upload_buf) - upload_fill;
+      NOMORE(n, len);
+      memcpy(&upload_buf[upload_fill], data, n);
+      upload_fill += n;
+      upload_pos += n;
+      data += n;
+      len -= n;
+      if (upload_fill == sizeof(upload_buf) && !flushUpload()) return false;
+    }
+
+    if (upload_pos == upload_size) {
+      if (!flushUpload()) return false;
+      if (!fat.card()->writeStop()) {
+        SERIAL_LM(ER, MSG_SD_ERR_WRITE_TO_FILE);
+        abortUpload();
+        return false;
+      }
+      file.close();
+      uploading = false;
+      invalidateDirIndex();
+
+      millis_t ms = millis() - upload_start_ms;
+      NOLESS(ms, 1);
+      SERIAL_EM(MSG_SD_FILE_SAVED);
+      SERIAL_MV(MSG_SD_UPLOAD_DONE, upload_size);
+      SERIAL_MV(MSG_SD_UPLOAD_TIME, (uint32_t)ms);
+      SERIAL_EMV(MSG_SD_UPLOAD_RATE, (float)upload_size / ms, 1);
+    }
+    return true;
+  }
+
+  /**
+   * Stop the multi-block write and delete the partial file
+   */
+  void CardReader::abortUpload() {
+    if (!uploading) return;
+    uploading = false;
+    fat.card()->writeStop();
+    file.remove();
+    invalidateDirIndex();
+    SERIAL_LM(ER, MSG_SD_UPLOAD_ABORTED);
+  }
+
+#endif // SD_BINARY_UPLOAD
+
 void CardReader::makeDirectory(char *filename) {
-  if(!cardOK) return;
+  if(!cardOK || isUploading()) return;
   sdprinting = false;
   file.close();
+  invalidateDirIndex();
   if(fat.mkdir(filename)) {
     SERIAL_EM(MSG_SD_DIRECTORY_CREATED);
   }
@@ -281,6 +631,31 @@ void CardReader::makeDirectory(char *filename) {
  */
 void CardReader::getfilename(uint16_t nr, const char* const match/*=NULL*/) {
   curDir = &workDir;
+  if (isUploading()) {
+    fullName[0] = '\0';
+    filenameIsDir = false;
+    return;
+  }
+
+  #if ENABLED(SD_DIR_INDEX)
+    if (updateDirIndex()) {
+      const sd_dir_entry_t* e = NULL;
+      if (match != NULL) {
+        for (uint8_t i = 0; i < dirIndexCount && e == NULL; i++)
+          if (strcasecmp(match, dirIndex[i].longName) == 0 || strcasecmp(match, dirIndex[i].shortName) == 0)
+            e = &dirIndex[i];
+      }
+      else if (nr < dirIndexCount)
+        e = &dirIndex[dirIndexOrder[nr]];
+
+      if (e != NULL) {
+        strcpy(fullName, e->longName);
+        filenameIsDir = e->isDir;
+      }
+      return;
+    }
+  #endif
+
   lsAction = LS_GetFilename;
   nrFiles = nr;
   curDir->rewind();
@@ -289,6 +664,10 @@ void CardReader::getfilename(uint16_t nr, const char* const match/*=NULL*/) {
 
 uint16_t CardReader::getnrfilenames() {
   curDir = &workDir;
+  if (isUploading()) return 0;
+  #if ENABLED(SD_DIR_INDEX)
+    if (updateDirIndex()) return dirIndexCount;
+  #endif
   lsAction = LS_Count;
   nrFiles = 0;
   curDir->rewind();
@@ -299,6 +678,7 @@ uint16_t CardReader::getnrfilenames() {
 void CardReader::chdir(const char* relpath) {
   SdBaseFile newfile;
   SdBaseFile* parent = &root;
+  if (isUploading()) return;
   if (workDir.isOpen()) parent = &workDir;
   if (!newfile.open(parent, relpath, O_READ)) {
     SERIAL_EMT(MSG_SD_CANT_ENTER_SUBDIR, relpath);
@@ -310,6 +690,7 @@ void CardReader::chdir(const char* relpath) {
       workDirParents[0] = *parent;
     }
     workDir = newfile;
+    invalidateDirIndex();
   }
 }
 
@@ -319,15 +700,20 @@ void CardReader::updir() {
     workDir = workDirParents[0];
     for (uint16_t d = 0; d < workDirDepth; d++)
       workDirParents[d] = workDirParents[d + 1];
+    invalidateDirIndex();
   }
 }
 
 void CardReader::closeFile(bool store_location /*=false*/) {
+  #if ENABLED(SD_SPI_DMA)
+    stream_reset();
+  #endif
   file.sync();
   file.close();
   saving = false;
 
   if (store_location) {
+    invalidateDirIndex(); // restart.gcode is rewritten
     char bufferFilerestart[50];
     char bufferX[11];
     char bufferY[11];
@@ -446,6 +832,7 @@ void CardReader::closeFile(bool store_location /*=false*/) {
 void CardReader::checkautostart(bool force) {
   if (!force && (!autostart_stilltocheck || next_autostart_ms >= millis()))
     return;
+  if (isUploading()) return; // Checked again once the upload is done
 
   autostart_stilltocheck = false;
 
@@ -473,11 +860,13 @@ void CardReader::setroot(bool temporary /*=false*/) {
   if(temporary) lastDir = workDir;
   workDir = root;
   curDir = &workDir;
+  invalidateDirIndex();
 }
 
 void CardReader::setlast() {
   workDir = lastDir;
   curDir = &workDir;
+  invalidateDirIndex();
 }
 
 // --------------------------------------------------------------- //
@@ -32,12 +32,53 @@
 #define LONG_FILENAME_LENGTH (FILENAME_LENGTH * MAX_VFAT_ENTRIES + 1)
 #define SHORT_FILENAME_LENGTH 14
 #define GENBY_SIZE 16
+#define STREAM_NONE 0xFFFFFFFF
+
+#if ENABLED(SD_BINARY_PRINT)
+  /**
+   * Header of a binary print file, little-endian, made by
+   * scripts/binary_print.py. The tokenized commands follow the header,
+   * each with a length byte, up to the layer index or the end of file.
+   * The index holds the uint32 file position of the first command of
+   * each layer, where no parameter is delta coded.
+   */
+  #define BINARY_PRINT_MAGIC "MKBP"
+  typedef struct {
+    char      magic[4];
+    uint8_t   version,            // 1
+              size;               // Header size, the first command follows
+    uint16_t  reserved;
+    uint32_t  index,              // File position of the layer index, 0 if none
+              layers,             // Entries in the layer index
+              print_time,         // Estimated print time in seconds
+              commands;
+    float     filament,           // Filament used, mm
+              first_layer_height,
+              layer_height,
+              object_height;
+  } binary_print_header_t;
+#endif
 
 extern char tempLongFilename[LONG_FILENAME_LENGTH + 1];
 extern char fullName[LONG_FILENAME_LENGTH * SD_MAX_FOLDER_DEPTH + SD_MAX_FOLDER_DEPTH + 1];
 
 enum LsAction { LS_Count, LS_GetFilename };
 
+#if ENABLED(SD_DIR_INDEX)
+  enum DirIndexState { DIR_INDEX_STALE, DIR_INDEX_VALID, DIR_INDEX_FULL };
+
+  /**
+   * One entry of the cached listing of the working directory
+   */
+  typedef struct {
+    char      shortName[FILENAME_LENGTH],     // 8.3 name
+              longName[LONG_FILENAME_LENGTH]; // Long name, or the 8.3 name if none
+    uint32_t  size;
+    uint16_t  date, time;                     // FAT modification date and time
+    bool      isDir;
+  } sd_dir_entry_t;
+#endif
+
 #include "SDFat.h"
 
 class CardReader {
@@ -62,6 +103,11 @@ public:
   void startWrite(char* filename, bool lcd_status = true);
   void deleteFile(char* filename);
   void finishWrite();
+  #if ENABLED(SD_BINARY_UPLOAD)
+    bool startUpload(char* filename, uint32_t size);
+    bool writeUpload(const uint8_t* data, uint16_t len);
+    void abortUpload();
+  #endif
   void makeDirectory(char* filename);
   void closeFile(bool store_location = false);
   char *createFilename(char *buffer, const dir_t &p);
@@ -73,13 +119,38 @@ public:
 
   uint16_t getnrfilenames();
 
+  // Read the working directory again at the next listing
+  FORCE_INLINE void invalidateDirIndex() {
+    #if ENABLED(SD_DIR_INDEX)
+      dirIndexState = DIR_INDEX_STALE;
+    #endif
+  }
+
   void parseKeyLine(char* key, char* value, int &len_k, int &len_v);
   void unparseKeyLine(const char* key, char* value);
 
-  FORCE_INLINE void setIndex(uint32_t newpos) { sdpos = newpos; file.seekSet(sdpos); }
+  // No other card access may interrupt the multi-block write of an upload
+  FORCE_INLINE bool isUploading() {
+    #if ENABLED(SD_BINARY_UPLOAD)
+      return uploading;
+    #else
+      return false;
+    #endif
+  }
+
   FORCE_INLINE bool isFileOpen() { return file.isOpen(); }
   FORCE_INLINE bool eof() { return sdpos >= fileSize; }
-  FORCE_INLINE int16_t get() { sdpos = file.curPosition(); return (int16_t)file.read(); }
+  void setIndex(uint32_t newpos);
+  #if ENABLED(SD_SPI_DMA)
+    FORCE_INLINE int16_t get() {
+      sdpos = stream_next;
+      if ((sdpos >> 9) != stream_block[stream_cur] || sdpos >= fileSize) return stream_get();
+      stream_next++;
+      return stream_buf[stream_cur][sdpos & 0x1FF];
+    }
+  #else
+    FORCE_INLINE int16_t get() { sdpos = file.curPosition(); return (int16_t)file.read(); }
+  #endif
   FORCE_INLINE uint8_t percentDone() { return (isFileOpen() && fileSize) ? sdpos / ((fileSize + 99) / 100) : 0; }
   FORCE_INLINE char* getWorkDirName() { workDir.getFilename(fullName); return fullName; }
 
@@ -88,6 +159,17 @@ public:
   void checkautostart(bool x);
 
   bool saving, sdprinting, cardOK, filenameIsDir;
+  #if ENABLED(SD_BINARY_UPLOAD)
+    bool uploading;
+  #endif
+  #if ENABLED(SD_BINARY_PRINT)
+    bool binaryFile;                // The selected file is a binary print file
+    uint32_t binaryLayers, printTime;
+    int32_t binaryValue[26];        // Last value of each letter, for delta coded parameters
+    int8_t binaryDecimals[26];      // Its decimals, -1 if none yet
+    uint32_t binaryResume;          // Commands before it only rebuild the delta bases
+    bool setLayer(uint32_t layer);
+  #endif
   uint32_t fileSize, sdpos;
   float objectHeight, firstlayerHeight, layerHeight, filamentNeeded;
   char generatedBy[GENBY_SIZE];
@@ -109,6 +191,47 @@ private:
   bool findLayerHeight(char* buf, float& layerHeight);
   bool findFilamentNeed(char* buf, float& filament);
   bool findTotalHeight(char* buf, float& objectHeight);
+
+  #if ENABLED(SD_DIR_INDEX)
+    // Listing of workDir, read on the first listing after a change
+    sd_dir_entry_t dirIndex[SD_DIR_INDEX];
+    uint8_t dirIndexOrder[SD_DIR_INDEX];  // Entries in listing order
+    uint8_t dirIndexCount;
+    DirIndexState dirIndexState;          // DIR_INDEX_FULL: too many entries, use lsDive
+    bool updateDirIndex();
+  #endif
+
+  #if ENABLED(SD_BINARY_PRINT)
+    uint32_t binaryStart, binaryIndex;
+    void readBinaryHeader();
+    uint32_t binaryLayerStart(uint32_t pos);
+  #endif
+
+  #if ENABLED(SD_BINARY_UPLOAD)
+    // Upload data is collected here and written as one multi-block run
+    uint8_t upload_buf[SD_UPLOAD_BLOCKS * 512];
+    uint16_t upload_fill;         // Bytes in upload_buf
+    uint32_t upload_size,         // Announced file size
+             upload_pos;          // Bytes received
+    millis_t upload_start_ms;
+    bool flushUpload();
+  #endif
+
+  #if ENABLED(SD_EXTENT_MAP)
+    sd_extent_t extents[SD_EXTENT_MAP]; // Cluster runs of the selected file
+  #endif
+
+  #if ENABLED(SD_SPI_DMA)
+    // Two block buffers for the printing file: one is read by get()
+    // while the next block is fetched into the other in the background.
+    uint8_t stream_buf[2][512];
+    uint32_t stream_block[2],   // File block held by each buffer, STREAM_NONE if none
+             stream_next;       // File position of the next get()
+    uint8_t stream_cur;         // Buffer read by get()
+    bool stream_pending;        // Background read into the other buffer in progress
+    void stream_reset();
+    int16_t stream_get();
+  #endif
 };
 
 extern CardReader card;
@@ -0,0 +1,100 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Sample filter of the ADC DMA capture (ADC_DMA)
+ *
+ * The samples of a sensor collect in a window. When it closes, the highest
+ * and lowest samples are dropped, the mean of the others is scaled to
+ * oversample readings of 10 bits as the thermistor tables expect, and the
+ * median of the last windows removes the spikes.
+ *
+ * Only plain functions of the state they are given, so they also build on
+ * the host (test/adc_filter_test.cpp).
+ */
+
+#ifndef ADC_FILTER_H
+#define ADC_FILTER_H
+
+#include <stdint.h>
+
+#define ADC_FILTER_MAX_MEDIAN 9
+
+typedef struct {
+  uint32_t sum;
+  uint16_t count, min, max;
+} adc_window_t;
+
+inline void adc_window_reset(adc_window_t &w) {
+  w.sum = 0;
+  w.count = 0;
+  w.min = 0xFFFF;
+  w.max = 0;
+}
+
+inline void adc_window_add(adc_window_t &w, const uint16_t value) {
+  w.sum += value;
+  w.count++;
+  if (value < w.min) w.min = value;
+  if (value > w.max) w.max = value;
+}
+
+// Mean without the extremes, 12 bit samples scaled to oversample * 10 bit. Needs 3 samples.
+inline uint16_t adc_window_value(const adc_window_t &w, const uint16_t oversample) {
+  return (((w.sum - w.min - w.max) * oversample) / (w.count - 2) + 2) >> 2;
+}
+
+// Median of size values, size odd and ADC_FILTER_MAX_MEDIAN or less
+inline uint16_t adc_median(const uint16_t* history, const uint8_t size) {
+  uint16_t sorted[ADC_FILTER_MAX_MEDIAN];
+  for (uint8_t i = 0; i < size; i++) {
+    uint8_t j = i;
+    for (; j > 0 && sorted[j - 1] > history[i]; j--) sorted[j] = sorted[j - 1];
+    sorted[j] = history[i];
+  }
+  return sorted[size / 2];
+}
+
+/**
+ * Close a window into slot index of its median history of size windows and
+ * start a new one. The first window fills the whole history, so the median
+ * starts right away. A window with 2 samples or less leaves raw as it was.
+ * Returns true if raw was updated.
+ */
+inline bool adc_filter_update(adc_window_t &w, uint16_t* history, const uint8_t size, const uint8_t index,
+                              bool &history_valid, int &raw, const uint16_t oversample) {
+  const bool closed = w.count > 2;
+  if (closed) {
+    const uint16_t value = adc_window_value(w, oversample);
+    if (history_valid)
+      history[index] = value;
+    else {
+      for (uint8_t i = 0; i < size; i++) history[i] = value;
+      history_valid = true;
+    }
+    raw = adc_median(history, size);
+  }
+  adc_window_reset(w);
+  return closed;
+}
+
+#endif // ADC_FILTER_H
@@ -227,6 +227,18 @@ static unsigned char soft_pwm[HOTENDS];
   float Kp[HOTENDS], Ki[HOTENDS], Kd[HOTENDS], Kc[HOTENDS];
 #endif //PIDTEMP
 
+#if ENABLED(MPCTEMP)
+  mpc_t mpc[HOTENDS];
+
+  // Modeled temperatures of a hotend
+  typedef struct {
+    float block_temp, sensor_temp, ambient_temp;
+    bool valid;
+  } mpc_model_t;
+
+  static mpc_model_t mpc_model[HOTENDS];
+#endif
+
 // Init min and max temp with extreme values to prevent false errors during startup
 static int minttemp_raw[HOTENDS] = ARRAY_BY_HOTENDS_N( HEATER_0_RAW_LO_TEMP , HEATER_1_RAW_LO_TEMP , HEATER_2_RAW_LO_TEMP, HEATER_3_RAW_LO_TEMP);
 static int maxttemp_raw[HOTENDS] = ARRAY_BY_HOTENDS_N( HEATER_0_RAW_HI_TEMP , HEATER_1_RAW_HI_TEMP , HEATER_2_RAW_HI_TEMP, HEATER_3_RAW_HI_TEMP);
@@ -257,7 +269,95 @@ static unsigned long raw_temp_cooler_value = 0;
   static int cooler_maxttemp_raw = COOLER_RAW_HI_TEMP;
 #endif
 
-#ifdef __SAM3X8E__
+#if ENABLED(ADC_DMA)
+
+  #include "adc_filter.h"
+
+  /**
+   * ADC DMA capture
+   *
+   * Every sensor owns a slot. The temperature ISR drains the ring of the PDC
+   * into the window of each slot and closes the windows every
+   * ADC_DMA_UPDATE_TICKS into the median of the last ADC_DMA_MEDIAN windows,
+   * see adc_filter.h.
+   */
+  #define ADC_DMA_SLOT_BED      4
+  #define ADC_DMA_SLOT_CHAMBER  5
+  #define ADC_DMA_SLOT_COOLER   6
+  #define ADC_DMA_SLOT_FILWIDTH 7
+  #define ADC_DMA_SLOT_POWER    8
+  #define ADC_DMA_SLOTS         9
+
+  static int8_t adc_dma_slot[16];   // ADC channel -> slot, -1 if not scanned
+  static uint32_t adc_dma_mask = 0;
+  static uint16_t adc_dma_read_index = 0;
+  static adc_window_t adc_window[ADC_DMA_SLOTS];
+  static uint16_t adc_history[ADC_DMA_SLOTS][ADC_DMA_MEDIAN];
+  static bool adc_history_valid[ADC_DMA_SLOTS] = { false };
+  static uint8_t adc_history_index = 0;
+  static int adc_dma_raw[ADC_DMA_SLOTS] = { 0 };
+
+  static void adc_dma_select(const int pin, const uint8_t slot) {
+    const adc_channel_num_t chan = pinToAdcChannel(pin);
+    adc_dma_slot[chan] = slot;
+    adc_dma_mask |= _BV(chan);
+  }
+
+  // Add the samples the PDC wrote since the last call to their windows
+  static FORCE_INLINE void adc_dma_drain() {
+    const uint16_t write_index = adcDmaWriteIndex();
+    while (adc_dma_read_index != write_index) {
+      const uint16_t sample = adc_dma_buffer[adc_dma_read_index];
+      adc_dma_read_index = (adc_dma_read_index + 1) & (ADC_DMA_BUFFER_SIZE - 1);
+      const int8_t slot = adc_dma_slot[ADC_DMA_CHANNEL(sample)];
+      if (slot < 0) continue;
+      adc_window_add(adc_window[slot], ADC_DMA_VALUE(sample));
+    }
+  }
+
+  // Close the windows, a slot without enough samples keeps its last value
+  static void adc_dma_update() {
+    for (uint8_t s = 0; s < ADC_DMA_SLOTS; s++)
+      adc_filter_update(adc_window[s], adc_history[s], ADC_DMA_MEDIAN, adc_history_index, adc_history_valid[s], adc_dma_raw[s], OVERSAMPLENR);
+    if (++adc_history_index >= ADC_DMA_MEDIAN) adc_history_index = 0;
+  }
+
+  static void adc_dma_init() {
+    for (uint8_t i = 0; i < COUNT(adc_dma_slot); i++) adc_dma_slot[i] = -1;
+    for (uint8_t s = 0; s < ADC_DMA_SLOTS; s++) adc_window_reset(adc_window[s]);
+
+    #if HAS(TEMP_0)
+      adc_dma_select(TEMP_0_PIN, 0);
+    #endif
+    #if HAS(TEMP_1)
+      adc_dma_select(TEMP_1_PIN, 1);
+    #endif
+    #if HAS(TEMP_2)
+      adc_dma_select(TEMP_2_PIN, 2);
+    #endif
+    #if HAS(TEMP_3)
+      adc_dma_select(TEMP_3_PIN, 3);
+    #endif
+    #if HAS(TEMP_BED)
+      adc_dma_select(TEMP_BED_PIN, ADC_DMA_SLOT_BED);
+    #endif
+    #if HAS(TEMP_CHAMBER)
+      adc_dma_select(TEMP_CHAMBER_PIN, ADC_DMA_SLOT_CHAMBER);
+    #endif
+    #if HAS(TEMP_COOLER)
+      adc_dma_select(TEMP_COOLER_PIN, ADC_DMA_SLOT_COOLER);
+    #endif
+    #if HAS(FILAMENT_SENSOR)
+      adc_dma_select(FILWIDTH_PIN, ADC_DMA_SLOT_FILWIDTH);
+    #endif
+    #if HAS(POWER_CONSUMPTION_SENSOR)
+      adc_dma_select(POWER_CONSUMPTION_PIN, ADC_DMA_SLOT_POWER);
+    #endif
+
+    adcDmaStart(adc_dma_mask);
+  }
+
+#elif defined(__SAM3X8E__)
   // MEDIAN COUNT
   // For Smoother temperature
   // ONLY FOR DUE
@@ -274,12 +374,77 @@ static unsigned long raw_temp_cooler_value = 0;
   static unsigned long sum;
 #endif
 
+/**
+ * Thermistor tables
+ *
+ * The tables of thermistortables.h are sorted by raw value. The segment of a
+ * reading is found with a binary search and the slope of every segment is
+ * computed once by tp_init(), so a conversion costs one multiplication
+ * instead of a scan with a float division per segment.
+ */
+typedef struct {
+  const short (*tt)[2];   // { raw, celsius } pairs in PROGMEM, NULL for no table
+  uint8_t len;
+  float* slope;           // slope[i]: celsius per raw unit between entries i - 1 and i
+} temp_table_t;
+
+#define TEMP_TABLE(TT, LEN, SLOPE) { (const short(*)[2])(TT), LEN, SLOPE }
+
 #if ENABLED(TEMP_SENSOR_1_AS_REDUNDANT)
-  static void* heater_ttbl_map[2] = {(void*)HEATER_0_TEMPTABLE, (void*)HEATER_1_TEMPTABLE };
-  static uint8_t heater_ttbllen_map[2] = { HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN };
+  #define HEATER_TABLES 2
+#else
+  #define HEATER_TABLES HOTENDS
+#endif
+
+#ifdef THERMISTORHEATER_0
+  static float heater_0_slope[HEATER_0_TEMPTABLE_LEN];
+  #define HEATER_0_SLOPE heater_0_slope
+#else
+  #define HEATER_0_SLOPE NULL
+#endif
+#if defined(THERMISTORHEATER_1) && HEATER_TABLES > 1
+  static float heater_1_slope[HEATER_1_TEMPTABLE_LEN];
+  #define HEATER_1_SLOPE heater_1_slope
+#else
+  #define HEATER_1_SLOPE NULL
+#endif
+#if defined(THERMISTORHEATER_2) && HEATER_TABLES > 2
+  static float heater_2_slope[HEATER_2_TEMPTABLE_LEN];
+  #define HEATER_2_SLOPE heater_2_slope
+#else
+  #define HEATER_2_SLOPE NULL
+#endif
+#if defined(THERMISTORHEATER_3) && HEATER_TABLES > 3
+  static float heater_3_slope[HEATER_3_TEMPTABLE_LEN];
+  #define HEATER_3_SLOPE heater_3_slope
 #else
-  static void* heater_ttbl_map[HOTENDS] = ARRAY_BY_HOTENDS_N( (void*)HEATER_0_TEMPTABLE, (void*)HEATER_1_TEMPTABLE, (void*)HEATER_2_TEMPTABLE, (void*)HEATER_3_TEMPTABLE );
-  static uint8_t heater_ttbllen_map[HOTENDS] = ARRAY_BY_HOTENDS_N( HEATER_0_TEMPTABLE_LEN, HEATER_1_TEMPTABLE_LEN, HEATER_2_TEMPTABLE_LEN, HEATER_3_TEMPTABLE_LEN );
+  #define HEATER_3_SLOPE NULL
+#endif
+
+static temp_table_t heater_ttbl[HEATER_TABLES] = {
+  TEMP_TABLE(HEATER_0_TEMPTABLE, HEATER_0_TEMPTABLE_LEN, HEATER_0_SLOPE)
+  #if HEATER_TABLES > 1
+    , TEMP_TABLE(HEATER_1_TEMPTABLE, HEATER_1_TEMPTABLE_LEN, HEATER_1_SLOPE)
+    #if HEATER_TABLES > 2
+      , TEMP_TABLE(HEATER_2_TEMPTABLE, HEATER_2_TEMPTABLE_LEN, HEATER_2_SLOPE)
+      #if HEATER_TABLES > 3
+        , TEMP_TABLE(HEATER_3_TEMPTABLE, HEATER_3_TEMPTABLE_LEN, HEATER_3_SLOPE)
+      #endif
+    #endif
+  #endif
+};
+
+#if ENABLED(BED_USES_THERMISTOR)
+  static float bed_slope[BEDTEMPTABLE_LEN];
+  static temp_table_t bed_ttbl = TEMP_TABLE(BEDTEMPTABLE, BEDTEMPTABLE_LEN, bed_slope);
+#endif
+#if ENABLED(CHAMBER_USES_THERMISTOR)
+  static float chamber_slope[CHAMBERTEMPTABLE_LEN];
+  static temp_table_t chamber_ttbl = TEMP_TABLE(CHAMBERTEMPTABLE, CHAMBERTEMPTABLE_LEN, chamber_slope);
+#endif
+#if ENABLED(COOLER_USES_THERMISTOR)
+  static float cooler_slope[COOLERTEMPTABLE_LEN];
+  static temp_table_t cooler_ttbl = TEMP_TABLE(COOLERTEMPTABLE, COOLERTEMPTABLE_LEN, cooler_slope);
 #endif
 
 static float analog2temp(int raw, uint8_t e);
@@ -728,6 +893,272 @@ void min_temp_error(int8_t h) {
   _temp_error(h, PSTR(MSG_T_MINTEMP), PSTR(MSG_ERR_MINTEMP));
 }
 
+#if ENABLED(MPCTEMP)
+
+  #define MPC_dT PID_dT
+
+  // Fan speed the planner is applying, the same check_axes_activity() uses
+  static float mpc_fan_speed() {
+    const block_t* block = planner.peek_current_block();
+    return block ? block->fan_speed : fanSpeed;
+  }
+
+  // Filament the running block feeds into hotend h, mm/s at its nominal speed
+  static float mpc_e_speed(const uint8_t h) {
+    const block_t* block = planner.peek_current_block();
+    if (!block || !block->steps[E_AXIS] || TEST(block->direction_bits, E_AXIS)) return 0.0;
+    #if HOTENDS > 1
+      if (block->active_extruder != h) return 0.0;
+    #else
+      UNUSED(h);
+    #endif
+    return block->steps[E_AXIS] * block->nominal_speed / (planner.axis_steps_per_mm[E_AXIS + block->active_extruder] * block->millimeters);
+  }
+
+  void reset_mpc_model() {
+    for (uint8_t h = 0; h < HOTENDS; h++) mpc_model[h].valid = false;
+  }
+
+  /**
+   * Model predictive control
+   *
+   * The model of heater block and sensor runs over the last period with the
+   * power the heater really had, then is pulled toward the measured
+   * temperature. The output is the power that brings the modeled block to
+   * the target in about 2 seconds plus the losses at the target: to the
+   * ambient, to the part fan and to the filament the planner is feeding.
+   */
+  static float get_mpc_output(const uint8_t h) {
+    const mpc_t &c = mpc[h];
+    mpc_model_t &m = mpc_model[h];
+    const float celsius = current_temperature[h];
+
+    if (!m.valid) {
+      m.block_temp = m.sensor_temp = celsius;
+      m.ambient_temp = min(30.0, celsius);
+      m.valid = true;
+    }
+
+    const float ambient_xfer_coeff = c.ambient_xfer_coeff_fan0 + c.fan255_adjustment * mpc_fan_speed() / 255.0
+                                   + c.filament_heat_capacity_permm * mpc_e_speed(h);
+
+    const float heater_power = soft_pwm[h] * c.heater_power / 127.0;
+    m.block_temp += (heater_power - (m.block_temp - m.ambient_temp) * ambient_xfer_coeff) * MPC_dT / c.block_heat_capacity;
+    m.sensor_temp += (m.block_temp - m.sensor_temp) * c.sensor_responsiveness * MPC_dT;
+
+    // Slow model errors are corrected here, the noise averages out
+    const float correction = (celsius - m.sensor_temp) * (MPC_SMOOTHING_FACTOR);
+    m.block_temp += correction;
+    m.sensor_temp += correction;
+
+    // At the target what is left is an error of the modeled ambient temperature
+    if (fabs(m.sensor_temp - target_temperature[h]) < (MPC_STEADYSTATE))
+      m.ambient_temp += correction > 0 ? max(correction, (MPC_MIN_AMBIENT_CHANGE) * MPC_dT) : min(correction, -(MPC_MIN_AMBIENT_CHANGE) * MPC_dT);
+
+    float power = 0.0;
+    if (target_temperature[h] > 0) {
+      power = (target_temperature[h] - m.block_temp) * c.block_heat_capacity / 2.0
+            + (target_temperature[h] - m.ambient_temp) * ambient_xfer_coeff;
+    }
+
+    // soft_pwm takes the upper 7 bits, +1 rounds them
+    const float mpc_output = power * 254.0 / c.heater_power + 1.0;
+    return constrain(mpc_output, 0, PID_MAX);
+  }
+
+  /**
+   * MPC autotune
+   *
+   *  - With the fan at full speed wait for the hotend to settle at the ambient temperature
+   *  - Heat at full power up to temp. Three equally spaced samples of the curve give
+   *    the asymptotic temperature and the responsiveness of block and sensor
+   *  - Hold temp with the model, the mean power gives the losses with the fan off
+   *  - The same with the fan at 255
+   */
+  #define MPC_TUNING_TIMEOUT (10UL * 60UL * 1000UL)
+  #define MPC_TUNING_SETTLE  20000UL
+  #define MPC_TUNING_MEASURE 40000UL
+
+  static millis_t mpc_report_ms;
+
+  // Wait for a new temperature of hotend h. False if it is over temp.
+  static bool mpc_tuning_update(const uint8_t h, const float temp) {
+    while (!temp_meas_ready) lcd_update();
+    updateTemperaturesFromRawValues();
+
+    const millis_t ms = millis();
+    if (ELAPSED(ms, mpc_report_ms)) {
+      #if HAS(TEMP_0) || HAS(TEMP_BED) || ENABLED(HEATER_0_USES_MAX6675)
+        print_heaterstates();
+        SERIAL_E;
+      #endif
+      mpc_report_ms = ms + 2000UL;
+    }
+
+    if (current_temperature[h] > temp + MAX_OVERSHOOT_PID_AUTOTUNE) {
+      SERIAL_LM(ER, MSG_PID_TEMP_TOO_HIGH);
+      return false;
+    }
+    return true;
+  }
+
+  static void mpc_tuning_fan(const int speed) {
+    fanSpeed = speed;
+    planner.check_axes_activity();
+  }
+
+  // Hold temp with the model, return the mean heater power and temperature
+  static bool mpc_tuning_hold(const uint8_t h, const float temp, float &power, float &celsius) {
+    const millis_t start_ms = millis();
+    float power_sum = 0.0, celsius_sum = 0.0;
+    uint16_t count = 0;
+
+    target_temperature[h] = temp;
+    for (;;) {
+      if (!mpc_tuning_update(h, temp)) return false;
+      soft_pwm[h] = (int)get_mpc_output(h) >> 1;
+
+      const millis_t elapsed = millis() - start_ms;
+      if (elapsed > MPC_TUNING_SETTLE + MPC_TUNING_MEASURE) break;
+      if (elapsed > MPC_TUNING_SETTLE) {
+        power_sum += soft_pwm[h] * mpc[h].heater_power / 127.0;
+        celsius_sum += current_temperature[h];
+        count++;
+      }
+    }
+
+    power = power_sum / count;
+    celsius = celsius_sum / count;
+    return true;
+  }
+
+  static bool mpc_tuning_measure(const uint8_t h, const float temp) {
+    mpc_t &c = mpc[h];
+    millis_t ms = millis(), next_ms;
+
+    // Cool down to the ambient temperature: stop when it falls less than 0.1C in 10 seconds
+    SERIAL_EM("Cooling to ambient");
+    mpc_tuning_fan(255);
+    float ambient_temp = current_temperature[h];
+    next_ms = ms + 10000UL;
+    for (;;) {
+      if (!mpc_tuning_update(h, temp)) return false;
+      ms = millis();
+      if (ELAPSED(ms, next_ms)) {
+        if (ambient_temp - current_temperature[h] < 0.1) break;
+        ambient_temp = current_temperature[h];
+        next_ms = ms + 10000UL;
+      }
+    }
+    ambient_temp = current_temperature[h];
+    mpc_tuning_fan(0);
+
+    // Heat at full power, sampling from 30% of the way. When the buffer is
+    // full every other sample is dropped and the distance doubles.
+    SERIAL_EM("Heating");
+    float samples[16], t1_time = 0.0;
+    uint8_t count = 0;
+    millis_t sample_distance_ms = 1000UL, next_sample_ms = 0;
+    const float first_sample_temp = ambient_temp + (temp - ambient_temp) * 0.3;
+    const millis_t heat_start_ms = millis();
+
+    soft_pwm[h] = PID_MAX >> 1;
+    for (;;) {
+      if (!mpc_tuning_update(h, temp)) return false;
+      ms = millis();
+      if (ms - heat_start_ms > MPC_TUNING_TIMEOUT) {
+        SERIAL_LM(ER, MSG_PID_TIMEOUT);
+        return false;
+      }
+      if (count ? ELAPSED(ms, next_sample_ms) : current_temperature[h] >= first_sample_temp) {
+        if (!count) {
+          t1_time = (ms - heat_start_ms) / 1000.0;
+          next_sample_ms = ms;
+        }
+        samples[count++] = current_temperature[h];
+        next_sample_ms += sample_distance_ms;
+        if (count == COUNT(samples)) {
+          for (uint8_t i = 0; i < COUNT(samples) / 2; i++) samples[i] = samples[i * 2];
+          count = COUNT(samples) / 2;
+          sample_distance_ms <<= 1;
+        }
+      }
+      if (current_temperature[h] >= temp) break;
+    }
+
+    // An odd count puts t2 in the middle
+    if (!(count & 1)) count--;
+    if (count < 3) {
+      SERIAL_LM(ER, "MPC autotune failed: heating too fast, raise the temperature");
+      return false;
+    }
+    const float t1 = samples[0],
+                t2 = samples[(count - 1) >> 1],
+                t3 = samples[count - 1],
+                sample_distance = sample_distance_ms / 1000.0 * ((count - 1) >> 1);
+
+    if (2 * t2 - t1 - t3 <= 0) {
+      SERIAL_LM(ER, "MPC autotune failed: the heating curve is not asymptotic");
+      return false;
+    }
+
+    float asymp_temp = (t2 * t2 - t1 * t3) / (2 * t2 - t1 - t3),
+          block_responsiveness = -log((t2 - asymp_temp) / (t1 - asymp_temp)) / sample_distance;
+
+    // First guess, enough to hold the temperature with the model
+    c.ambient_xfer_coeff_fan0 = c.heater_power / (asymp_temp - ambient_temp);
+    c.block_heat_capacity = c.ambient_xfer_coeff_fan0 / block_responsiveness;
+    c.sensor_responsiveness = block_responsiveness / (1.0 - (ambient_temp - asymp_temp) * exp(-block_responsiveness * t1_time) / (t1 - asymp_temp));
+
+    // Losses with the fan off and at full speed
+    float power, celsius;
+    reset_mpc_model();
+    SERIAL_EM("Measuring ambient losses");
+    if (!mpc_tuning_hold(h, temp, power, celsius)) return false;
+    c.ambient_xfer_coeff_fan0 = power / (celsius - ambient_temp);
+
+    SERIAL_EM("Measuring fan losses");
+    mpc_tuning_fan(255);
+    if (!mpc_tuning_hold(h, temp, power, celsius)) return false;
+    c.fan255_adjustment = power / (celsius - ambient_temp) - c.ambient_xfer_coeff_fan0;
+
+    // The measured losses give a better asymptotic temperature
+    asymp_temp = ambient_temp + c.heater_power / c.ambient_xfer_coeff_fan0;
+    block_responsiveness = -log((t2 - asymp_temp) / (t1 - asymp_temp)) / sample_distance;
+    c.block_heat_capacity = c.ambient_xfer_coeff_fan0 / block_responsiveness;
+    c.sensor_responsiveness = block_responsiveness / (1.0 - (ambient_temp - asymp_temp) * exp(-block_responsiveness * t1_time) / (t1 - asymp_temp));
+
+    return true;
+  }
+
+  void MPC_autotune(const uint8_t h, const float temp) {
+    const int old_fan_speed = fanSpeed;
+
+    SERIAL_SMV(ECHO, "MPC autotune start for hotend ", (int)h);
+    SERIAL_EMV(" Temp: ", temp);
+
+    disable_all_heaters();
+    mpc_report_ms = millis();
+
+    if (mpc_tuning_measure(h, temp)) {
+      const mpc_t &c = mpc[h];
+      SERIAL_EM("MPC autotune finished! Put the values in Configuration_Temperature.h or save them with M500");
+      SERIAL_SMV(ECHO, "M307 H", (int)h);
+      SERIAL_MV(" P", c.heater_power);
+      SERIAL_MV(" C", c.block_heat_capacity);
+      SERIAL_MV(" R", c.sensor_responsiveness, 4);
+      SERIAL_MV(" A", c.ambient_xfer_coeff_fan0, 4);
+      SERIAL_EMV(" F", c.ambient_xfer_coeff_fan0 + c.fan255_adjustment, 4);
+    }
+
+    target_temperature[h] = 0;
+    disable_all_heaters();
+    mpc_tuning_fan(old_fan_speed);
+    reset_mpc_model();
+  }
+
+#endif // MPCTEMP
+
 float get_pid_output(int h) {
   #if HOTENDS <= 1
     UNUSED(h);
@@ -737,7 +1168,9 @@ float get_pid_output(int h) {
   #endif
 
   float pid_output;
-  #if ENABLED(PIDTEMP)
+  #if ENABLED(MPCTEMP)
+    pid_output = get_mpc_output(HOTEND_INDEX);
+  #elif ENABLED(PIDTEMP)
     #if DISABLED(PID_OPENLOOP)
       pid_error[HOTEND_INDEX] = target_temperature[HOTEND_INDEX] - current_temperature[HOTEND_INDEX];
       dTerm[HOTEND_INDEX] = K2 * PID_PARAM(Kd, HOTEND_INDEX) * (current_temperature[HOTEND_INDEX] - temp_dState[HOTEND_INDEX]) + K1 * dTerm[HOTEND_INDEX];
@@ -1159,6 +1592,56 @@ void manage_temp_controller() {
 }
 
 #define PGM_RD_W(x)   (short)pgm_read_word(&x)
+
+// Compute the segment slopes of a table
+static void temp_table_init(temp_table_t &t) {
+  if (!t.tt) return;
+  t.slope[0] = 0;
+  for (uint8_t i = 1; i < t.len; i++) {
+    const short draw = PGM_RD_W(t.tt[i][0]) - PGM_RD_W(t.tt[i - 1][0]);
+    t.slope[i] = draw ? (float)(PGM_RD_W(t.tt[i][1]) - PGM_RD_W(t.tt[i - 1][1])) / draw : 0;
+  }
+}
+
+// Raw value to temperature, interpolated on the first entry above raw
+static float temp_table_celsius(const temp_table_t &t, const int raw) {
+  uint8_t lo = 0, hi = t.len;
+  while (lo < hi) {
+    const uint8_t mid = (lo + hi) >> 1;
+    if (PGM_RD_W(t.tt[mid][0]) > raw) hi = mid; else lo = mid + 1;
+  }
+
+  // Overflow: Set to last value in the table
+  if (lo == t.len) return PGM_RD_W(t.tt[lo - 1][1]);
+
+  // Underflow: extrapolate the first segment
+  NOLESS(lo, 1);
+  return PGM_RD_W(t.tt[lo - 1][1]) + (raw - PGM_RD_W(t.tt[lo - 1][0])) * t.slope[lo];
+}
+
+/**
+ * Temperature to raw value, for the minttemp/maxttemp raw limits: the inverse
+ * of temp_table_celsius. round_up selects the side the fractional raw value
+ * is rounded to, so the limit never lies outside the allowed range.
+ */
+static int temp_table_raw(const temp_table_t &t, const float celsius, const bool round_up) {
+  const short t_first = PGM_RD_W(t.tt[0][1]), t_last = PGM_RD_W(t.tt[t.len - 1][1]);
+  uint8_t i = 1;
+  // Beyond the first entry the first segment is extrapolated, as temp_table_celsius does
+  if ((celsius - t_first) * (t_last - t_first) > 0) {
+    for (; i < t.len; i++) {
+      const short t0 = PGM_RD_W(t.tt[i - 1][1]), t1 = PGM_RD_W(t.tt[i][1]);
+      if ((celsius - t0) * (celsius - t1) <= 0) break;
+    }
+    // Beyond the last entry temp_table_celsius returns the last value
+    if (i == t.len) return PGM_RD_W(t.tt[t.len - 1][0]);
+  }
+  if (!t.slope[i]) return PGM_RD_W(t.tt[i][0]);
+  float raw = PGM_RD_W(t.tt[i - 1][0]) + (celsius - PGM_RD_W(t.tt[i - 1][1])) / t.slope[i];
+  NOLESS(raw, 0);
+  return round_up ? ceil(raw) : floor(raw);
+}
+
 // Derived from RepRap FiveD extruder::getTemperature()
 // For hot end temperature measurement.
 static float analog2temp(int raw, uint8_t h) {
@@ -1178,26 +1661,7 @@ static float analog2temp(int raw, uint8_t h) {
     if (h == 0) return 0.25 * raw;
   #endif
 
-  if (heater_ttbl_map[h] != NULL) {
-    float celsius = 0;
-    uint8_t i;
-    short(*tt)[][2] = (short(*)[][2])(heater_ttbl_map[h]);
-
-    for (i = 1; i < heater_ttbllen_map[h]; i++) {
-      if (PGM_RD_W((*tt)[i][0]) > raw) {
-        celsius = PGM_RD_W((*tt)[i - 1][1]) +
-                  (raw - PGM_RD_W((*tt)[i - 1][0])) *
-                  (float)(PGM_RD_W((*tt)[i][1]) - PGM_RD_W((*tt)[i - 1][1])) /
-                  (float)(PGM_RD_W((*tt)[i][0]) - PGM_RD_W((*tt)[i - 1][0]));
-        break;
-      }
-    }
-
-    // Overflow: Set to last value in the table
-    if (i == heater_ttbllen_map[h]) celsius = PGM_RD_W((*tt)[i - 1][1]);
-
-    return celsius;
-  }
+  if (heater_ttbl[h].tt) return temp_table_celsius(heater_ttbl[h], raw);
 
   #if HEATER_USES_AD595
     #ifdef __SAM3X8E__
@@ -1214,24 +1678,7 @@ static float analog2temp(int raw, uint8_t h) {
 // For bed temperature measurement.
 static float analog2tempBed(int raw) {
   #if ENABLED(BED_USES_THERMISTOR)
-    float celsius = 0;
-    byte i;
-
-    for (i = 1; i < BEDTEMPTABLE_LEN; i++) {
-      if (PGM_RD_W(BEDTEMPTABLE[i][0]) > raw) {
-        celsius  = PGM_RD_W(BEDTEMPTABLE[i - 1][1]) +
-                   (raw - PGM_RD_W(BEDTEMPTABLE[i - 1][0])) *
-                   (float)(PGM_RD_W(BEDTEMPTABLE[i][1]) - PGM_RD_W(BEDTEMPTABLE[i - 1][1])) /
-                   (float)(PGM_RD_W(BEDTEMPTABLE[i][0]) - PGM_RD_W(BEDTEMPTABLE[i - 1][0]));
-        break;
-      }
-    }
-
-    // Overflow: Set to last value in the table
-    if (i == BEDTEMPTABLE_LEN) celsius = PGM_RD_W(BEDTEMPTABLE[i - 1][1]);
-
-    return celsius;
-
+    return temp_table_celsius(bed_ttbl, raw);
   #elif ENABLED(BED_USES_AD595)
     #ifdef __SAM3X8E__
       return ((raw * ((3.3 * 100.0) / 1024.0) / OVERSAMPLENR) * TEMP_SENSOR_AD595_GAIN) + TEMP_SENSOR_AD595_OFFSET;
@@ -1247,24 +1694,7 @@ static float analog2tempBed(int raw) {
 
 static float analog2tempChamber(int raw) { 
   #if ENABLED(CHAMBER_USES_THERMISTOR)
-    float celsius = 0;
-    byte i;
-
-    for (i = 1; i < CHAMBERTEMPTABLE_LEN; i++) {
-      if (PGM_RD_W(CHAMBERTEMPTABLE[i][0]) > raw) {
-        celsius  = PGM_RD_W(CHAMBERTEMPTABLE[i - 1][1]) +
-                   (raw - PGM_RD_W(CHAMBERTEMPTABLE[i - 1][0])) *
-                   (float)(PGM_RD_W(CHAMBERTEMPTABLE[i][1]) - PGM_RD_W(CHAMBERTEMPTABLE[i - 1][1])) /
-                   (float)(PGM_RD_W(CHAMBERTEMPTABLE[i][0]) - PGM_RD_W(CHAMBERTEMPTABLE[i - 1][0]));
-        break;
-      }
-    }
-
-    // Overflow: Set to last value in the table
-    if (i == CHAMBERTEMPTABLE_LEN) celsius = PGM_RD_W(CHAMBERTEMPTABLE[i - 1][1]);
-
-    return celsius;
-
+    return temp_table_celsius(chamber_ttbl, raw);
   #elif ENABLED(CHAMBER_USES_AD595)
     #ifdef __SAM3X8E__
       return ((raw * ((3.3 * 100.0) / 1024.0) / OVERSAMPLENR) * TEMP_SENSOR_AD595_GAIN) + TEMP_SENSOR_AD595_OFFSET;
@@ -1279,24 +1709,7 @@ static float analog2tempChamber(int raw) {
 
 static float analog2tempCooler(int raw) { 
   #if ENABLED(COOLER_USES_THERMISTOR)
-    float celsius = 0;
-    byte i;
-
-    for (i = 1; i < COOLERTEMPTABLE_LEN; i++) {
-      if (PGM_RD_W(COOLERTEMPTABLE[i][0]) > raw) {
-        celsius  = PGM_RD_W(COOLERTEMPTABLE[i - 1][1]) +
-                   (raw - PGM_RD_W(COOLERTEMPTABLE[i - 1][0])) *
-                   (float)(PGM_RD_W(COOLERTEMPTABLE[i][1]) - PGM_RD_W(COOLERTEMPTABLE[i - 1][1])) /
-                   (float)(PGM_RD_W(COOLERTEMPTABLE[i][0]) - PGM_RD_W(COOLERTEMPTABLE[i - 1][0]));
-        break;
-      }
-    }
-
-    // Overflow: Set to last value in the table
-    if (i == COOLERTEMPTABLE_LEN) celsius = PGM_RD_W(COOLERTEMPTABLE[i - 1][1]);
-
-    return celsius;
-
+    return temp_table_celsius(cooler_ttbl, raw);
   #elif ENABLED(COOLER_USES_AD595)
     #ifdef __SAM3X8E__
       return ((raw * ((3.3 * 100.0) / 1024.0) / OVERSAMPLENR) * TEMP_SENSOR_AD595_GAIN) + TEMP_SENSOR_AD595_OFFSET;
@@ -1435,6 +1848,18 @@ void tp_init() {
     #endif //PIDTEMP
   }
 
+  // Slopes of the thermistor tables, before the first conversion
+  for (uint8_t h = 0; h < HEATER_TABLES; h++) temp_table_init(heater_ttbl[h]);
+  #if ENABLED(BED_USES_THERMISTOR)
+    temp_table_init(bed_ttbl);
+  #endif
+  #if ENABLED(CHAMBER_USES_THERMISTOR)
+    temp_table_init(chamber_ttbl);
+  #endif
+  #if ENABLED(COOLER_USES_THERMISTOR)
+    temp_table_init(cooler_ttbl);
+  #endif
+
   #if ENABLED(PIDTEMPBED)
     temp_iState_min_bed = 0.0;
     temp_iState_max_bed = PID_BED_INTEGRAL_DRIVE_MAX / bedKi;
@@ -1503,61 +1928,67 @@ void tp_init() {
 
   #endif // HEATER_0_USES_MAX6675
 
-  // Set analog inputs
-  #ifdef __SAM3X8E__
-    #define ANALOG_SELECT(pin) startAdcConversion(pinToAdcChannel(pin))
+  #if ENABLED(ADC_DMA)
+    adc_dma_init();
   #else
-    #ifdef DIDR2
-      #define ANALOG_SELECT(pin) do{ if (pin < 8) SBI(DIDR0, pin); else SBI(DIDR2, pin - 8); }while(0)
+
+    // Set analog inputs
+    #ifdef __SAM3X8E__
+      #define ANALOG_SELECT(pin) startAdcConversion(pinToAdcChannel(pin))
     #else
-      #define ANALOG_SELECT(pin) do{ SBI(DIDR0, pin); }while(0)
+      #ifdef DIDR2
+        #define ANALOG_SELECT(pin) do{ if (pin < 8) SBI(DIDR0, pin); else SBI(DIDR2, pin - 8); }while(0)
+      #else
+        #define ANALOG_SELECT(pin) do{ SBI(DIDR0, pin); }while(0)
+      #endif
     #endif
-  #endif
 
-  // Setup channels
-  #ifdef __SAM3X8E__
-    // ADC_MR_FREERUN_ON: Free Run Mode. It never waits for any trigger.
-    ADC->ADC_MR |= ADC_MR_FREERUN_ON | ADC_MR_LOWRES_BITS_12;
-  #else
-    ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADIF) | 0x07;
-    DIDR0 = 0;
-    #ifdef DIDR2
-      DIDR2 = 0;
+    // Setup channels
+    #ifdef __SAM3X8E__
+      // ADC_MR_FREERUN_ON: Free Run Mode. It never waits for any trigger.
+      ADC->ADC_MR |= ADC_MR_FREERUN_ON | ADC_MR_LOWRES_BITS_12;
+    #else
+      ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADIF) | 0x07;
+      DIDR0 = 0;
+      #ifdef DIDR2
+        DIDR2 = 0;
+      #endif
     #endif
-  #endif
 
-  #if HAS(TEMP_0)
-    ANALOG_SELECT(TEMP_0_PIN);
-  #endif
-  #if HAS(TEMP_1)
-    ANALOG_SELECT(TEMP_1_PIN);
-  #endif
-  #if HAS(TEMP_2)
-    ANALOG_SELECT(TEMP_2_PIN);
-  #endif
-  #if HAS(TEMP_3)
-    ANALOG_SELECT(TEMP_3_PIN);
-  #endif
+    #if HAS(TEMP_0)
+      ANALOG_SELECT(TEMP_0_PIN);
+    #endif
+    #if HAS(TEMP_1)
+      ANALOG_SELECT(TEMP_1_PIN);
+    #endif
+    #if HAS(TEMP_2)
+      ANALOG_SELECT(TEMP_2_PIN);
+    #endif
+    #if HAS(TEMP_3)
+      ANALOG_SELECT(TEMP_3_PIN);
+    #endif
 
-  #if HAS(TEMP_BED)
-    ANALOG_SELECT(TEMP_BED_PIN);
-  #endif
+    #if HAS(TEMP_BED)
+      ANALOG_SELECT(TEMP_BED_PIN);
+    #endif
 
-  #if HAS(TEMP_CHAMBER)
-    ANALOG_SELECT(TEMP_CHAMBER_PIN);
-  #endif
+    #if HAS(TEMP_CHAMBER)
+      ANALOG_SELECT(TEMP_CHAMBER_PIN);
+    #endif
 
-  #if HAS(TEMP_COOLER)
-    ANALOG_SELECT(TEMP_COOLER_PIN);
-  #endif
+    #if HAS(TEMP_COOLER)
+      ANALOG_SELECT(TEMP_COOLER_PIN);
+    #endif
 
-  #if HAS(FILAMENT_SENSOR)
-    ANALOG_SELECT(FILWIDTH_PIN);
-  #endif
+    #if HAS(FILAMENT_SENSOR)
+      ANALOG_SELECT(FILWIDTH_PIN);
+    #endif
 
-  #if HAS(POWER_CONSUMPTION_SENSOR)
-    ANALOG_SELECT(POWER_CONSUMPTION_PIN);
-  #endif
+    #if HAS(POWER_CONSUMPTION_SENSOR)
+      ANALOG_SELECT(POWER_CONSUMPTION_PIN);
+    #endif
+
+  #endif // !ADC_DMA
 
   #if HAS(AUTO_FAN_0)
     SET_OUTPUT(EXTRUDER_0_AUTO_FAN_PIN);
@@ -1597,9 +2028,12 @@ void tp_init() {
   // Wait for temperature measurement to settle
   HAL::delayMilliseconds(250);
 
+  // Thermistor limits come from the inverted table, other sensors are searched
   #define TEMP_MIN_ROUTINE(NR) \
     minttemp[NR] = HEATER_ ## NR ## _MINTEMP; \
-    while(analog2temp(minttemp_raw[NR], NR) < HEATER_ ## NR ## _MINTEMP) { \
+    if (heater_ttbl[NR].tt) \
+      minttemp_raw[NR] = temp_table_raw(heater_ttbl[NR], HEATER_ ## NR ## _MINTEMP, HEATER_ ## NR ## _RAW_LO_TEMP < HEATER_ ## NR ## _RAW_HI_TEMP); \
+    else while(analog2temp(minttemp_raw[NR], NR) < HEATER_ ## NR ## _MINTEMP) { \
       if (HEATER_ ## NR ## _RAW_LO_TEMP < HEATER_ ## NR ## _RAW_HI_TEMP) \
         minttemp_raw[NR] += OVERSAMPLENR; \
       else \
@@ -1607,7 +2041,9 @@ void tp_init() {
     }
   #define TEMP_MAX_ROUTINE(NR) \
     maxttemp[NR] = HEATER_ ## NR ## _MAXTEMP; \
-    while(analog2temp(maxttemp_raw[NR], NR) > HEATER_ ## NR ## _MAXTEMP) { \
+    if (heater_ttbl[NR].tt) \
+      maxttemp_raw[NR] = temp_table_raw(heater_ttbl[NR], HEATER_ ## NR ## _MAXTEMP, HEATER_ ## NR ## _RAW_LO_TEMP > HEATER_ ## NR ## _RAW_HI_TEMP); \
+    else while(analog2temp(maxttemp_raw[NR], NR) > HEATER_ ## NR ## _MAXTEMP) { \
       if (HEATER_ ## NR ## _RAW_LO_TEMP < HEATER_ ## NR ## _RAW_HI_TEMP) \
         maxttemp_raw[NR] -= OVERSAMPLENR; \
       else \
@@ -1646,60 +2082,84 @@ void tp_init() {
   #endif // HOTENDS > 1
 
   #if ENABLED(BED_MINTEMP)
-    while(analog2tempBed(bed_minttemp_raw) < BED_MINTEMP) {
-      #if HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP
-        bed_minttemp_raw += OVERSAMPLENR;
-      #else
-        bed_minttemp_raw -= OVERSAMPLENR;
-      #endif
-    }
+    #if ENABLED(BED_USES_THERMISTOR)
+      bed_minttemp_raw = temp_table_raw(bed_ttbl, BED_MINTEMP, HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP);
+    #else
+      while(analog2tempBed(bed_minttemp_raw) < BED_MINTEMP) {
+        #if HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP
+          bed_minttemp_raw += OVERSAMPLENR;
+        #else
+          bed_minttemp_raw -= OVERSAMPLENR;
+        #endif
+      }
+    #endif
   #endif //BED_MINTEMP
   #if ENABLED(BED_MAXTEMP)
-    while(analog2tempBed(bed_maxttemp_raw) > BED_MAXTEMP) {
-      #if HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP
-        bed_maxttemp_raw -= OVERSAMPLENR;
-      #else
-        bed_maxttemp_raw += OVERSAMPLENR;
-      #endif
-    }
+    #if ENABLED(BED_USES_THERMISTOR)
+      bed_maxttemp_raw = temp_table_raw(bed_ttbl, BED_MAXTEMP, HEATER_BED_RAW_LO_TEMP > HEATER_BED_RAW_HI_TEMP);
+    #else
+      while(analog2tempBed(bed_maxttemp_raw) > BED_MAXTEMP) {
+        #if HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP
+          bed_maxttemp_raw -= OVERSAMPLENR;
+        #else
+          bed_maxttemp_raw += OVERSAMPLENR;
+        #endif
+      }
+    #endif
   #endif // BED_MAXTEMP
 
   #if ENABLED(CHAMBER_MINTEMP)
-    while(analog2tempChamber(chamber_minttemp_raw) < CHAMBER_MINTEMP) {
-      #if CHAMBER_RAW_LO_TEMP < HEATER_CHAMBER_RAW_HI_TEMP
-        chamber_minttemp_raw += OVERSAMPLENR;
-      #else
-        chamber_minttemp_raw -= OVERSAMPLENR;
-      #endif
-    }
+    #if ENABLED(CHAMBER_USES_THERMISTOR)
+      chamber_minttemp_raw = temp_table_raw(chamber_ttbl, CHAMBER_MINTEMP, HEATER_CHAMBER_RAW_LO_TEMP < HEATER_CHAMBER_RAW_HI_TEMP);
+    #else
+      while(analog2tempChamber(chamber_minttemp_raw) < CHAMBER_MINTEMP) {
+        #if HEATER_CHAMBER_RAW_LO_TEMP < HEATER_CHAMBER_RAW_HI_TEMP
+          chamber_minttemp_raw += OVERSAMPLENR;
+        #else
+          chamber_minttemp_raw -= OVERSAMPLENR;
+        #endif
+      }
+    #endif
   #endif // CHAMBER_MINTEMP
   #if ENABLED(CHAMBER_MAXTEMP)
-    while(analog2tempCooler(chamber_maxttemp_raw) > CHAMBER_MAXTEMP) {
-      #if CHAMBER_RAW_LO_TEMP < CHAMBER_RAW_HI_TEMP
-        chamber_maxttemp_raw -= OVERSAMPLENR;
-      #else
-        chamber_maxttemp_raw += OVERSAMPLENR;
-      #endif
-    }
-  #endif // BED_MAXTEMP
+    #if ENABLED(CHAMBER_USES_THERMISTOR)
+      chamber_maxttemp_raw = temp_table_raw(chamber_ttbl, CHAMBER_MAXTEMP, HEATER_CHAMBER_RAW_LO_TEMP > HEATER_CHAMBER_RAW_HI_TEMP);
+    #else
+      while(analog2tempChamber(chamber_maxttemp_raw) > CHAMBER_MAXTEMP) {
+        #if HEATER_CHAMBER_RAW_LO_TEMP < HEATER_CHAMBER_RAW_HI_TEMP
+          chamber_maxttemp_raw -= OVERSAMPLENR;
+        #else
+          chamber_maxttemp_raw += OVERSAMPLENR;
+        #endif
+      }
+    #endif
+  #endif // CHAMBER_MAXTEMP
 
   #if ENABLED(COOLER_MINTEMP)
-    while(analog2tempCooler(cooler_minttemp_raw) < COOLER_MINTEMP) {
-      #if COOLER_RAW_LO_TEMP < HEATER_COOLER_RAW_HI_TEMP
-        cooler_minttemp_raw += OVERSAMPLENR;
-      #else
-        cooler_minttemp_raw -= OVERSAMPLENR;
-      #endif
-    }
+    #if ENABLED(COOLER_USES_THERMISTOR)
+      cooler_minttemp_raw = temp_table_raw(cooler_ttbl, COOLER_MINTEMP, COOLER_RAW_LO_TEMP < COOLER_RAW_HI_TEMP);
+    #else
+      while(analog2tempCooler(cooler_minttemp_raw) < COOLER_MINTEMP) {
+        #if COOLER_RAW_LO_TEMP < COOLER_RAW_HI_TEMP
+          cooler_minttemp_raw += OVERSAMPLENR;
+        #else
+          cooler_minttemp_raw -= OVERSAMPLENR;
+        #endif
+      }
+    #endif
   #endif // COOLER_MINTEMP
   #if ENABLED(COOLER_MAXTEMP)
-    while(analog2tempCooler(cooler_maxttemp_raw) > COOLER_MAXTEMP) {
-      #if COOLER_RAW_LO_TEMP < COOLER_RAW_HI_TEMP
-        cooler_maxttemp_raw -= OVERSAMPLENR;
-      #else
-        cooler_maxttemp_raw += OVERSAMPLENR;
-      #endif
-    }
+    #if ENABLED(COOLER_USES_THERMISTOR)
+      cooler_maxttemp_raw = temp_table_raw(cooler_ttbl, COOLER_MAXTEMP, COOLER_RAW_LO_TEMP > COOLER_RAW_HI_TEMP);
+    #else
+      while(analog2tempCooler(cooler_maxttemp_raw) > COOLER_MAXTEMP) {
+        #if COOLER_RAW_LO_TEMP < COOLER_RAW_HI_TEMP
+          cooler_maxttemp_raw -= OVERSAMPLENR;
+        #else
+          cooler_maxttemp_raw += OVERSAMPLENR;
+        #endif
+      }
+    #endif
   #endif // COOLER_MAXTEMP
 }
 
@@ -1973,7 +2433,15 @@ void disable_all_coolers() {
 /**
  * Get raw temperatures
  */
-#ifdef __SAM3X8E__
+#if ENABLED(ADC_DMA)
+  static int calc_raw_temp_value(uint8_t temp_id) { return adc_dma_raw[temp_id]; }
+  static int calc_raw_temp_bed_value() { return adc_dma_raw[ADC_DMA_SLOT_BED]; }
+  static int calc_raw_temp_chamber_value() { return adc_dma_raw[ADC_DMA_SLOT_CHAMBER]; }
+  static int calc_raw_temp_cooler_value() { return adc_dma_raw[ADC_DMA_SLOT_COOLER]; }
+  #if HAS(POWER_CONSUMPTION_SENSOR)
+    static int calc_raw_powconsumption_value() { return adc_dma_raw[ADC_DMA_SLOT_POWER]; }
+  #endif
+#elif defined(__SAM3X8E__)
   static int calc_raw_temp_value(uint8_t temp_id) {
     raw_median_temp[temp_id][median_counter] = (raw_temp_value[temp_id] - (min_temp[temp_id] + max_temp[temp_id]));
     sum = 0;
@@ -2059,7 +2527,7 @@ static void set_current_temp_raw() {
     #endif
   #endif
 
-  #ifdef __SAM3X8E__
+  #if defined(__SAM3X8E__) && DISABLED(ADC_DMA)
     // Reset min/max-holder
     for (uint8_t i = 0; i < 7; i++) {
       min_temp[i] = RAW_MIN_TEMP_DEFAULT;
@@ -2085,11 +2553,15 @@ static void set_current_temp_raw() {
 #else
   ISR(TIMER0_COMPB_vect) {
 #endif
+  ISR_PROFILE_START();
+
   //these variables are only accesible from the ISR, but static, so they don't lose their value
   static unsigned char temp_count = 0;
-  static TempState temp_state = StartupDelay;
+  #if DISABLED(ADC_DMA)
+    static TempState temp_state = StartupDelay;
+  #endif
   static unsigned char pwm_count = _BV(SOFT_PWM_SCALE);
-  #ifdef __SAM3X8E__
+  #if defined(__SAM3X8E__) && DISABLED(ADC_DMA)
     static int temp_read = 0;
     static bool first_start = true;
   #endif
@@ -2130,7 +2602,7 @@ static void set_current_temp_raw() {
     static unsigned long raw_filwidth_value = 0;
   #endif
 
-  #ifdef __SAM3X8E__
+  #if defined(__SAM3X8E__) && DISABLED(ADC_DMA)
     // Initialize some variables only at start!
     if (first_start) {
  	    for (uint8_t i = 0; i < 7; i++) {
@@ -2141,7 +2613,9 @@ static void set_current_temp_raw() {
       first_start = false;
       SERIAL_EM("First start for temperature finished.");
     }
+  #endif
 
+  #ifdef __SAM3X8E__
     HAL_timer_isr_status (TEMP_TIMER_COUNTER, TEMP_TIMER_CHANNEL);
   #endif
 
@@ -2353,246 +2827,259 @@ static void set_current_temp_raw() {
 
   #endif // SLOW_PWM_HEATERS
 
-  #ifdef __SAM3X8E__
-    #define SET_RAW_TEMP_VALUE(temp_id) temp_read = getAdcFreerun(pinToAdcChannel(TEMP_## temp_id ##_PIN)); \
-      raw_temp_value[temp_id] += temp_read; \
-      max_temp[temp_id] = max(max_temp[temp_id], temp_read); \
-      min_temp[temp_id] = min(min_temp[temp_id], temp_read)
-
-    #define SET_RAW_TEMP_BED_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_BED_PIN)); \
-      raw_temp_bed_value += temp_read; \
-      max_temp[4] = max(max_temp[4], temp_read); \
-      min_temp[4] = min(min_temp[4], temp_read)
-
-    #define SET_RAW_TEMP_CHAMBER_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_CHAMBER_PIN)); \
-      raw_temp_chamber_value += temp_read; \
-      max_temp[5] = max(max_temp[5], temp_read); \
-      min_temp[5] = min(min_temp[5], temp_read)
-
-    #define SET_RAW_TEMP_COOLER_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_COOLER_PIN)); \
-      raw_temp_cooler_value += temp_read; \
-      max_temp[6] = max(max_temp[6], temp_read); \
-      min_temp[6] = min(min_temp[6], temp_read)
-  #else
-    #define SET_ADMUX_ADCSRA(pin) ADMUX = _BV(REFS0) | (pin & 0x07); SBI(ADCSRA, ADSC)
-    #ifdef MUX5
-      #define START_ADC(pin) if (pin > 7) ADCSRB = _BV(MUX5); else ADCSRB = 0; SET_ADMUX_ADCSRA(pin)
+  #if ENABLED(ADC_DMA)
+
+    // The ADC scans all the channels by itself, just collect the new samples
+    adc_dma_drain();
+    if (temp_count & 1) lcd_buttons_update();
+
+  #else // !ADC_DMA
+
+    #ifdef __SAM3X8E__
+      #define SET_RAW_TEMP_VALUE(temp_id) temp_read = getAdcFreerun(pinToAdcChannel(TEMP_## temp_id ##_PIN)); \
+        raw_temp_value[temp_id] += temp_read; \
+        max_temp[temp_id] = max(max_temp[temp_id], temp_read); \
+        min_temp[temp_id] = min(min_temp[temp_id], temp_read)
+
+      #define SET_RAW_TEMP_BED_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_BED_PIN)); \
+        raw_temp_bed_value += temp_read; \
+        max_temp[4] = max(max_temp[4], temp_read); \
+        min_temp[4] = min(min_temp[4], temp_read)
+
+      #define SET_RAW_TEMP_CHAMBER_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_CHAMBER_PIN)); \
+        raw_temp_chamber_value += temp_read; \
+        max_temp[5] = max(max_temp[5], temp_read); \
+        min_temp[5] = min(min_temp[5], temp_read)
+
+      #define SET_RAW_TEMP_COOLER_VALUE() temp_read = getAdcFreerun(pinToAdcChannel(TEMP_COOLER_PIN)); \
+        raw_temp_cooler_value += temp_read; \
+        max_temp[6] = max(max_temp[6], temp_read); \
+        min_temp[6] = min(min_temp[6], temp_read)
     #else
-      #define START_ADC(pin) ADCSRB = 0; SET_ADMUX_ADCSRA(pin)
+      #define SET_ADMUX_ADCSRA(pin) ADMUX = _BV(REFS0) | (pin & 0x07); SBI(ADCSRA, ADSC)
+      #ifdef MUX5
+        #define START_ADC(pin) if (pin > 7) ADCSRB = _BV(MUX5); else ADCSRB = 0; SET_ADMUX_ADCSRA(pin)
+      #else
+        #define START_ADC(pin) ADCSRB = 0; SET_ADMUX_ADCSRA(pin)
+      #endif
     #endif
-  #endif
 
-  // Prepare or measure a sensor, each one every 14th frame
-  switch (temp_state) {
-    case PrepareTemp_0:
-      #if HAS(TEMP_0)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_0_PIN);
+    // Prepare or measure a sensor, each one every 14th frame
+    switch (temp_state) {
+      case PrepareTemp_0:
+        #if HAS(TEMP_0)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_0_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_0;
-      break;
-    case MeasureTemp_0:
-      #if HAS(TEMP_0)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_VALUE(0);
-        #else
-          raw_temp_value[0] += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_0;
+        break;
+      case MeasureTemp_0:
+        #if HAS(TEMP_0)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_VALUE(0);
+          #else
+            raw_temp_value[0] += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_BED;
-      break;
+        temp_state = PrepareTemp_BED;
+        break;
 
-    case PrepareTemp_BED:
-      #if HAS(TEMP_BED)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_BED_PIN);
+      case PrepareTemp_BED:
+        #if HAS(TEMP_BED)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_BED_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_BED;
-      break;
-    case MeasureTemp_BED:
-      #if HAS(TEMP_BED)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_BED_VALUE();
-        #else
-          raw_temp_bed_value += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_BED;
+        break;
+      case MeasureTemp_BED:
+        #if HAS(TEMP_BED)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_BED_VALUE();
+          #else
+            raw_temp_bed_value += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_1;
-      break;
+        temp_state = PrepareTemp_1;
+        break;
 
-    case PrepareTemp_1:
-      #if HAS(TEMP_1)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_1_PIN);
+      case PrepareTemp_1:
+        #if HAS(TEMP_1)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_1_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_1;
-      break;
-    case MeasureTemp_1:
-      #if HAS(TEMP_1)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_VALUE(1);
-        #else
-          raw_temp_value[1] += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_1;
+        break;
+      case MeasureTemp_1:
+        #if HAS(TEMP_1)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_VALUE(1);
+          #else
+            raw_temp_value[1] += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_2;
-      break;
+        temp_state = PrepareTemp_2;
+        break;
 
-    case PrepareTemp_2:
-      #if HAS(TEMP_2)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_2_PIN);
+      case PrepareTemp_2:
+        #if HAS(TEMP_2)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_2_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_2;
-      break;
-    case MeasureTemp_2:
-      #if HAS(TEMP_2)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_VALUE(2);
-        #else
-          raw_temp_value[2] += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_2;
+        break;
+      case MeasureTemp_2:
+        #if HAS(TEMP_2)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_VALUE(2);
+          #else
+            raw_temp_value[2] += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_3;
-      break;
+        temp_state = PrepareTemp_3;
+        break;
 
-    case PrepareTemp_3:
-      #if HAS(TEMP_3)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_3_PIN);
+      case PrepareTemp_3:
+        #if HAS(TEMP_3)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_3_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_3;
-      break;
-    case MeasureTemp_3:
-      #if HAS(TEMP_3)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_VALUE(3);
-        #else
-          raw_temp_value[3] += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_3;
+        break;
+      case MeasureTemp_3:
+        #if HAS(TEMP_3)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_VALUE(3);
+          #else
+            raw_temp_value[3] += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_CHAMBER;
-      break;
+        temp_state = PrepareTemp_CHAMBER;
+        break;
 
-    case PrepareTemp_CHAMBER:
-      #if HAS(TEMP_CHAMBER)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_CHAMBER_PIN);
+      case PrepareTemp_CHAMBER:
+        #if HAS(TEMP_CHAMBER)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_CHAMBER_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_CHAMBER;
-      break;
-    case MeasureTemp_CHAMBER:
-      #if HAS(TEMP_CHAMBER)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_CHAMBER_VALUE();
-        #else
-          raw_temp_chamber_value += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_CHAMBER;
+        break;
+      case MeasureTemp_CHAMBER:
+        #if HAS(TEMP_CHAMBER)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_CHAMBER_VALUE();
+          #else
+            raw_temp_chamber_value += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_COOLER;
-      break;
+        temp_state = PrepareTemp_COOLER;
+        break;
 
-    case PrepareTemp_COOLER:
-      #if HAS(TEMP_COOLER)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(TEMP_COOLER_PIN);
+      case PrepareTemp_COOLER:
+        #if HAS(TEMP_COOLER)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(TEMP_COOLER_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = MeasureTemp_COOLER;
-      break;
-    case MeasureTemp_COOLER:
-      #if HAS(TEMP_COOLER)
-        #ifdef __SAM3X8E__
-          SET_RAW_TEMP_COOLER_VALUE();
-        #else
-          raw_temp_cooler_value += ADC;
+        lcd_buttons_update();
+        temp_state = MeasureTemp_COOLER;
+        break;
+      case MeasureTemp_COOLER:
+        #if HAS(TEMP_COOLER)
+          #ifdef __SAM3X8E__
+            SET_RAW_TEMP_COOLER_VALUE();
+          #else
+            raw_temp_cooler_value += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = Prepare_FILWIDTH;
-      break;
+        temp_state = Prepare_FILWIDTH;
+        break;
 
-    case Prepare_FILWIDTH:
-      #if HAS(FILAMENT_SENSOR)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(FILWIDTH_PIN);
+      case Prepare_FILWIDTH:
+        #if HAS(FILAMENT_SENSOR)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(FILWIDTH_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = Measure_FILWIDTH;
-      break;
-    case Measure_FILWIDTH:
-      #if HAS(FILAMENT_SENSOR)
-        // raw_filwidth_value += ADC;  //remove to use an IIR filter approach
-        if (ADC > 102) { //check that ADC is reading a voltage > 0.5 volts, otherwise don't take in the data.
-          raw_filwidth_value -= (raw_filwidth_value >> 7); //multiply raw_filwidth_value by 127/128
-          raw_filwidth_value += ((unsigned long)ADC << 7); //add new ADC reading
-        }
-      #endif
-      temp_state = Prepare_POWCONSUMPTION;
-      break;
+        lcd_buttons_update();
+        temp_state = Measure_FILWIDTH;
+        break;
+      case Measure_FILWIDTH:
+        #if HAS(FILAMENT_SENSOR)
+          // raw_filwidth_value += ADC;  //remove to use an IIR filter approach
+          if (ADC > 102) { //check that ADC is reading a voltage > 0.5 volts, otherwise don't take in the data.
+            raw_filwidth_value -= (raw_filwidth_value >> 7); //multiply raw_filwidth_value by 127/128
+            raw_filwidth_value += ((unsigned long)ADC << 7); //add new ADC reading
+          }
+        #endif
+        temp_state = Prepare_POWCONSUMPTION;
+        break;
 
-    case Prepare_POWCONSUMPTION:
-      #if HAS(POWER_CONSUMPTION_SENSOR)
-        #ifdef __SAM3X8E__
-          // nothing todo for Due
-        #else
-          START_ADC(POWER_CONSUMPTION_PIN);
+      case Prepare_POWCONSUMPTION:
+        #if HAS(POWER_CONSUMPTION_SENSOR)
+          #ifdef __SAM3X8E__
+            // nothing todo for Due
+          #else
+            START_ADC(POWER_CONSUMPTION_PIN);
+          #endif
         #endif
-      #endif
-      lcd_buttons_update();
-      temp_state = Measure_POWCONSUMPTION;
-      break;
-    case Measure_POWCONSUMPTION:
-      #if HAS(POWER_CONSUMPTION_SENSOR)
-        #ifdef __SAM3X8E__
-          raw_powconsumption_value = analogRead(POWER_CONSUMPTION_PIN);
-        #else
-          raw_powconsumption_value += ADC;
+        lcd_buttons_update();
+        temp_state = Measure_POWCONSUMPTION;
+        break;
+      case Measure_POWCONSUMPTION:
+        #if HAS(POWER_CONSUMPTION_SENSOR)
+          #ifdef __SAM3X8E__
+            raw_powconsumption_value = analogRead(POWER_CONSUMPTION_PIN);
+          #else
+            raw_powconsumption_value += ADC;
+          #endif
         #endif
-      #endif
-      temp_state = PrepareTemp_0;
-      temp_count++;
-      break;
+        temp_state = PrepareTemp_0;
+        temp_count++;
+        break;
 
-    case StartupDelay:
-      temp_state = PrepareTemp_0;
-      break;
+      case StartupDelay:
+        temp_state = PrepareTemp_0;
+        break;
 
-    // default:
-    //  SERIAL_LM(ER, MSG_TEMP_READ_ERROR);
-    //  break;
-  } // switch(temp_state)
+      // default:
+      //  SERIAL_LM(ER, MSG_TEMP_READ_ERROR);
+      //  break;
+    } // switch(temp_state)
 
-  #ifdef __SAM3X8E__
+  #endif // !ADC_DMA
+
+  #if ENABLED(ADC_DMA)
+    if (++temp_count >= ADC_DMA_UPDATE_TICKS) {
+      adc_dma_update();
+  #elif defined(__SAM3X8E__)
     if (temp_count >= OVERSAMPLENR + 2) { // 14 * 16 * 1/(16000000/64/256)  = 164ms.
   #else
     if (temp_count >= OVERSAMPLENR) { // 10 * 16 * 1/(16000000/64/256)  = 164ms.
@@ -2603,6 +3090,13 @@ static void set_current_temp_raw() {
 
     // Filament Sensor - can be read any time since IIR filtering is used
     #if HAS(FILAMENT_SENSOR)
+      #if ENABLED(ADC_DMA)
+        const unsigned long filwidth_adc = adc_dma_raw[ADC_DMA_SLOT_FILWIDTH] / (OVERSAMPLENR);
+        if (filwidth_adc > 102) { // check that ADC is reading a voltage > 0.5 volts, otherwise don't take in the data.
+          raw_filwidth_value -= (raw_filwidth_value >> 7);
+          raw_filwidth_value += (filwidth_adc << 7);
+        }
+      #endif
       current_raw_filwidth = raw_filwidth_value >> 10;  // Divide to get to 0-16384 range since we used 1/128 IIR filter approach
     #endif
 
@@ -2702,6 +3196,8 @@ static void set_current_temp_raw() {
       }
     }
   #endif //BABYSTEPPING
+
+  ISR_PROFILE_END(ISR_PROFILE_TEMPERATURE, F_CPU / (TEMP_FREQUENCY));
 }
 
 #if ENABLED(PIDTEMP) || ENABLED(PIDTEMPBED) || ENABLED(PIDTEMPCHAMBER) || ENABLED(PIDTEMPCOOLER)
@@ -51,8 +51,15 @@
   #define HOTEND_INDEX  h
 #endif
 
-#if ENABLED(PIDTEMPBED) || ENABLED(PIDTEMP)  || ENABLED(PIDTEMPCHAMBER) || ENABLED(PIDTEMPCOOLER)
-  #ifdef __SAM3X8E__
+#if ENABLED(ADC_DMA)
+  // Temperature ISR ticks between two new temperatures
+  #define ADC_DMA_UPDATE_TICKS ((TEMP_FREQUENCY) / (ADC_DMA_UPDATE_FREQUENCY))
+#endif
+
+#if ENABLED(PIDTEMPBED) || ENABLED(PIDTEMP)  || ENABLED(PIDTEMPCHAMBER) || ENABLED(PIDTEMPCOOLER) || ENABLED(MPCTEMP)
+  #if ENABLED(ADC_DMA)
+    #define PID_dT ((ADC_DMA_UPDATE_TICKS) / (float)(TEMP_FREQUENCY))
+  #elif defined(__SAM3X8E__)
     #define PID_dT (((OVERSAMPLENR + 2) * 14.0)/ TEMP_FREQUENCY)
   #else
     #define PID_dT ((OVERSAMPLENR * 12.0)/(F_CPU / 64.0 / 256.0))
@@ -112,6 +119,20 @@ extern float current_temperature_cooler;
   #define PID_PARAM(param, h) param[h] // use macro to point to array value
 #endif
 
+#if ENABLED(MPCTEMP)
+  // Thermal model of a hotend
+  typedef struct {
+    float heater_power;                 // W
+    float block_heat_capacity;          // J/K
+    float sensor_responsiveness;        // K/s per K
+    float ambient_xfer_coeff_fan0;      // W/K
+    float fan255_adjustment;            // W/K added with the part fan at 255
+    float filament_heat_capacity_permm; // J/K/mm
+  } mpc_t;
+
+  extern mpc_t mpc[HOTENDS];
+#endif
+
 #if ENABLED(PIDTEMPBED)
   extern float bedKp, bedKi, bedKd;
 #endif
@@ -291,6 +312,11 @@ void updatePID();
   void PID_autotune(float temp, int temp_controller, int ncycles, bool set_result = false);
 #endif
 
+#if ENABLED(MPCTEMP)
+  void MPC_autotune(uint8_t h, float temp);
+  void reset_mpc_model();
+#endif
+
 void checkExtruderAutoFans();
 extern void autotempShutdown();
 
@@ -0,0 +1,143 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * adc_filter_test: the ADC_DMA sample filter (src/temperature/adc_filter.h)
+ * on the host
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../src/temperature/adc_filter.h"
+
+#define OVERSAMPLE 16   // OVERSAMPLENR of the Due
+#define MEDIAN      5   // ADC_DMA_MEDIAN default
+
+static int checks = 0, failures = 0;
+
+#define CHECK_EQUAL(A, B) do { \
+  const long actual = (A), expected = (B); \
+  checks++; \
+  if (actual != expected) { failures++; printf("%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #A, actual, expected); } \
+} while (0)
+
+static void fill(adc_window_t &w, const uint16_t* samples, const uint8_t n) {
+  adc_window_reset(w);
+  for (uint8_t i = 0; i < n; i++) adc_window_add(w, samples[i]);
+}
+
+static void test_window() {
+  adc_window_t w;
+
+  // A steady 12 bit reading is OVERSAMPLE readings of its 10 bit value
+  const uint16_t steady[] = { 2000, 2000, 2000, 2000 };
+  fill(w, steady, 4);
+  CHECK_EQUAL(w.count, 4);
+  CHECK_EQUAL(adc_window_value(w, OVERSAMPLE), 500 * OVERSAMPLE);
+
+  const uint16_t top[] = { 4095, 4095, 4095 };
+  fill(w, top, 3);
+  CHECK_EQUAL(adc_window_value(w, OVERSAMPLE), 16380);
+
+  // The highest and lowest samples are dropped
+  const uint16_t spikes[] = { 1000, 0, 1000, 4095, 1000 };
+  fill(w, spikes, 5);
+  CHECK_EQUAL(w.min, 0);
+  CHECK_EQUAL(w.max, 4095);
+  CHECK_EQUAL(adc_window_value(w, OVERSAMPLE), 250 * OVERSAMPLE);
+
+  // Rounded to the nearest, 1001 and 1002 average to 1001.5
+  const uint16_t odd[] = { 1001, 1001, 1002, 1002 };
+  fill(w, odd, 4);
+  CHECK_EQUAL(adc_window_value(w, OVERSAMPLE), (1001 * 2 + 1) * OVERSAMPLE / 8);
+
+  // 60000 full scale samples still fit the sum scaled by OVERSAMPLE
+  adc_window_reset(w);
+  for (uint32_t i = 0; i < 60000; i++) adc_window_add(w, 4095);
+  CHECK_EQUAL(adc_window_value(w, OVERSAMPLE), 16380);
+}
+
+static void test_median() {
+  const uint16_t a[] = { 5, 1, 4, 2, 3 };
+  CHECK_EQUAL(adc_median(a, 5), 3);
+  const uint16_t b[] = { 7 };
+  CHECK_EQUAL(adc_median(b, 1), 7);
+  const uint16_t c[] = { 9, 9, 1, 1, 9, 1, 9, 1, 5 };
+  CHECK_EQUAL(adc_median(c, 9), 5);
+  const uint16_t d[] = { 100, 100, 100 };
+  CHECK_EQUAL(adc_median(d, 3), 100);
+}
+
+static void test_update() {
+  adc_window_t w;
+  uint16_t history[MEDIAN];
+  bool valid = false;
+  int raw = -1;
+  uint8_t index = 0;
+
+  // Too few samples: raw keeps its value and the history stays empty
+  const uint16_t two[] = { 1000, 1000 };
+  fill(w, two, 2);
+  CHECK_EQUAL(adc_filter_update(w, history, MEDIAN, index, valid, raw, OVERSAMPLE), false);
+  CHECK_EQUAL(raw, -1);
+  CHECK_EQUAL(valid, false);
+  CHECK_EQUAL(w.count, 0);
+
+  // The first window fills the history
+  const uint16_t first[] = { 1000, 1000, 1000 };
+  fill(w, first, 3);
+  CHECK_EQUAL(adc_filter_update(w, history, MEDIAN, index, valid, raw, OVERSAMPLE), true);
+  CHECK_EQUAL(raw, 250 * OVERSAMPLE);
+  CHECK_EQUAL(valid, true);
+  for (uint8_t i = 0; i < MEDIAN; i++) CHECK_EQUAL(history[i], 250 * OVERSAMPLE);
+  index = (index + 1) % MEDIAN;
+
+  // A window spoiled as a whole is outvoted until it is half the history
+  const uint16_t spike[] = { 4000, 4000, 4000 }, normal[] = { 1000, 1000, 1000 };
+  for (uint8_t n = 0; n < 2; n++) {
+    fill(w, spike, 3);
+    adc_filter_update(w, history, MEDIAN, index, valid, raw, OVERSAMPLE);
+    index = (index + 1) % MEDIAN;
+    CHECK_EQUAL(raw, 250 * OVERSAMPLE);
+  }
+  fill(w, spike, 3);
+  adc_filter_update(w, history, MEDIAN, index, valid, raw, OVERSAMPLE);
+  index = (index + 1) % MEDIAN;
+  CHECK_EQUAL(raw, 1000 * OVERSAMPLE);
+
+  // A real step shows up after MEDIAN / 2 + 1 windows
+  for (uint8_t n = 0; n < MEDIAN; n++) {
+    fill(w, normal, 3);
+    adc_filter_update(w, history, MEDIAN, index, valid, raw, OVERSAMPLE);
+    index = (index + 1) % MEDIAN;
+    CHECK_EQUAL(raw, n < MEDIAN / 2 ? 1000 * OVERSAMPLE : 250 * OVERSAMPLE);
+  }
+}
+
+int main() {
+  test_window();
+  test_median();
+  test_update();
+  printf("adc_filter_test: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
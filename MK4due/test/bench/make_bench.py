@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+#
+# Benchmark G-code for planner_sim
+#
+#   make_bench.py arcs|infill|spiral > file.gcode
+#
+# arcs    circles cut in 0.1 mm segments, the worst case for look-ahead
+# infill  short zigzag lines with a sharp corner at every end
+# spiral  a vase mode spiral, Z and E on every segment
+#
+
+import math
+import sys
+
+def header():
+    print("G21\nG90\nM82\nG28\nG92 E0\nG1 Z0.2 F600")
+
+def arcs():
+    e = 0.0
+    for ring in range(20):
+        r = 5.0 + ring * 2.0
+        n = int(2 * math.pi * r / 0.1)
+        print("G0 X%.3f Y100.000 F9000" % (100.0 + r))
+        for i in range(1, n + 1):
+            a = 2 * math.pi * i / n
+            e += 2 * math.pi * r / n * 0.033
+            print("G1 X%.3f Y%.3f E%.5f F3000" % (100.0 + r * math.cos(a), 100.0 + r * math.sin(a), e))
+
+def infill():
+    e = 0.0
+    y = 50.0
+    for layer in range(4):
+        print("G1 Z%.2f F600" % (0.2 + layer * 0.2))
+        for i in range(500):
+            x = 50.0 + (i % 2) * 4.0
+            y += 0.2 if layer % 2 == 0 else -0.2
+            e += 4.0 * 0.033
+            print("G1 X%.3f Y%.3f E%.5f F6000" % (x, y, e))
+
+def spiral():
+    e = 0.0
+    z = 0.2
+    r = 20.0
+    n = 100
+    for turn in range(30):
+        for i in range(n):
+            a = 2 * math.pi * i / n
+            z += 0.2 / n
+            e += 2 * math.pi * r / n * 0.033
+            print("G1 X%.3f Y%.3f Z%.4f E%.5f F2400" % (100.0 + r * math.cos(a), 100.0 + r * math.sin(a), z, e))
+
+if __name__ == '__main__':
+    cases = { 'arcs': arcs, 'infill': infill, 'spiral': spiral }
+    if len(sys.argv) != 2 or sys.argv[1] not in cases:
+        sys.exit("usage: make_bench.py %s" % "|".join(sorted(cases)))
+    header()
+    cases[sys.argv[1]]()
+    print("M400")
@@ -0,0 +1,134 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * decode_test: the G-code parser and binary decoder of the firmware
+ * (src/communication/parser.cpp) on the host, driven by
+ * scripts/binary_gcode.py and scripts/binary_print.py, which compare
+ * its output with their own decoding.
+ *
+ * Each input line is a request:
+ *
+ *   A <line>   Parse an ASCII command with parse_command()
+ *   P <hex>    Decode a packet payload with binary_decode_command()
+ *   F <hex>    Decode a print file record, with the delta bases of
+ *              the records before it
+ *   R          Clear the delta bases, as a file start or a seek does
+ *
+ * Each request but R prints the command line the firmware queues and the
+ * parsed command, as "line<TAB>code<TAB>codenum<TAB>X=1.5 Y=0 ...", or
+ * "error" if the decoder refuses it. Letters are listed in order with the
+ * value code_value_float() returns. A decoded command is also parsed back
+ * from its line, and must give the same parsed command as the decoder,
+ * else "mismatch" is printed and the exit code is 1.
+ */
+
+#include "../base.h"
+
+static bool same_parse(const parsed_command_t &a, const parsed_command_t &b) {
+  if (a.code != b.code) return false;
+  if (!a.code) return true;
+  if (a.codenum != b.codenum || a.command != b.command || a.args != b.args || a.letters != b.letters) return false;
+  for (uint8_t i = 0; i < 26; i++) {
+    if (!TEST(a.letters, i)) continue;
+    if (a.offset[i] != b.offset[i]) return false;
+    // The decoder divides the whole value, parse_float() stops at 9 digits
+    if (fabs(a.value[i] - b.value[i]) > 1e-6 * max(1.0, fabs(a.value[i]))) return false;
+  }
+  return true;
+}
+
+static void print_parse(const char* line, const parsed_command_t &parsed) {
+  printf("%s\t", line);
+  if (!parsed.code) {
+    printf("-\t-\t\n");
+    return;
+  }
+  printf("%c\t%u\t", parsed.code, parsed.codenum);
+  bool first = true;
+  for (uint8_t i = 0; i < 26; i++) {
+    if (!TEST(parsed.letters, i)) continue;
+    printf("%s%c=%.9g", first ? "" : " ", 'A' + i, parsed.value[i]);
+    first = false;
+  }
+  printf("\n");
+}
+
+static int8_t hex_digit(const char c) {
+  if (NUMERIC(c)) return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+int main() {
+  int32_t last_value[26];
+  int8_t last_decimals[26];
+  memset(last_decimals, -1, sizeof(last_decimals));
+
+  char request[1024], line[MAX_CMD_SIZE];
+  uint8_t payload[256];
+  parsed_command_t parsed, reparsed;
+  int failures = 0;
+
+  while (fgets(request, sizeof(request), stdin)) {
+    request[strcspn(request, "\r\n")] = '\0';
+    const char* arg = request[0] ? request + 1 : request;
+    if (*arg == ' ') arg++;
+
+    switch (request[0]) {
+      case 'R':
+        memset(last_decimals, -1, sizeof(last_decimals));
+        break;
+
+      case 'A':
+        strncpy(line, arg, MAX_CMD_SIZE - 1);
+        line[MAX_CMD_SIZE - 1] = '\0';
+        parse_command(line, parsed);
+        print_parse(line, parsed);
+        break;
+
+      case 'P':
+      case 'F': {
+        uint16_t len = 0;
+        for (const char* p = arg; hex_digit(p[0]) >= 0 && hex_digit(p[1]) >= 0 && len < sizeof(payload); p += 2)
+          payload[len++] = (hex_digit(p[0]) << 4) | hex_digit(p[1]);
+        const bool file = request[0] == 'F';
+        if (!binary_decode_command(payload, payload + len, line, parsed, file ? last_value : NULL, file ? last_decimals : NULL)) {
+          printf("error\n");
+          break;
+        }
+        parse_command(line, reparsed);
+        if (!same_parse(parsed, reparsed)) {
+          printf("mismatch\t%s\n", line);
+          failures++;
+          break;
+        }
+        print_parse(line, parsed);
+      } break;
+
+      default:
+        printf("error\n");
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,59 @@
+; Commands of the kinds slicers and hosts send, for the tests of
+; scripts/binary_gcode.py and scripts/binary_print.py
+M140 S60
+M104 S210 T0
+M190 S60
+M109 S210
+G21
+G90
+M82
+M107
+G28
+G29
+M420 S1
+M117 Printing sample.gcode
+G92 E0
+G1 Z5.0 F9000
+G1 X0.1 Y20 Z0.3 F5000.0
+G1 X0.1 Y200.0 Z0.3 F1500.0 E15
+G1 X0.4 Y200.0 Z0.3 F5000.0
+G1 X0.4 Y20 Z0.3 F1500.0 E30
+G92 E0
+G1 E-5.00000 F2400
+;LAYER:0
+M106 S255
+G0 F9000 X85.627 Y86.304 Z0.3
+G1 E0.00000 F2400
+G1 F1200 X86.416 Y85.715 E0.03275
+G1 X87.260 Y85.209 E0.06548
+G1 X88.151 Y84.791 E0.09820
+G1 X-1.5 Y-0.25 E0.1
+G1 X1.23456 Y2.345678 E0.123456
+G1 X100000 Y0.00001
+G2 X10 Y10 I5 J0 E1.5
+G3 X0 Y0 R7.07 E2
+G4 P500
+M204 P1500 T3000 R2000
+M205 X10 Z0.4 E5
+M593 X F40 D0.1 T1
+M900 K0.05
+M220 S100
+M221 S95
+;LAYER:1
+G1 Z0.5
+G1 X90 Y90 E2.5
+T1
+G1 X91 Y90 E2.6
+T0
+M503
+M500
+G1 X92 Y90 E2.7 ; a comment after a move
+N10 G1 X93 Y90*96
+M23 sample.gcode
+M32 !/folder/file.gcode#
+M928 log.txt
+G1 X94 Y90 E2.8:G1 X95 Y90 E2.9
+M400
+M84
+M104 S0
+M140 S0
@@ -0,0 +1,390 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * planner_sim: replay a G-code file through the planner and the stepper
+ * interrupt on the host, in virtual time.
+ *
+ * src/planner/planner.cpp, src/motion/stepper.cpp and src/endstop/endstops.cpp
+ * are built unchanged against the host HAL in stubs/. The moves are read
+ * here, not by MK_Main.cpp: G0/G1, G4, G28 (sets the position, no homing),
+ * G90/G91, G92, M82/M83, M92, M201, M203, M204, M205, M220 and M400 are
+ * handled, other commands are counted and skipped. Arcs must already be
+ * split into G1 segments.
+ *
+ * The stepper and the other timer interrupts run at the times they set,
+ * while the main code takes no virtual time, so the planner is always as
+ * far ahead as the buffer allows. The step pulses are taken from the
+ * step pins.
+ *
+ * planner_sim_shaping is the same program built with INPUT_SHAPING. X and
+ * Y then step from the shaping interrupt (TC6), so the step times are the
+ * shaped ones, and M593 sets the shapers as in MK_Main.cpp.
+ *
+ *   planner_sim [-b] [-s <steps.csv>] <file.gcode>
+ *
+ *   -b  Print the profile of each block once the stepper is done with it:
+ *       length, entry, peak and exit speed (mm/s), acceleration and the
+ *       time from its first to its last step
+ *   -s  Write each step as "time_us,axis,direction,interrupt", where
+ *       interrupt is stepper, shaping or advance
+ *
+ * The summary has the virtual print time, the steps of each axis, and the
+ * host time spent in Planner::buffer_line(), without its waits for a free
+ * block.
+ */
+
+#include "../base.h"
+#include "stubs/host_hal.h"
+
+#include <time.h>
+
+/**
+ * Stand-ins for MK_Main.cpp and temperature.cpp
+ */
+float current_position[NUM_AXIS] = { 0.0 };
+bool axis_known_position[XYZ] = { true, true, true };
+uint8_t mk_debug_flags = DEBUG_NONE;
+uint8_t active_extruder = 0, active_driver = 0;
+int flow_percentage[EXTRUDERS] = ARRAY_BY_EXTRUDERS(100);
+float volumetric_multiplier[EXTRUDERS] = ARRAY_BY_EXTRUDERS(1.0);
+int fanSpeed = 0;
+#if MB(ALLIGATOR)
+  float motor_current[3 + DRIVER_EXTRUDERS];
+  void ExternalDac::setValue(uint8_t, uint8_t) {}
+#endif
+int target_temperature[4] = { 0 };
+float current_temperature[4] = { 0.0 };
+float extrude_min_temp = EXTRUDE_MINTEMP;
+bool allow_cold_extrude = true;
+
+bool code_seen(char) { return false; }
+float code_value_temp_abs() { return 0.0; }
+float code_value_temp_diff() { return 0.0; }
+void enqueue_and_echo_commands_P(const char*) {}
+
+/**
+ * Step pins
+ */
+#define _SIM_PORT(IO) DIO ## IO ## _PORT
+#define _SIM_MASK(IO) DIO ## IO ## _PIN
+#define SIM_PORT(IO)  _SIM_PORT(IO)
+#define SIM_MASK(IO)  _SIM_MASK(IO)
+
+typedef struct {
+  char name;
+  Pio *step_port, *dir_port;
+  uint32_t step_mask, dir_mask;
+  bool step_invert, dir_invert, level;
+  long steps, position, shaped;
+} sim_axis_t;
+
+static sim_axis_t sim_axis[] = {
+  { 'X', SIM_PORT(X_STEP_PIN), SIM_PORT(X_DIR_PIN), SIM_MASK(X_STEP_PIN), SIM_MASK(X_DIR_PIN), INVERT_X_STEP_PIN, INVERT_X_DIR, false, 0, 0, 0 },
+  { 'Y', SIM_PORT(Y_STEP_PIN), SIM_PORT(Y_DIR_PIN), SIM_MASK(Y_STEP_PIN), SIM_MASK(Y_DIR_PIN), INVERT_Y_STEP_PIN, INVERT_Y_DIR, false, 0, 0, 0 },
+  { 'Z', SIM_PORT(Z_STEP_PIN), SIM_PORT(Z_DIR_PIN), SIM_MASK(Z_STEP_PIN), SIM_MASK(Z_DIR_PIN), INVERT_Z_STEP_PIN, INVERT_Z_DIR, false, 0, 0, 0 },
+  { 'E', SIM_PORT(E0_STEP_PIN), SIM_PORT(E0_DIR_PIN), SIM_MASK(E0_STEP_PIN), SIM_MASK(E0_DIR_PIN), INVERT_E_STEP_PIN, INVERT_E0_DIR, false, 0, 0, 0 }
+};
+
+static FILE* steps_file = NULL;
+
+// A step is the edge to the active level of the step pin
+static void sim_pio_write(Pio* pio, uint32_t mask, bool set) {
+  for (uint8_t i = 0; i < COUNT(sim_axis); i++) {
+    sim_axis_t &a = sim_axis[i];
+    if (pio != a.step_port || !(mask & a.step_mask) || a.level == set) continue;
+    a.level = set;
+    if (set == a.step_invert) continue;
+    const bool forward = ((a.dir_port->PIO_ODSR & a.dir_mask) != 0) != a.dir_invert;
+    a.steps++;
+    if (host_isr && !strcmp(host_isr, "shaping")) a.shaped++;
+    a.position += forward ? 1 : -1;
+    if (steps_file)
+      fprintf(steps_file, "%.3f,%c,%d,%s\n", host_ticks * 1000000.0 / HAL_TIMER_RATE, a.name, forward ? 1 : -1, host_isr ? host_isr : "main");
+  }
+}
+
+/**
+ * Block profiles, taken when the stepper takes and releases each block
+ */
+static bool print_blocks = false;
+static uint32_t blocks_done = 0;
+static uint8_t sim_tail = 0;
+static uint64_t block_start[BLOCK_BUFFER_SIZE];
+static bool block_started[BLOCK_BUFFER_SIZE];
+
+static void sim_watch_blocks() {
+  const uint8_t tail = planner.block_buffer_tail;
+  if (tail != planner.block_buffer_head && planner.block_buffer[tail].busy && !block_started[tail]) {
+    block_started[tail] = true;
+    block_start[tail] = host_ticks;
+  }
+
+  while (sim_tail != tail) {
+    const block_t* block = &planner.block_buffer[sim_tail];
+    blocks_done++;
+    if (print_blocks) {
+      const float mm_per_step = block->millimeters / block->step_event_count,
+                  v0 = block->initial_rate * mm_per_step,
+                  v1 = block->final_rate * mm_per_step,
+                  a = block->acceleration,
+                  L = block->millimeters,
+                  vp = min(block->nominal_speed, (float)sqrt((2.0 * a * L + sq(v0) + sq(v1)) * 0.5));
+      printf("block %lu mm:%.4f v0:%.3f vc:%.3f v1:%.3f a:%.1f steps:%lu t_ms:%.4f\n",
+        (unsigned long)blocks_done, L, v0, vp, v1, a, block->step_event_count,
+        (host_ticks - block_start[sim_tail]) * 1000.0 / HAL_TIMER_RATE);
+    }
+    block_started[sim_tail] = false;
+    sim_tail = (sim_tail + 1) & (BLOCK_BUFFER_SIZE - 1);
+  }
+}
+
+static double host_seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The main code waits for the stepper: run the next interrupt
+void idle(
+  #if ENABLED(FILAMENT_CHANGE_FEATURE)
+    bool no_stepper_sleep
+  #endif
+) {
+  host_run_next();
+  sim_watch_blocks();
+}
+
+/**
+ * G-code
+ */
+static bool relative_mode = false, relative_e = false;
+static float feedrate_mm_s = 1500.0 / 60.0;
+int feedrate_percentage = 100;
+static double planner_seconds = 0.0;
+static uint32_t planned_moves = 0, skipped_commands = 0;
+static const char axis_codes[NUM_AXIS] = { 'X', 'Y', 'Z', 'E' };
+
+static bool param(const char* args, char letter, float &value) {
+  for (const char* p = args; *p; p++)
+    if (*p == letter) { value = strtod(p + 1, NULL); return true; }
+  return false;
+}
+
+static void sync_position() {
+  planner.set_position_mm(current_position[X_AXIS], current_position[Y_AXIS], current_position[Z_AXIS], current_position[E_AXIS]);
+}
+
+static void reset_defaults() {
+  const float steps[] = DEFAULT_AXIS_STEPS_PER_UNIT, feedrate[] = DEFAULT_MAX_FEEDRATE,
+              accel[] = DEFAULT_MAX_ACCELERATION, retract[] = DEFAULT_RETRACT_ACCELERATION,
+              ejerk[] = DEFAULT_EJERK;
+  for (uint8_t i = 0; i < 3 + EXTRUDERS; i++) {
+    planner.axis_steps_per_mm[i] = steps[i];
+    planner.max_feedrate_mm_s[i] = feedrate[i];
+    planner.max_acceleration_mm_per_s2[i] = accel[i];
+  }
+  for (uint8_t i = 0; i < EXTRUDERS; i++) {
+    planner.retract_acceleration[i] = retract[i];
+    planner.max_e_jerk[i] = ejerk[i];
+  }
+  planner.acceleration = DEFAULT_ACCELERATION;
+  planner.travel_acceleration = DEFAULT_TRAVEL_ACCELERATION;
+  planner.min_feedrate_mm_s = DEFAULT_MINIMUMFEEDRATE;
+  planner.min_segment_time = DEFAULT_MINSEGMENTTIME;
+  planner.min_travel_feedrate_mm_s = DEFAULT_MINTRAVELFEEDRATE;
+  planner.max_xy_jerk = DEFAULT_XYJERK;
+  planner.max_z_jerk = DEFAULT_ZJERK;
+  #if ENABLED(JUNCTION_DEVIATION)
+    planner.junction_deviation_mm = JUNCTION_DEVIATION_MM;
+  #endif
+  planner.reset_acceleration_rates();
+  planner.refresh_positioning();
+}
+
+static void process_line(char* line) {
+  char* p = strchr(line, ';');
+  if (p) *p = '\0';
+  while (*line == ' ' || *line == '\t') line++;
+  if (*line == 'N') while (*line && *line != ' ') line++;
+  while (*line == ' ') line++;
+  if (!*line) return;
+
+  const char code = toupper(*line);
+  const int num = atoi(line + 1);
+  char* args = line + 1;
+  while (NUMERIC(*args) || *args == '.') args++;
+  for (char* c = args; *c; c++) *c = toupper(*c);
+  float v;
+
+  switch (code == 'G' ? num : code == 'M' ? 1000 + num : -1) {
+    case 0: case 1: {
+      float target[NUM_AXIS];
+      bool moves = false;
+      LOOP_XYZE(i) {
+        target[i] = current_position[i];
+        if (param(args, axis_codes[i], v)) {
+          target[i] = (i == E_AXIS ? relative_e || relative_mode : relative_mode) ? current_position[i] + v : v;
+          moves |= target[i] != current_position[i];
+        }
+      }
+      if (param(args, 'F', v) && v > 0.0) feedrate_mm_s = MMM_TO_MMS(v);
+      if (!moves) break;
+      // Wait for a free block here, so only the planning is timed
+      while (planner.block_buffer_tail == ((planner.block_buffer_head + 1) & (BLOCK_BUFFER_SIZE - 1))) idle();
+      const double start = host_seconds();
+      planner.buffer_line(target[X_AXIS], target[Y_AXIS], target[Z_AXIS], target[E_AXIS],
+                          feedrate_mm_s * feedrate_percentage * 0.01, active_extruder, active_driver);
+      planner_seconds += host_seconds() - start;
+      planned_moves++;
+      LOOP_XYZE(i) current_position[i] = target[i];
+    } break;
+    case 4: {
+      float ms = 0.0;
+      if (param(args, 'P', v)) ms = v;
+      if (param(args, 'S', v)) ms = v * 1000.0;
+      stepper.synchronize();
+      host_run_until(host_ticks + (uint64_t)(ms * (HAL_TIMER_RATE / 1000)));
+      sim_watch_blocks();
+    } break;
+    case 28: {
+      stepper.synchronize();
+      const bool all = !strpbrk(args, "XYZ");
+      LOOP_XYZ(i) if (all || strchr(args, axis_codes[i])) current_position[i] = 0.0;
+      sync_position();
+    } break;
+    case 21: break;
+    case 90: relative_mode = false; break;
+    case 91: relative_mode = true; break;
+    case 92:
+      LOOP_XYZE(i) if (param(args, axis_codes[i], v)) current_position[i] = v;
+      sync_position();
+      break;
+    case 1082: relative_e = false; break;
+    case 1083: relative_e = true; break;
+    case 1092:
+      stepper.synchronize();
+      LOOP_XYZE(i) if (param(args, axis_codes[i], v)) planner.axis_steps_per_mm[i] = v;
+      planner.refresh_positioning();
+      break;
+    case 1201:
+      LOOP_XYZE(i) if (param(args, axis_codes[i], v)) planner.max_acceleration_mm_per_s2[i] = v;
+      planner.reset_acceleration_rates();
+      break;
+    case 1203:
+      LOOP_XYZE(i) if (param(args, axis_codes[i], v)) planner.max_feedrate_mm_s[i] = v;
+      break;
+    case 1204:
+      if (param(args, 'S', v)) planner.acceleration = planner.travel_acceleration = v;
+      if (param(args, 'P', v)) planner.acceleration = v;
+      if (param(args, 'R', v)) planner.retract_acceleration[active_extruder] = v;
+      if (param(args, 'T', v)) planner.travel_acceleration = v;
+      break;
+    case 1205:
+      if (param(args, 'X', v)) planner.max_xy_jerk = v;
+      if (param(args, 'Z', v)) planner.max_z_jerk = v;
+      if (param(args, 'E', v)) planner.max_e_jerk[active_extruder] = v;
+      #if ENABLED(JUNCTION_DEVIATION)
+        if (param(args, 'J', v)) planner.junction_deviation_mm = v;
+      #endif
+      break;
+    case 1220:
+      if (param(args, 'S', v)) feedrate_percentage = v;
+      break;
+    case 1400:
+      stepper.synchronize();
+      break;
+    #if ENABLED(INPUT_SHAPING)
+      case 1593: {
+        const bool seen_x = strchr(args, 'X'), seen_y = strchr(args, 'Y'),
+                   axis[2] = { seen_x || !seen_y, seen_y || !seen_x };
+        stepper.synchronize();
+        for (uint8_t i = X_AXIS; i <= Y_AXIS; i++) {
+          if (!axis[i]) continue;
+          if (param(args, 'T', v)) stepper.shaping_type[i] = constrain((int)v, SHAPER_NONE, SHAPER_MZV);
+          if (param(args, 'F', v)) stepper.shaping_frequency[i] = v > 0.0 ? max(v, SHAPING_MIN_FREQ) : 0.0;
+          if (param(args, 'D', v)) stepper.shaping_zeta[i] = constrain(v, 0.0, SHAPING_MAX_ZETA);
+        }
+        stepper.refresh_shaping();
+      } break;
+    #endif
+    default:
+      skipped_commands++;
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-b")) print_blocks = true;
+    else if (!strcmp(argv[i], "-s") && i + 1 < argc) {
+      steps_file = fopen(argv[++i], "w");
+      if (!steps_file) { perror(argv[i]); return 1; }
+    }
+    else path = argv[i];
+  }
+  FILE* f = path ? fopen(path, "r") : NULL;
+  if (!f) {
+    fprintf(stderr, "usage: planner_sim [-b] [-s <steps.csv>] <file.gcode>\n");
+    return 1;
+  }
+
+  host_pio_hook = sim_pio_write;
+  reset_defaults();
+  planner.init();
+  stepper.init();
+  endstops.enable_globally(false);
+  // Let the pins settle, with every output at its inactive level
+  host_run_until(HAL_TIMER_RATE / 100);
+  for (uint8_t i = 0; i < COUNT(sim_axis); i++) {
+    sim_axis_t &a = sim_axis[i];
+    a.level = (a.step_port->PIO_ODSR & a.step_mask) != 0;
+    a.steps = a.position = a.shaped = 0;
+  }
+  const uint64_t start = host_ticks;
+  const double wall_start = host_seconds();
+
+  char line[256];
+  while (fgets(line, sizeof(line), f)) process_line(line);
+  fclose(f);
+  stepper.synchronize();
+  sim_watch_blocks();
+  if (steps_file) fclose(steps_file);
+
+  const double wall = host_seconds() - wall_start;
+  printf("moves: %lu blocks: %lu skipped commands: %lu\n", (unsigned long)planned_moves, (unsigned long)blocks_done, (unsigned long)skipped_commands);
+  printf("print time: %.3f s\n", (host_ticks - start) / (double)HAL_TIMER_RATE);
+  for (uint8_t i = 0; i < COUNT(sim_axis); i++)
+    printf("%c steps: %ld shaped: %ld position: %ld stepper: %ld\n", sim_axis[i].name, sim_axis[i].steps, sim_axis[i].shaped, sim_axis[i].position, stepper.position((AxisEnum)i));
+  #if ENABLED(INPUT_SHAPING)
+    printf("unshaped steps: %lu\n", (unsigned long)stepper.shaping_overflows);
+  #endif
+  printf("host: %.3f s, planner %.2f us per move\n", wall, planned_moves ? planner_seconds * 1e6 / planned_moves : 0.0);
+
+  // The pulses on the pins must add up to the stepper's own count
+  for (uint8_t i = 0; i < COUNT(sim_axis); i++)
+    if (sim_axis[i].position != stepper.position((AxisEnum)i)) {
+      printf("error: %c pulses don't match the stepper position\n", sim_axis[i].name);
+      return 2;
+    }
+  return 0;
+}
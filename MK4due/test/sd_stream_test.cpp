@@ -0,0 +1,261 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * sd_stream_test: the background reads of the printing file (SD_SPI_DMA)
+ * against the fake card of stubs/host_sd.cpp
+ *
+ * src/sd/cardreader.cpp and src/sd/SDFat.cpp are built unchanged. The
+ * card holds a FAT16 volume made here, with a file whose clusters are
+ * in four runs, so CardReader::get() crosses cluster jumps. The test
+ * checks every byte get() returns, and from the commands the card saw:
+ *
+ *   - one CMD18 per run of blocks, the following blocks of a run only
+ *     wait for their start token
+ *   - the CMD12 that cardCommand() sends before any other command while
+ *     a CMD18 is open, for a jump, a seek or another card access
+ *   - that setIndex() drops both buffers, even inside the current block
+ *   - that no byte moves on the bus while a DMA read is pending
+ */
+
+#include "stubs/host_sd.h"
+#include "../base.h"
+#include "stubs/host_hal.h"
+
+/**
+ * Stand-ins for MK_Main.cpp and temperature.cpp
+ */
+float current_position[NUM_AXIS] = { 0.0 };
+uint8_t active_extruder = 0;
+int fanSpeed = 0;
+int target_temperature[4] = { 0 }, target_temperature_bed = 0;
+PrintCounter print_job_counter;
+CardReader card;
+
+void disable_all_heaters() {}
+void disable_all_coolers() {}
+void enqueue_and_echo_commands_P(const char*) {}
+void Stepper::synchronize() {}
+
+static int checks = 0, failures = 0;
+
+#define CHECK_EQUAL(A, B) do { \
+  const long actual = (A), expected = (B); \
+  checks++; \
+  if (actual != expected) { failures++; printf("%s:%d: %s is %ld, expected %ld\n", __FILE__, __LINE__, #A, actual, expected); } \
+} while (0)
+
+/**
+ * The volume: FAT16 without partition table, 2 blocks per cluster
+ */
+#define VOLUME_BLOCKS   8704
+#define FAT_BLOCKS      17
+#define ROOT_ENTRIES    512
+#define DATA_START      (1 + 2 * FAT_BLOCKS + ROOT_ENTRIES * 32 / 512)
+#define CLUSTER_BLOCK(C) (DATA_START + ((C) - 2) * 2)
+
+// Clusters of TEST.GCO, in the order of the file
+static const uint16_t file_clusters[] = { 2, 3, 4, 10, 11, 5, 30, 31, 32, 33 };
+#define FILE_CLUSTERS   COUNT(file_clusters)
+#define FILE_RUNS       4
+#define FILE_SIZE       (FILE_CLUSTERS * 1024 - 300)
+
+static uint8_t file_byte(const uint32_t pos) { return (pos * 31 + (pos >> 9)) & 0xFF; }
+
+static uint8_t* image_file_byte(const uint32_t pos) {
+  const uint32_t block = CLUSTER_BLOCK(file_clusters[pos >> 10]) + ((pos >> 9) & 1);
+  return &host_sd_image[block * 512 + (pos & 0x1FF)];
+}
+
+static void set_fat(const uint16_t cluster, const uint16_t value) {
+  for (uint8_t f = 0; f < 2; f++) {
+    uint8_t* entry = &host_sd_image[(1 + f * FAT_BLOCKS) * 512 + cluster * 2];
+    entry[0] = value & 0xFF;
+    entry[1] = value >> 8;
+  }
+}
+
+static void add_entry(const uint8_t n, const char* name, const uint16_t cluster, const uint32_t size) {
+  dir_t* dir = (dir_t*)&host_sd_image[(1 + 2 * FAT_BLOCKS) * 512] + n;
+  memcpy(dir->name, name, 11);
+  dir->attributes = DIR_ATT_ARCHIVE;
+  dir->creationDate = dir->lastAccessDate = dir->lastWriteDate = FAT_DEFAULT_DATE;
+  dir->creationTime = dir->lastWriteTime = FAT_DEFAULT_TIME;
+  dir->firstClusterLow = cluster;
+  dir->fileSize = size;
+}
+
+// A long name of up to 13 characters, for the short name in the entry after n
+static void add_long_name(const uint8_t n, const char* name, const char* short_name) {
+  vfat_t* vfat = (vfat_t*)&host_sd_image[(1 + 2 * FAT_BLOCKS) * 512] + n;
+  uint16_t chars[13];
+  for (uint8_t i = 0; i < 13; i++) chars[i] = i < strlen(name) ? name[i] : i == strlen(name) ? 0 : 0xFFFF;
+  uint8_t checksum = 0;
+  for (uint8_t i = 0; i < 11; i++) checksum = ((checksum & 1) << 7) + (checksum >> 1) + (uint8_t)short_name[i];
+  vfat->sequenceNumber = 0x41;
+  vfat->attributes = DIR_ATT_LONG_NAME;
+  vfat->checksum = checksum;
+  memcpy(vfat->name1, chars, sizeof(vfat->name1));
+  memcpy(vfat->name2, chars + 5, sizeof(vfat->name2));
+  memcpy(vfat->name3, chars + 11, sizeof(vfat->name3));
+}
+
+static void make_volume() {
+  host_sd_image.assign(VOLUME_BLOCKS * 512, 0);
+
+  fat_boot_t* boot = (fat_boot_t*)&host_sd_image[0];
+  boot->jump[0] = 0xEB; boot->jump[1] = 0x3C; boot->jump[2] = 0x90;
+  memcpy(boot->oemId, "MK4DUE  ", 8);
+  boot->bytesPerSector = 512;
+  boot->sectorsPerCluster = 2;
+  boot->reservedSectorCount = 1;
+  boot->fatCount = 2;
+  boot->rootDirEntryCount = ROOT_ENTRIES;
+  boot->totalSectors16 = VOLUME_BLOCKS;
+  boot->mediaType = 0xF8;
+  boot->sectorsPerFat16 = FAT_BLOCKS;
+  boot->bootSignature = EXTENDED_BOOT_SIG;
+  memcpy(boot->volumeLabel, "NO NAME    ", 11);
+  memcpy(boot->fileSystemType, "FAT16   ", 8);
+  boot->bootSectorSig0 = BOOTSIG0;
+  boot->bootSectorSig1 = BOOTSIG1;
+
+  set_fat(0, 0xFFF8);
+  set_fat(1, 0xFFFF);
+  for (uint8_t i = 0; i < FILE_CLUSTERS; i++)
+    set_fat(file_clusters[i], i + 1 < FILE_CLUSTERS ? file_clusters[i + 1] : 0xFFFF);
+
+  // selectFile() creates restart.gcode when it's missing, the card takes no writes
+  add_long_name(0, "restart.gcode", "RESTAR~1GCO");
+  add_entry(1, "RESTAR~1GCO", 0, 0);
+  add_entry(2, "TEST    GCO", file_clusters[0], FILE_SIZE);
+  for (uint32_t pos = 0; pos < FILE_SIZE; pos++) *image_file_byte(pos) = file_byte(pos);
+}
+
+static void clear_counts() {
+  memset(host_sd_commands, 0, sizeof(host_sd_commands));
+  host_sd_blocks = 0;
+}
+
+// get() n bytes from pos on, false at the first wrong one
+static bool read_check(const uint32_t pos, const uint32_t n) {
+  for (uint32_t i = pos; i < pos + n; i++) {
+    const int16_t c = card.get();
+    if (c != (i < FILE_SIZE ? file_byte(i) : -1)) {
+      printf("get() at %lu is %d, expected %d\n", (unsigned long)i, c, i < FILE_SIZE ? file_byte(i) : -1);
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_open() {
+  host_sd_reset();
+  card.initsd();
+  CHECK_EQUAL(card.cardOK, true);
+  CHECK_EQUAL(host_sd_commands[41], 2);
+  CHECK_EQUAL(card.selectFile("test.gco", true), true);
+  CHECK_EQUAL(card.fileSize, FILE_SIZE);
+}
+
+static void test_sequential() {
+  // The first pass reads the FAT too, the second only the file
+  CHECK_EQUAL(read_check(0, FILE_SIZE + 2), true);
+  CHECK_EQUAL(card.eof(), true);
+
+  card.setIndex(0);
+  clear_counts();
+  CHECK_EQUAL(read_check(0, FILE_SIZE), true);
+  // Block 0 with CMD17, the rest in a CMD18 per run, each run after the
+  // first ends the CMD18 before it, as does the CMD17
+  CHECK_EQUAL(host_sd_commands[17], 1);
+  CHECK_EQUAL(host_sd_commands[18], FILE_RUNS);
+  CHECK_EQUAL(host_sd_commands[12], FILE_RUNS);
+  CHECK_EQUAL(host_sd_blocks, FILE_CLUSTERS * 2);
+  CHECK_EQUAL(card.get(), -1);
+}
+
+static void test_seek() {
+  // Back into the block get() is reading: it's read again, not taken from the buffer
+  card.setIndex(0);
+  CHECK_EQUAL(read_check(0, 100), true);
+  *image_file_byte(50) ^= 0xFF;
+  card.setIndex(50);
+  clear_counts();
+  CHECK_EQUAL(card.get(), file_byte(50) ^ 0xFF);
+  *image_file_byte(50) ^= 0xFF;
+  CHECK_EQUAL(host_sd_commands[17], 1);
+  CHECK_EQUAL(host_sd_commands[12], 1);
+  CHECK_EQUAL(host_sd_commands[18], 1);
+
+  // Into the block read in the background: it's dropped, and finished
+  // before the CMD12 of the new read
+  *image_file_byte(520) ^= 0xFF;
+  card.setIndex(520);
+  clear_counts();
+  CHECK_EQUAL(card.get(), file_byte(520) ^ 0xFF);
+  *image_file_byte(520) ^= 0xFF;
+  CHECK_EQUAL(host_sd_commands[17], 1);
+  CHECK_EQUAL(host_sd_commands[12], 1);
+  CHECK_EQUAL(host_sd_commands[18], 1);
+
+  // Every block and cluster boundary, forwards and backwards
+  static const uint32_t positions[] = { 3000, 511, 2047, 1023, 512, 5119, 4095, 6143, 5000, FILE_SIZE - 1, 0, FILE_SIZE - 700 };
+  for (uint8_t i = 0; i < COUNT(positions); i++) {
+    card.setIndex(positions[i]);
+    CHECK_EQUAL(read_check(positions[i], 1100), true);
+  }
+  card.setIndex(FILE_SIZE);
+  CHECK_EQUAL(card.eof(), true);
+  CHECK_EQUAL(card.get(), -1);
+}
+
+static void test_other_command() {
+  // Another card access during the CMD18 ends it, the block read in the
+  // background is kept and the next one needs a new CMD18
+  card.setIndex(0);
+  CHECK_EQUAL(read_check(0, 600), true);
+  clear_counts();
+  uint8_t block[512];
+  CHECK_EQUAL(card.fat.card()->readBlock(0, block), true);
+  CHECK_EQUAL(block[510], BOOTSIG0);
+  CHECK_EQUAL(host_sd_commands[12], 1);
+  CHECK_EQUAL(host_sd_commands[17], 1);
+  CHECK_EQUAL(read_check(600, 1000), true);
+  CHECK_EQUAL(host_sd_commands[18], 1);
+  CHECK_EQUAL(host_sd_commands[17], 1);
+}
+
+int main() {
+  host_serial_capture = true;   // Keep "SD card ok" and the like out of the output
+  make_volume();
+  test_open();
+  test_sequential();
+  test_seek();
+  test_other_command();
+  if (!host_sd_errors.empty()) {
+    failures++;
+    printf("%s", host_sd_errors.c_str());
+  }
+  printf("sd_stream_test: %d checks, %d failed\n", checks, failures);
+  return failures ? 1 : 0;
+}
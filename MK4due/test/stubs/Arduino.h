@@ -0,0 +1,116 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Host stand-in for the Arduino Due core, enough to build the firmware
+ * sources that don't talk to the hardware themselves. Time only moves
+ * when a test advances host_ticks, counted at HAL_TIMER_RATE.
+ */
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string> // Before the min() and max() macros
+
+#include "sam.h"
+#include "Print.h"
+#include "avr/dtostrf.h"
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint16_t word;
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+
+#define PI            3.1415926535897932384626433832795
+#define DEG_TO_RAD    0.017453292519943295769236907684886
+#define RAD_TO_DEG    57.295779513082320876798154814105
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define radians(deg) ((deg)*DEG_TO_RAD)
+#define degrees(rad) ((rad)*RAD_TO_DEG)
+#define sq(x) ((x)*(x))
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+
+// Virtual time in timer ticks, F_CPU / 2 per second
+extern uint64_t host_ticks;
+
+static inline unsigned long millis() { return host_ticks / (F_CPU / 2000); }
+static inline unsigned long micros() { return host_ticks / (F_CPU / 2000000); }
+void delay(unsigned long ms);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+void analogWrite(uint32_t pin, uint32_t value);
+uint32_t analogRead(uint32_t pin);
+
+// Pin table of the Due variant, filled from fastio.h
+typedef enum { PIO_NOT_A_PIN, PIO_PERIPH_A, PIO_PERIPH_B, PIO_INPUT, PIO_OUTPUT_0, PIO_OUTPUT_1 } EPioType;
+
+typedef struct {
+  Pio* pPort;
+  uint32_t ulPin, ulPeripheralId, ulPinConfiguration;
+} PinDescription;
+
+extern const PinDescription g_APinDescription[];
+
+static inline void pmc_enable_periph_clk(uint32_t) {}
+void PIO_Configure(Pio* pio, EPioType type, uint32_t mask, uint32_t attribute);
+
+typedef enum { ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4, ADC_CHANNEL_5,
+               ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8, ADC_CHANNEL_9, ADC_CHANNEL_10, ADC_CHANNEL_11,
+               ADC_CHANNEL_12, ADC_CHANNEL_13, ADC_CHANNEL_14, ADC_CHANNEL_15 } adc_channel_num_t;
+
+/**
+ * Serial port that writes to the host output, or to a buffer a test
+ * can inspect, and reads what the test put in its input buffer.
+ */
+class HostSerial : public Print {
+  public:
+    void begin(unsigned long) {}
+    void end() {}
+    int available();
+    int read();
+    int peek();
+    void flush() { fflush(stdout); }
+    size_t write(uint8_t c);
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HostSerial Serial, Serial1, Serial2, Serial3, SerialUSB;
+
+#endif // _HOST_ARDUINO_H_
@@ -0,0 +1,3 @@
+#pragma once
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout);
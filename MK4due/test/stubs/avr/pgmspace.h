@@ -0,0 +1,13 @@
+#pragma once
+// Flash and RAM are one address space, as in the Due core
+#include <string.h>
+#include <stdio.h>
+
+#define strcpy_P(dest, src)       strcpy((dest), (src))
+#define strcat_P(dest, src)       strcat((dest), (src))
+#define strstr_P(a, b)            strstr((a), (b))
+#define strlen_P(s)               strlen((const char*)(s))
+#define strcmp_P(a, b)            strcmp((a), (b))
+#define memcpy_P(dest, src, num)  memcpy((dest), (src), (num))
+#define sprintf_P(s, ...)         sprintf((s), __VA_ARGS__)
+#define pgm_read_float_near(addr) (*(const float*)(addr))
@@ -0,0 +1,245 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Host implementation of the Arduino core and of the HAL functions in
+ * src/HAL/HAL.cpp, for the tests in this folder.
+ *
+ * The timer interrupts the firmware starts are run by host_run_until(),
+ * each at the time its channel's TC_RC sets, in virtual time. A pending
+ * PendSV runs right after the interrupt or the code that requested it.
+ */
+
+#include "../../base.h"
+#include "host_hal.h"
+
+uint64_t host_ticks = 0;
+uint32_t host_primask = 0;
+
+Pio host_pio[4];
+Tc host_tc[3];
+Adc host_adc;
+SCB_Type host_scb;
+DWT_Type host_dwt;
+
+host_pio_hook_t host_pio_hook = NULL;
+const char* host_isr = NULL;
+
+// Pins as in fastio.h, the table of the Due variant has the same order
+#define HOST_PIN(N) { DIO ## N ## _PORT, DIO ## N ## _PIN, 0, 0 }
+const PinDescription g_APinDescription[] = {
+  HOST_PIN(0),  HOST_PIN(1),  HOST_PIN(2),  HOST_PIN(3),  HOST_PIN(4),  HOST_PIN(5),  HOST_PIN(6),  HOST_PIN(7),
+  HOST_PIN(8),  HOST_PIN(9),  HOST_PIN(10), HOST_PIN(11), HOST_PIN(12), HOST_PIN(13), HOST_PIN(14), HOST_PIN(15),
+  HOST_PIN(16), HOST_PIN(17), HOST_PIN(18), HOST_PIN(19), HOST_PIN(20), HOST_PIN(21), HOST_PIN(22), HOST_PIN(23),
+  HOST_PIN(24), HOST_PIN(25), HOST_PIN(26), HOST_PIN(27), HOST_PIN(28), HOST_PIN(29), HOST_PIN(30), HOST_PIN(31),
+  HOST_PIN(32), HOST_PIN(33), HOST_PIN(34), HOST_PIN(35), HOST_PIN(36), HOST_PIN(37), HOST_PIN(38), HOST_PIN(39),
+  HOST_PIN(40), HOST_PIN(41), HOST_PIN(42), HOST_PIN(43), HOST_PIN(44), HOST_PIN(45), HOST_PIN(46), HOST_PIN(47),
+  HOST_PIN(48), HOST_PIN(49), HOST_PIN(50), HOST_PIN(51), HOST_PIN(52), HOST_PIN(53), HOST_PIN(54), HOST_PIN(55),
+  HOST_PIN(56), HOST_PIN(57), HOST_PIN(58), HOST_PIN(59), HOST_PIN(60), HOST_PIN(61), HOST_PIN(62), HOST_PIN(63),
+  HOST_PIN(64), HOST_PIN(65), HOST_PIN(66), HOST_PIN(67), HOST_PIN(68), HOST_PIN(69), HOST_PIN(70), HOST_PIN(71),
+  HOST_PIN(72), HOST_PIN(73), HOST_PIN(74), HOST_PIN(75), HOST_PIN(76), HOST_PIN(77), HOST_PIN(78), HOST_PIN(79),
+  { PIOB, DIO80_PIN, 0, 0 }, HOST_PIN(81), HOST_PIN(82), HOST_PIN(83), HOST_PIN(84), HOST_PIN(85), HOST_PIN(86), HOST_PIN(87),
+  HOST_PIN(88), HOST_PIN(89), HOST_PIN(90), HOST_PIN(91)
+  #if MB(ALLIGATOR)
+    , HOST_PIN(92), HOST_PIN(93), HOST_PIN(94), HOST_PIN(95), HOST_PIN(96), HOST_PIN(97), HOST_PIN(98), HOST_PIN(99), HOST_PIN(100)
+  #endif
+};
+
+void host_pio_write(Pio* pio, uint32_t mask, bool set) {
+  if (host_pio_hook) host_pio_hook(pio, mask, set);
+}
+
+void PIO_Configure(Pio*, EPioType, uint32_t, uint32_t) {}
+void pinMode(uint32_t, uint32_t) {}
+void digitalWrite(uint32_t pin, uint32_t value) { WRITE_VAR(pin, value); }
+int digitalRead(uint32_t pin) { return READ_VAR(pin); }
+void analogWrite(uint32_t, uint32_t) {}
+uint32_t analogRead(uint32_t) { return 0; }
+void delay(unsigned long ms) { host_run_until(host_ticks + ms * (HAL_TIMER_RATE / 1000)); }
+
+void cli() { host_primask = 1; }
+void sei() { host_primask = 0; }
+
+/**
+ * Serial
+ */
+HostSerial Serial, Serial1, Serial2, Serial3, SerialUSB;
+
+std::string host_serial_in, host_serial_out;
+bool host_serial_capture = false;
+
+int HostSerial::available() { return host_serial_in.size(); }
+int HostSerial::peek() { return host_serial_in.empty() ? -1 : (uint8_t)host_serial_in[0]; }
+int HostSerial::read() {
+  const int c = peek();
+  if (c >= 0) host_serial_in.erase(0, 1);
+  return c;
+}
+size_t HostSerial::write(uint8_t c) {
+  if (host_serial_capture) host_serial_out += (char)c;
+  else if (c != '\r') putchar(c);
+  return 1;
+}
+
+char* dtostrf(double val, signed char width, unsigned char prec, char* sout) {
+  sprintf(sout, "%*.*f", width, prec, val);
+  return sout;
+}
+
+size_t Print::print(long n) { char buf[24]; snprintf(buf, sizeof(buf), "%ld", n); return write(buf); }
+size_t Print::print(unsigned long n) { char buf[24]; snprintf(buf, sizeof(buf), "%lu", n); return write(buf); }
+size_t Print::print(double n, int digits) { char buf[48]; snprintf(buf, sizeof(buf), "%.*f", digits, n); return write(buf); }
+
+/**
+ * Timers
+ */
+TcChannel* stepperChannel = &STEP_TIMER_COUNTER->TC_CHANNEL[STEP_TIMER_CHANNEL];
+#if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
+  TcChannel* extruderChannel = &ADVANCE_EXTRUDER_TIMER_COUNTER->TC_CHANNEL[ADVANCE_EXTRUDER_TIMER_CHANNEL];
+#endif
+#if ENABLED(INPUT_SHAPING)
+  TcChannel* shapingChannel = &SHAPING_TIMER_COUNTER->TC_CHANNEL[SHAPING_TIMER_CHANNEL];
+#endif
+
+// The handlers of the features that are enabled
+extern "C" {
+  void TC1_Handler() __attribute__((weak));
+  void TC2_Handler() __attribute__((weak));
+  void TC6_Handler() __attribute__((weak));
+  void PendSV_Handler() __attribute__((weak));
+}
+
+typedef struct {
+  TcChannel* channel;
+  void (*isr)();
+  const char* name;
+  bool enabled;
+  uint64_t next;
+} host_timer_t;
+
+static host_timer_t host_timers[] = {
+  { &ADVANCE_EXTRUDER_TIMER_COUNTER->TC_CHANNEL[ADVANCE_EXTRUDER_TIMER_CHANNEL], TC1_Handler, "advance", false, 0 },
+  { &STEP_TIMER_COUNTER->TC_CHANNEL[STEP_TIMER_CHANNEL], TC2_Handler, "stepper", false, 0 },
+  { &SHAPING_TIMER_COUNTER->TC_CHANNEL[SHAPING_TIMER_CHANNEL], TC6_Handler, "shaping", false, 0 }
+};
+
+static host_timer_t* host_timer(uint8_t timer_num) {
+  switch (timer_num) {
+    case ADVANCE_EXTRUDER_TIMER_NUM: return &host_timers[0];
+    case STEP_TIMER_NUM: return &host_timers[1];
+    case SHAPING_TIMER_NUM: return &host_timers[2];
+  }
+  return NULL;
+}
+
+void HAL_timer_enable_interrupt(uint8_t timer_num) {
+  host_timer_t* t = host_timer(timer_num);
+  if (!t || t->enabled || !t->isr) return;
+  t->enabled = true;
+  t->next = host_ticks + t->channel->TC_RC;
+}
+
+void HAL_timer_disable_interrupt(uint8_t timer_num) {
+  host_timer_t* t = host_timer(timer_num);
+  if (t) t->enabled = false;
+}
+
+int HAL_timer_get_count(uint8_t timer_num) {
+  host_timer_t* t = host_timer(timer_num);
+  return t ? t->channel->TC_RC : 0;
+}
+
+void HAL_step_timer_start() {
+  stepperChannel->TC_RC = HAL_TIMER_RATE / STEP_FREQUENCY;
+  HAL_timer_enable_interrupt(STEP_TIMER_NUM);
+}
+
+void HAL_temp_timer_start(uint8_t) {}
+
+#if ENABLED(ADVANCE) || ENABLED(LIN_ADVANCE)
+  void HAL_advance_extruder_timer_start() {
+    extruderChannel->TC_RC = HAL_TIMER_RATE / ADVANCE_EXTRUDER_FREQUENCY;
+    HAL_timer_enable_interrupt(ADVANCE_EXTRUDER_TIMER_NUM);
+  }
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+  void HAL_shaping_timer_start() {
+    shapingChannel->TC_RC = HAL_TIMER_RATE / (SHAPING_ISR_FREQUENCY);
+    HAL_timer_enable_interrupt(SHAPING_TIMER_NUM);
+  }
+#endif
+
+#if ENABLED(BLOCK_PREPARATION_ISR)
+  void HAL_block_prep_start() {}
+#endif
+
+#if ENABLED(STEP_EVENT_QUEUE)
+  void HAL_step_queue_start() {}
+#endif
+
+void host_pendsv() {
+  if (!(SCB->ICSR & SCB_ICSR_PENDSVSET_Msk)) return;
+  SCB->ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+  if (PendSV_Handler) {
+    const char* const prev = host_isr;
+    host_isr = "pendsv";
+    PendSV_Handler();
+    host_isr = prev;
+  }
+}
+
+bool host_run_until(uint64_t ticks) {
+  host_pendsv();
+  for (;;) {
+    host_timer_t* due = NULL;
+    for (uint8_t i = 0; i < COUNT(host_timers); i++) {
+      host_timer_t &t = host_timers[i];
+      if (t.enabled && t.next <= ticks && (!due || t.next < due->next)) due = &t;
+    }
+    if (!due) break;
+
+    // The counter restarts at the compare, as with TC_CMR_WAVSEL_UP_RC
+    host_ticks = due->next;
+    due->channel->TC_CV = 0;
+    host_isr = due->name;
+    due->isr();
+    host_isr = NULL;
+    due->next = host_ticks + max(due->channel->TC_RC, (uint32_t)1);
+    host_pendsv();
+  }
+  if (host_ticks < ticks) host_ticks = ticks;
+  return true;
+}
+
+uint64_t host_next_interrupt() {
+  uint64_t next = UINT64_MAX;
+  for (uint8_t i = 0; i < COUNT(host_timers); i++)
+    if (host_timers[i].enabled) NOMORE(next, host_timers[i].next);
+  return next;
+}
+
+void host_run_next() {
+  host_pendsv();
+  const uint64_t next = host_next_interrupt();
+  if (next != UINT64_MAX) host_run_until(next);
+}
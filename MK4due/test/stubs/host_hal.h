@@ -0,0 +1,53 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Control of the host HAL by the tests
+ */
+
+#ifndef _HOST_HAL_H_
+#define _HOST_HAL_H_
+
+#include <string>
+
+// Called with the pins that changed on every PIO_SODR/PIO_CODR write
+typedef void (*host_pio_hook_t)(Pio* pio, uint32_t mask, bool set);
+extern host_pio_hook_t host_pio_hook;
+
+// Name of the interrupt handler that is running, NULL for the main code
+extern const char* host_isr;
+
+// Serial input for the firmware, and its output when host_serial_capture is set
+extern std::string host_serial_in, host_serial_out;
+extern bool host_serial_capture;
+
+// Run the timer interrupts that are due up to ticks, and move the time there
+bool host_run_until(uint64_t ticks);
+
+// Run the next timer interrupt, if any is enabled
+void host_run_next();
+uint64_t host_next_interrupt();
+
+// Run PendSV if it was requested
+void host_pendsv();
+
+#endif // _HOST_HAL_H_
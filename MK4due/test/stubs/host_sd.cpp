@@ -0,0 +1,245 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Fake SD card behind the HAL::spi* functions, see host_sd.h
+ */
+
+// The standard headers first, Arduino.h defines min() and max()
+#include <deque>
+#include "host_sd.h"
+#include "../../base.h"
+
+std::vector<uint8_t> host_sd_image;
+uint32_t host_sd_commands[64], host_sd_blocks;
+std::string host_sd_errors;
+
+static bool sd_idle,            // CMD0 received, ACMD41 not yet
+            sd_app_cmd,         // CMD55 received, the next command is an ACMD
+            sd_reading;         // CMD18 open, blocks are sent until CMD12
+static uint32_t sd_read_block;  // Next block of the multi-block read
+static uint8_t sd_frame[6], sd_frame_len;
+static std::deque<uint8_t> sd_out;  // Bytes the card sends next, 0xFF when empty
+
+static uint8_t* sd_dma_buf = NULL;  // Pending spiDmaReadStart()
+static uint16_t sd_dma_len;
+
+static void sd_error(const char* msg, const uint32_t arg) {
+  char line[80];
+  snprintf(line, sizeof(line), "%s %lu\n", msg, (unsigned long)arg);
+  host_sd_errors += line;
+}
+
+static bool sd_selected() {
+  return !(g_APinDescription[SDSS].pPort->PIO_ODSR & g_APinDescription[SDSS].ulPin);
+}
+
+static uint16_t sd_crc16(const uint8_t* data, const uint16_t n) {
+  uint16_t crc = 0;
+  for (uint16_t i = 0; i < n; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (uint8_t b = 0; b < 8; b++) crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+// Start token, data and CRC, after one byte of access time
+static void sd_queue_data(const uint8_t* data, const uint16_t n) {
+  const uint16_t crc = sd_crc16(data, n);
+  sd_out.push_back(0xFF);
+  sd_out.push_back(0xFE);
+  sd_out.insert(sd_out.end(), data, data + n);
+  sd_out.push_back(crc >> 8);
+  sd_out.push_back(crc & 0xFF);
+}
+
+static void sd_queue_block(const uint32_t block) {
+  if ((uint64_t)(block + 1) * 512 > host_sd_image.size()) {
+    sd_error("read past the image, block", block);
+    sd_out.push_back(0x08);   // Data error token: out of range
+    return;
+  }
+  host_sd_blocks++;
+  sd_queue_data(&host_sd_image[block * 512], 512);
+}
+
+static void sd_command() {
+  const uint8_t cmd = sd_frame[0] & 0x3F;
+  const uint32_t arg = ((uint32_t)sd_frame[1] << 24) | ((uint32_t)sd_frame[2] << 16) | ((uint32_t)sd_frame[3] << 8) | sd_frame[4];
+  const bool app_cmd = sd_app_cmd;
+  sd_app_cmd = false;
+  host_sd_commands[cmd]++;
+
+  if (sd_reading && cmd != 12) sd_error("command during a multi-block read, CMD", cmd);
+
+  // The remaining answer to the previous command is dropped
+  sd_out.clear();
+  sd_out.push_back(0xFF);
+  uint8_t r1 = sd_idle ? 0x01 : 0x00;
+
+  switch (cmd) {
+    case 0:   // GO_IDLE_STATE
+      sd_idle = true;
+      sd_reading = false;
+      sd_out.push_back(0x01);
+      break;
+    case 8:   // SEND_IF_COND, version 2 card
+      sd_out.push_back(r1);
+      sd_out.push_back(0x00);
+      sd_out.push_back(0x00);
+      sd_out.push_back(arg >> 8 & 0x0F);
+      sd_out.push_back(arg & 0xFF);
+      break;
+    case 9:   // SEND_CSD, version 2 with the size of the image
+    case 10:  // SEND_CID
+      {
+        uint8_t reg[16] = { 0 };
+        if (cmd == 9) {
+          const uint32_t c_size = host_sd_image.size() / (512 * 1024) - 1;
+          reg[0] = 0x40;
+          reg[7] = c_size >> 16 & 0x3F;
+          reg[8] = c_size >> 8 & 0xFF;
+          reg[9] = c_size & 0xFF;
+        }
+        sd_out.push_back(r1);
+        sd_queue_data(reg, 16);
+      }
+      break;
+    case 12:  // STOP_TRANSMISSION: stuff byte, R1, then busy for a byte
+      if (!sd_reading) sd_error("CMD12 without a multi-block read, arg", arg);
+      sd_reading = false;
+      sd_out.push_back(r1);
+      sd_out.push_back(0x00);
+      break;
+    case 13:  // SEND_STATUS
+      sd_out.push_back(r1);
+      sd_out.push_back(0x00);
+      break;
+    case 17:  // READ_SINGLE_BLOCK
+      sd_out.push_back(r1);
+      sd_queue_block(arg);
+      break;
+    case 18:  // READ_MULTIPLE_BLOCK, the blocks follow as they are read
+      sd_out.push_back(r1);
+      sd_reading = true;
+      sd_read_block = arg;
+      break;
+    case 41:  // SD_SEND_OP_COND, an ACMD, ready on the second try
+      if (!app_cmd) sd_error("CMD41 without CMD55, arg", arg);
+      sd_idle = host_sd_commands[41] < 2;
+      sd_out.push_back(sd_idle ? 0x01 : 0x00);
+      break;
+    case 55:  // APP_CMD
+      sd_app_cmd = true;
+      sd_out.push_back(r1);
+      break;
+    case 58:  // READ_OCR: powered up, CCS set
+      sd_out.push_back(r1);
+      sd_out.push_back(0xC0);
+      sd_out.push_back(0xFF);
+      sd_out.push_back(0x80);
+      sd_out.push_back(0x00);
+      break;
+    case 59:  // CRC_ON_OFF
+      sd_out.push_back(r1);
+      break;
+    default:
+      sd_error("unsupported command, CMD", cmd);
+      sd_out.push_back(r1 | 0x04);  // Illegal command
+  }
+}
+
+void host_sd_reset() {
+  sd_idle = true;
+  sd_app_cmd = sd_reading = false;
+  sd_frame_len = 0;
+  sd_out.clear();
+  sd_dma_buf = NULL;
+  memset(host_sd_commands, 0, sizeof(host_sd_commands));
+  host_sd_blocks = 0;
+  host_sd_errors.clear();
+}
+
+static void sd_send(const uint8_t b) {
+  if (sd_dma_buf) sd_error("byte sent during a DMA read, value", b);
+  if (!sd_selected()) {
+    sd_frame_len = 0;
+    return;
+  }
+  // Commands start with 01 in the top bits, the host clocks 0xFF in between
+  if (sd_frame_len == 0 && (b & 0xC0) != 0x40) return;
+  sd_frame[sd_frame_len++] = b;
+  if (sd_frame_len == 6) {
+    sd_frame_len = 0;
+    sd_command();
+  }
+}
+
+static uint8_t sd_receive() {
+  if (!sd_selected()) return 0xFF;
+  if (sd_out.empty() && sd_reading) sd_queue_block(sd_read_block++);
+  if (sd_out.empty()) return 0xFF;
+  const uint8_t b = sd_out.front();
+  sd_out.pop_front();
+  return b;
+}
+
+void HAL::spiBegin() {}
+void HAL::spiInit(uint8_t) {}
+
+void HAL::spiSend(byte b) { sd_send(b); }
+void HAL::spiSend(const uint8_t* buf, size_t n) { while (n--) sd_send(*buf++); }
+
+uint8_t HAL::spiReceive() {
+  if (sd_dma_buf) sd_error("byte read during a DMA read, selected", sd_selected());
+  return sd_receive();
+}
+
+void HAL::spiReadBlock(uint8_t* buf, uint16_t nbyte) { while (nbyte--) *buf++ = spiReceive(); }
+
+void HAL::spiSendBlock(uint8_t token, const uint8_t* buf) {
+  sd_send(token);
+  spiSend(buf, 512);
+}
+
+// The transfer runs when it is waited for, the data is the same
+void (*HAL::spiDmaRelease)() = NULL;
+
+void HAL::spiDmaReadStart(uint8_t* buf, uint16_t nbyte) {
+  if (sd_dma_buf) sd_error("DMA read started over another, bytes", nbyte);
+  if (!sd_selected()) sd_error("DMA read with the card not selected, bytes", nbyte);
+  sd_dma_buf = buf;
+  sd_dma_len = nbyte;
+}
+
+void HAL::spiDmaSendStart(const uint8_t* buf, uint16_t nbyte) { spiSend(buf, nbyte); }
+
+bool HAL::spiDmaBusy() { return false; }
+
+bool HAL::spiDmaFinish() {
+  if (!sd_dma_buf) return true;
+  if (!sd_selected()) sd_error("card deselected during a DMA read, bytes", sd_dma_len);
+  uint8_t* buf = sd_dma_buf;
+  sd_dma_buf = NULL;
+  while (sd_dma_len--) *buf++ = sd_receive();
+  return true;
+}
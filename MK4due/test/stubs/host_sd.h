@@ -0,0 +1,58 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Fake SD card on the SPI bus of the host HAL
+ *
+ * host_sd.cpp implements the HAL::spi* functions of the SD channel with
+ * a card in SPI mode that answers the commands from a memory image: an
+ * SDHC card, so blocks are addressed by number, with data CRCs. CMD18
+ * sends the following blocks for as long as the firmware reads, until
+ * CMD12. Chip select is the SDSS pin, bytes clocked with it high are
+ * ignored as on a real bus.
+ *
+ * The card counts what it was asked for, and collects the commands
+ * that break the protocol in host_sd_errors: a command other than CMD12
+ * during a multi-block read, byte transfers while a DMA read is running,
+ * reads past the image.
+ */
+
+#ifndef _HOST_SD_H_
+#define _HOST_SD_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Card contents, a multiple of 512 bytes
+extern std::vector<uint8_t> host_sd_image;
+
+// Commands received by index (ACMD41 counts as 41), data blocks sent
+extern uint32_t host_sd_commands[64], host_sd_blocks;
+
+// Protocol violations, one per line
+extern std::string host_sd_errors;
+
+// Power the card up again and clear the counts
+void host_sd_reset();
+
+#endif // _HOST_SD_H_
@@ -0,0 +1,139 @@
+/**
+ * MK & MK4due 3D Printer Firmware
+ *
+ * Based on Marlin, Sprinter and grbl
+ * Copyright (C) 2011 Camiel Gubbels / Erik van der Zalm
+ * Copyright (C) 2013 - 2016 Alberto Cotronei @MagoKimbra
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/**
+ * Fake SAM3X8E peripherals for host builds of the firmware sources.
+ *
+ * Only the registers the firmware touches outside HAL.cpp exist. They
+ * are plain memory, except PIO_SODR and PIO_CODR: writing them updates
+ * PIO_ODSR and reports the pins that changed to host_pio_write(), so a
+ * test can see the step pulses. The timer counters don't run by
+ * themselves, the test sets TC_CV and calls the interrupt handlers.
+ */
+
+#ifndef _HOST_SAM_H_
+#define _HOST_SAM_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef volatile const uint32_t RoReg;
+typedef volatile uint32_t       RwReg;
+typedef volatile uint32_t       WoReg;
+
+struct Pio;
+
+// Called for every write to PIO_SODR (set = true) or PIO_CODR of a fake PIO
+void host_pio_write(Pio* pio, uint32_t mask, bool set);
+
+template<bool SET> struct HostPioSetClear {
+  inline HostPioSetClear& operator=(uint32_t mask);
+};
+
+struct Pio {
+  RwReg PIO_PER, PIO_PDR, PIO_PSR, PIO_OER, PIO_ODR, PIO_OSR,
+        PIO_IER, PIO_IDR, PIO_IMR, PIO_ISR, PIO_PUER, PIO_PUDR, PIO_PUSR,
+        PIO_ABSR, PIO_OWER, PIO_OWDR, PIO_OWSR;
+  HostPioSetClear<true> PIO_SODR;
+  HostPioSetClear<false> PIO_CODR;
+  RwReg PIO_ODSR, PIO_PDSR;
+};
+
+template<bool SET> inline HostPioSetClear<SET>& HostPioSetClear<SET>::operator=(uint32_t mask) {
+  Pio* pio = (Pio*)((char*)this - (SET ? offsetof(Pio, PIO_SODR) : offsetof(Pio, PIO_CODR)));
+  if (SET) pio->PIO_ODSR |= mask; else pio->PIO_ODSR &= ~mask;
+  host_pio_write(pio, mask, SET);
+  return *this;
+}
+
+typedef struct {
+  RwReg TC_CCR, TC_CMR, TC_SMMR, Reserved1, TC_CV, TC_RA, TC_RB, TC_RC,
+        TC_SR, TC_IER, TC_IDR, TC_IMR;
+} TcChannel;
+
+typedef struct {
+  TcChannel TC_CHANNEL[3];
+} Tc;
+
+typedef struct {
+  RwReg ADC_CR, ADC_MR, ADC_CHER, ADC_CHDR, ADC_CHSR, ADC_LCDR, ADC_IER, ADC_IDR,
+        ADC_IMR, ADC_ISR, ADC_CDR[16], ADC_RPR, ADC_RCR, ADC_RNPR, ADC_RNCR, ADC_PTCR;
+} Adc;
+
+typedef struct {
+  RwReg ICSR, SHPR[3];
+} SCB_Type;
+
+typedef struct {
+  RwReg CTRL, CYCCNT;
+} DWT_Type;
+
+typedef enum IRQn {
+  PendSV_IRQn = -2,
+  SysTick_IRQn = -1,
+  SPI0_IRQn = 24,
+  TC0_IRQn = 27, TC1_IRQn, TC2_IRQn, TC3_IRQn, TC4_IRQn, TC5_IRQn, TC6_IRQn, TC7_IRQn, TC8_IRQn,
+  ADC_IRQn = 37
+} IRQn_Type;
+
+#define SCB_ICSR_PENDSVSET_Msk (1u << 28)
+
+// The handlers have C linkage, as in the CMSIS headers
+extern "C" {
+  void PendSV_Handler();
+  void TC0_Handler(); void TC1_Handler(); void TC2_Handler(); void TC3_Handler(); void TC4_Handler();
+  void TC5_Handler(); void TC6_Handler(); void TC7_Handler(); void TC8_Handler();
+  void ADC_Handler();
+}
+
+extern Pio host_pio[4];
+extern Tc host_tc[3];
+extern Adc host_adc;
+extern SCB_Type host_scb;
+extern DWT_Type host_dwt;
+
+#define PIOA  (&host_pio[0])
+#define PIOB  (&host_pio[1])
+#define PIOC  (&host_pio[2])
+#define PIOD  (&host_pio[3])
+#define TC0   (&host_tc[0])
+#define TC1   (&host_tc[1])
+#define TC2   (&host_tc[2])
+#define ADC   (&host_adc)
+#define SCB   (&host_scb)
+#define DWT   (&host_dwt)
+
+// Interrupts are never masked on the host, the handlers are called by the test
+extern uint32_t host_primask;
+static inline uint32_t __get_PRIMASK() { return host_primask; }
+static inline void __disable_irq() { host_primask = 1; }
+static inline void __enable_irq() { host_primask = 0; }
+static inline void __DSB() {}
+static inline void __ISB() {}
+static inline void __DMB() {}
+
+static inline void NVIC_SetPriority(IRQn_Type, uint32_t) {}
+static inline void NVIC_EnableIRQ(IRQn_Type) {}
+static inline void NVIC_DisableIRQ(IRQn_Type) {}
+static inline void NVIC_ClearPendingIRQ(IRQn_Type) {}
+
+#endif // _HOST_SAM_H_
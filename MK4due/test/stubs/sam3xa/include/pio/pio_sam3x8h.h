@@ -0,0 +1,193 @@
+/**
+ * PIO pin masks of the SAM3X8E used by src/HAL/fastio.h, for host builds
+ */
+
+#ifndef _HOST_PIO_SAM3X8H_
+#define _HOST_PIO_SAM3X8H_
+
+#define PIO_PA0  (1u << 0)
+#define PIO_PA1  (1u << 1)
+#define PIO_PA2  (1u << 2)
+#define PIO_PA3  (1u << 3)
+#define PIO_PA4  (1u << 4)
+#define PIO_PA5  (1u << 5)
+#define PIO_PA6  (1u << 6)
+#define PIO_PA7  (1u << 7)
+#define PIO_PA8  (1u << 8)
+#define PIO_PA9  (1u << 9)
+#define PIO_PA10 (1u << 10)
+#define PIO_PA11 (1u << 11)
+#define PIO_PA12 (1u << 12)
+#define PIO_PA13 (1u << 13)
+#define PIO_PA14 (1u << 14)
+#define PIO_PA15 (1u << 15)
+#define PIO_PA16 (1u << 16)
+#define PIO_PA17 (1u << 17)
+#define PIO_PA18 (1u << 18)
+#define PIO_PA19 (1u << 19)
+#define PIO_PA20 (1u << 20)
+#define PIO_PA21 (1u << 21)
+#define PIO_PA22 (1u << 22)
+#define PIO_PA23 (1u << 23)
+#define PIO_PA24 (1u << 24)
+#define PIO_PA25 (1u << 25)
+#define PIO_PA26 (1u << 26)
+#define PIO_PA27 (1u << 27)
+#define PIO_PA28 (1u << 28)
+#define PIO_PA29 (1u << 29)
+#define PIO_PA30 (1u << 30)
+#define PIO_PA31 (1u << 31)
+
+#define PIO_PB0  (1u << 0)
+#define PIO_PB1  (1u << 1)
+#define PIO_PB2  (1u << 2)
+#define PIO_PB3  (1u << 3)
+#define PIO_PB4  (1u << 4)
+#define PIO_PB5  (1u << 5)
+#define PIO_PB6  (1u << 6)
+#define PIO_PB7  (1u << 7)
+#define PIO_PB8  (1u << 8)
+#define PIO_PB9  (1u << 9)
+#define PIO_PB10 (1u << 10)
+#define PIO_PB11 (1u << 11)
+#define PIO_PB12 (1u << 12)
+#define PIO_PB13 (1u << 13)
+#define PIO_PB14 (1u << 14)
+#define PIO_PB15 (1u << 15)
+#define PIO_PB16 (1u << 16)
+#define PIO_PB17 (1u << 17)
+#define PIO_PB18 (1u << 18)
+#define PIO_PB19 (1u << 19)
+#define PIO_PB20 (1u << 20)
+#define PIO_PB21 (1u << 21)
+#define PIO_PB22 (1u << 22)
+#define PIO_PB23 (1u << 23)
+#define PIO_PB24 (1u << 24)
+#define PIO_PB25 (1u << 25)
+#define PIO_PB26 (1u << 26)
+#define PIO_PB27 (1u << 27)
+#define PIO_PB28 (1u << 28)
+#define PIO_PB29 (1u << 29)
+#define PIO_PB30 (1u << 30)
+#define PIO_PB31 (1u << 31)
+
+#define PIO_PC0  (1u << 0)
+#define PIO_PC1  (1u << 1)
+#define PIO_PC2  (1u << 2)
+#define PIO_PC3  (1u << 3)
+#define PIO_PC4  (1u << 4)
+#define PIO_PC5  (1u << 5)
+#define PIO_PC6  (1u << 6)
+#define PIO_PC7  (1u << 7)
+#define PIO_PC8  (1u << 8)
+#define PIO_PC9  (1u << 9)
+#define PIO_PC10 (1u << 10)
+#define PIO_PC11 (1u << 11)
+#define PIO_PC12 (1u << 12)
+#define PIO_PC13 (1u << 13)
+#define PIO_PC14 (1u << 14)
+#define PIO_PC15 (1u << 15)
+#define PIO_PC16 (1u << 16)
+#define PIO_PC17 (1u << 17)
+#define PIO_PC18 (1u << 18)
+#define PIO_PC19 (1u << 19)
+#define PIO_PC20 (1u << 20)
+#define PIO_PC21 (1u << 21)
+#define PIO_PC22 (1u << 22)
+#define PIO_PC23 (1u << 23)
+#define PIO_PC24 (1u << 24)
+#define PIO_PC25 (1u << 25)
+#define PIO_PC26 (1u << 26)
+#define PIO_PC27 (1u << 27)
+#define PIO_PC28 (1u << 28)
+#define PIO_PC29 (1u << 29)
+#define PIO_PC30 (1u << 30)
+#define PIO_PC31 (1u << 31)
+
+#define PIO_PD0  (1u << 0)
+#define PIO_PD1  (1u << 1)
+#define PIO_PD2  (1u << 2)
+#define PIO_PD3  (1u << 3)
+#define PIO_PD4  (1u << 4)
+#define PIO_PD5  (1u << 5)
+#define PIO_PD6  (1u << 6)
+#define PIO_PD7  (1u << 7)
+#define PIO_PD8  (1u << 8)
+#define PIO_PD9  (1u << 9)
+#define PIO_PD10 (1u << 10)
+#define PIO_PD11 (1u << 11)
+#define PIO_PD12 (1u << 12)
+#define PIO_PD13 (1u << 13)
+#define PIO_PD14 (1u << 14)
+#define PIO_PD15 (1u << 15)
+#define PIO_PD16 (1u << 16)
+#define PIO_PD17 (1u << 17)
+#define PIO_PD18 (1u << 18)
+#define PIO_PD19 (1u << 19)
+#define PIO_PD20 (1u << 20)
+#define PIO_PD21 (1u << 21)
+#define PIO_PD22 (1u << 22)
+#define PIO_PD23 (1u << 23)
+#define PIO_PD24 (1u << 24)
+#define PIO_PD25 (1u << 25)
+#define PIO_PD26 (1u << 26)
+#define PIO_PD27 (1u << 27)
+#define PIO_PD28 (1u << 28)
+#define PIO_PD29 (1u << 29)
+#define PIO_PD30 (1u << 30)
+#define PIO_PD31 (1u << 31)
+
+#define PIO_PA0A_CANTX0        PIO_PA0
+#define PIO_PA10A_RXD0         PIO_PA10
+#define PIO_PA11A_TXD0         PIO_PA11
+#define PIO_PA12A_RXD1         PIO_PA12
+#define PIO_PA13A_TXD1         PIO_PA13
+#define PIO_PA16X1_AD7         PIO_PA16
+#define PIO_PA17A_TWD0         PIO_PA17
+#define PIO_PA18A_TWCK0        PIO_PA18
+#define PIO_PA1A_CANRX0        PIO_PA1
+#define PIO_PA22X1_AD4         PIO_PA22
+#define PIO_PA23X1_AD5         PIO_PA23
+#define PIO_PA24X1_AD6         PIO_PA24
+#define PIO_PA25A_SPI0_MISO    PIO_PA25
+#define PIO_PA26A_SPI0_MOSI    PIO_PA26
+#define PIO_PA27A_SPI0_SPCK    PIO_PA27
+#define PIO_PA28A_SPI0_NPCS0   PIO_PA28
+#define PIO_PA29A_SPI0_NPCS1   PIO_PA29
+#define PIO_PA2X1_AD0          PIO_PA2
+#define PIO_PA3X1_AD1          PIO_PA3
+#define PIO_PA4X1_AD2          PIO_PA4
+#define PIO_PA6X1_AD3          PIO_PA6
+#define PIO_PA8A_URXD          PIO_PA8
+#define PIO_PA9A_UTXD          PIO_PA9
+#define PIO_PB10A_UOTGVBOF     PIO_PB10
+#define PIO_PB11A_UOTGID       PIO_PB11
+#define PIO_PB12A_TWD1         PIO_PB12
+#define PIO_PB12X1_AD8         PIO_PB12
+#define PIO_PB13A_TWCK1        PIO_PB13
+#define PIO_PB14A_CANTX1       PIO_PB14
+#define PIO_PB15A_CANRX1       PIO_PB15
+#define PIO_PB15X1_DAC0        PIO_PB15
+#define PIO_PB16X1_DAC1        PIO_PB16
+#define PIO_PB17X1_AD10        PIO_PB17
+#define PIO_PB18X1_AD11        PIO_PB18
+#define PIO_PB19X1_AD12        PIO_PB19
+#define PIO_PB20X1_AD13        PIO_PB20
+#define PIO_PB21B_SPI0_NPCS2   PIO_PB21
+#define PIO_PB23B_SPI0_NPCS3   PIO_PB23
+#define PIO_PB25B_TIOA0        PIO_PB25
+#define PIO_PB27B_TIOB0        PIO_PB27
+#define PIO_PC21B_PWML4        PIO_PC21
+#define PIO_PC22B_PWML5        PIO_PC22
+#define PIO_PC23B_PWML6        PIO_PC23
+#define PIO_PC24B_PWML7        PIO_PC24
+#define PIO_PC25B_TIOA6        PIO_PC25
+#define PIO_PC26B_TIOB6        PIO_PC26
+#define PIO_PC28B_TIOA7        PIO_PC28
+#define PIO_PC29B_TIOB7        PIO_PC29
+#define PIO_PD4B_TXD3          PIO_PD4
+#define PIO_PD5B_RXD3          PIO_PD5
+#define PIO_PD7B_TIOA8         PIO_PD7
+#define PIO_PD8B_TIOB8         PIO_PD8
+
+#endif // _HOST_PIO_SAM3X8H_